@@ -0,0 +1,115 @@
+# Usage:
+# cmake -P GenerateKeysyms.cmake <path/to/keysyms.h.in> <path/to/keysyms.h>
+
+set(template_path "${CMAKE_ARGV3}")
+set(target_path "${CMAKE_ARGV4}")
+
+if (NOT EXISTS "${template_path}")
+    message(FATAL_ERROR "Failed to find template file ${template_path}")
+endif()
+
+set(hex_digits "0123456789abcdef")
+set(ascii " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~")
+
+function(parse_hex output hex)
+    string(TOLOWER "${hex}" hex)
+    string(LENGTH "${hex}" length)
+    math(EXPR last "${length} - 1")
+    set(value 0)
+    foreach(i RANGE ${last})
+        string(SUBSTRING "${hex}" ${i} 1 digit)
+        string(FIND "${hex_digits}" "${digit}" digit)
+        math(EXPR value "${value} * 16 + ${digit}")
+    endforeach()
+    set(${output} ${value} PARENT_SCOPE)
+endfunction()
+
+function(format_hex output value digits)
+    set(hex "")
+    foreach(i RANGE 1 ${digits})
+        math(EXPR digit "${value} % 16")
+        math(EXPR value "${value} / 16")
+        string(SUBSTRING "${hex_digits}" ${digit} 1 digit)
+        set(hex "${digit}${hex}")
+    endforeach()
+    set(${output} "0x${hex}" PARENT_SCOPE)
+endfunction()
+
+# Read the KeySym to Unicode pairs, where the Unicode value is either a hex
+# number or a character literal
+file(STRINGS "${template_path}" lines REGEX "^  { 0x[0-9a-fA-F]+")
+foreach(line ${lines})
+    if (NOT "${line}" MATCHES "^  { 0x([0-9a-fA-F]+)[^,]*, *(0x([0-9a-fA-F]+)|'(.)')")
+        message(FATAL_ERROR "Failed to parse mapping ${line}")
+    endif()
+
+    parse_hex(keysym "${CMAKE_MATCH_1}")
+    if (CMAKE_MATCH_3)
+        parse_hex(ucs "${CMAKE_MATCH_3}")
+    else()
+        string(FIND "${ascii}" "${CMAKE_MATCH_4}" ucs)
+        math(EXPR ucs "${ucs} + 32")
+    endif()
+
+    math(EXPR page "${keysym} / 256")
+    math(EXPR index "${keysym} % 256")
+
+    if (NOT DEFINED page_${page})
+        list(APPEND pages ${page})
+        set(page_${page} 1)
+    endif()
+
+    set(code_${page}_${index} ${ucs})
+endforeach()
+
+list(LENGTH pages page_count)
+if (page_count GREATER 255)
+    message(FATAL_ERROR "Too many KeySym pages")
+endif()
+
+set(page_number 0)
+foreach(page ${pages})
+    math(EXPR page_number "${page_number} + 1")
+    set(page_number_${page} ${page_number})
+endforeach()
+
+foreach(page RANGE 255)
+    math(EXPR column "${page} % 16")
+    if (column EQUAL 0)
+        set(GLFW_KEYSYM_PAGES "${GLFW_KEYSYM_PAGES}   ")
+    endif()
+    if (DEFINED page_number_${page})
+        set(GLFW_KEYSYM_PAGES "${GLFW_KEYSYM_PAGES} ${page_number_${page}},")
+    else()
+        set(GLFW_KEYSYM_PAGES "${GLFW_KEYSYM_PAGES} 0,")
+    endif()
+    if (column EQUAL 15)
+        set(GLFW_KEYSYM_PAGES "${GLFW_KEYSYM_PAGES}\n")
+    endif()
+endforeach()
+
+foreach(page ${pages})
+    format_hex(first ${page} 2)
+    set(GLFW_KEYSYM_PAGE_CODES "${GLFW_KEYSYM_PAGE_CODES}  { // ${first}00\n")
+    foreach(index RANGE 255)
+        math(EXPR column "${index} % 8")
+        if (column EQUAL 0)
+            set(GLFW_KEYSYM_PAGE_CODES "${GLFW_KEYSYM_PAGE_CODES}   ")
+        endif()
+        if (DEFINED code_${page}_${index})
+            format_hex(code ${code_${page}_${index}} 4)
+        else()
+            set(code "0")
+        endif()
+        set(GLFW_KEYSYM_PAGE_CODES "${GLFW_KEYSYM_PAGE_CODES} ${code},")
+        if (column EQUAL 7)
+            set(GLFW_KEYSYM_PAGE_CODES "${GLFW_KEYSYM_PAGE_CODES}\n")
+        endif()
+    endforeach()
+    set(GLFW_KEYSYM_PAGE_CODES "${GLFW_KEYSYM_PAGE_CODES}  },\n")
+endforeach()
+
+set(GLFW_KEYSYM_PAGE_COUNT ${page_count})
+
+configure_file("${template_path}" "${target_path}" @ONLY NEWLINE_STYLE UNIX)
+
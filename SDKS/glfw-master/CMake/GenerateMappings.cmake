@@ -1,5 +1,8 @@
 # Usage:
-# cmake -P GenerateMappings.cmake <path/to/mappings.h.in> <path/to/mappings.h>
+# cmake -P GenerateMappings.cmake <path/to/mappings.h.in> <path/to/mappings.h> [path/to/gamecontrollerdb.txt]
+#
+# If no local copy of gamecontrollerdb.txt is specified, the latest version is
+# downloaded from SDL_GameControllerDB.
 
 set(source_url "https://raw.githubusercontent.com/gabomdq/SDL_GameControllerDB/master/gamecontrollerdb.txt")
 set(source_path "${CMAKE_CURRENT_BINARY_DIR}/gamecontrollerdb.txt")
@@ -10,24 +13,117 @@ if (NOT EXISTS "${template_path}")
     message(FATAL_ERROR "Failed to find template file ${template_path}")
 endif()
 
-file(DOWNLOAD "${source_url}" "${source_path}"
-     STATUS download_status
-     TLS_VERIFY on)
+# Must match hashGUID in input.c
+function(hash_guid output guid)
+    string(TOLOWER "${guid}" guid)
+    set(hash 2166136261)
+    foreach(i RANGE 31)
+        string(SUBSTRING "${guid}" ${i} 1 digit)
+        string(FIND "0123456789abcdef" "${digit}" value)
+        math(EXPR hash "((${hash} ^ ${value}) * 16777619) & 4294967295")
+    endforeach()
+    set(${output} ${hash} PARENT_SCOPE)
+endfunction()
 
-list(GET download_status 0 status_code)
-list(GET download_status 1 status_message)
+# Must match _glfwPlatformUpdateGamepadGUID in win32_joystick.c and
+# cocoa_joystick.m, so mappings can be found by their translated GUIDs
+function(translate_guid output guid)
+    string(TOLOWER "${guid}" guid)
+    set(guids "${guid}")
+    string(SUBSTRING "${guid}" 0 4 vendor)
+    string(SUBSTRING "${guid}" 4 4 product)
+    string(SUBSTRING "${guid}" 4 12 middle)
+    string(SUBSTRING "${guid}" 16 4 cocoa_product)
+    string(SUBSTRING "${guid}" 20 12 tail)
+    if ("${tail}" STREQUAL "504944564944")
+        list(APPEND guids "03000000${vendor}0000${product}000000000000")
+    endif()
+    if ("${middle}" STREQUAL "000000000000" AND "${tail}" STREQUAL "000000000000")
+        list(APPEND guids "03000000${vendor}0000${cocoa_product}000000000000")
+    endif()
+    set(${output} ${guids} PARENT_SCOPE)
+endfunction()
+
+if (CMAKE_ARGV5)
+    set(source_path "${CMAKE_ARGV5}")
+else()
+    file(DOWNLOAD "${source_url}" "${source_path}"
+         STATUS download_status
+         TLS_VERIFY on)
 
-if (status_code)
-    message(FATAL_ERROR "Failed to download ${source_url}: ${status_message}")
+    list(GET download_status 0 status_code)
+    list(GET download_status 1 status_message)
+
+    if (status_code)
+        message(FATAL_ERROR "Failed to download ${source_url}: ${status_message}")
+    endif()
 endif()
 
 file(STRINGS "${source_path}" lines)
 foreach(line ${lines})
     if ("${line}" MATCHES "^[0-9a-fA-F].*$")
         set(GLFW_GAMEPAD_MAPPINGS "${GLFW_GAMEPAD_MAPPINGS}\"${line}\",\n")
+        string(SUBSTRING "${line}" 0 32 guid)
+        list(APPEND guids "${guid}")
+    endif()
+endforeach()
+
+# The GLFW specific mappings follow the upstream ones in the template
+file(STRINGS "${template_path}" lines REGEX "^\"[0-9a-fA-F]")
+foreach(line ${lines})
+    string(SUBSTRING "${line}" 1 32 guid)
+    list(APPEND guids "${guid}")
+endforeach()
+
+# Build an open addressing hash index of the mappings keyed by GUID, with at
+# most half of the buckets in use, so no mapping needs parsing at init
+set(index 0)
+foreach(guid ${guids})
+    math(EXPR index "${index} + 1")
+    translate_guid(keys "${guid}")
+    foreach(key ${keys})
+        list(APPEND entries "${key}:${index}")
+    endforeach()
+endforeach()
+
+list(LENGTH entries entry_count)
+math(EXPR minimum_count "${entry_count} * 2")
+set(bucket_count 1)
+while (bucket_count LESS minimum_count)
+    math(EXPR bucket_count "${bucket_count} * 2")
+endwhile()
+math(EXPR bucket_mask "${bucket_count} - 1")
+
+foreach(bucket RANGE ${bucket_mask})
+    set(bucket_${bucket} 0)
+endforeach()
+
+foreach(entry ${entries})
+    string(SUBSTRING "${entry}" 0 32 key)
+    string(SUBSTRING "${entry}" 33 -1 index)
+    hash_guid(hash "${key}")
+    math(EXPR bucket "${hash} & ${bucket_mask}")
+    while (NOT "${bucket_${bucket}}" EQUAL 0)
+        math(EXPR bucket "(${bucket} + 1) & ${bucket_mask}")
+    endwhile()
+    set(bucket_${bucket} ${index})
+endforeach()
+
+set(GLFW_GAMEPAD_MAPPING_BUCKETS ${bucket_count})
+foreach(bucket RANGE ${bucket_mask})
+    math(EXPR column "${bucket} % 16")
+    if (column EQUAL 0)
+        set(GLFW_GAMEPAD_MAPPING_INDEX "${GLFW_GAMEPAD_MAPPING_INDEX}   ")
+    endif()
+    set(GLFW_GAMEPAD_MAPPING_INDEX "${GLFW_GAMEPAD_MAPPING_INDEX} ${bucket_${bucket}},")
+    if (column EQUAL 15 OR bucket EQUAL bucket_mask)
+        set(GLFW_GAMEPAD_MAPPING_INDEX "${GLFW_GAMEPAD_MAPPING_INDEX}\n")
     endif()
 endforeach()
 
 configure_file("${template_path}" "${target_path}" @ONLY NEWLINE_STYLE UNIX)
-file(REMOVE "${source_path}")
+
+if (NOT CMAKE_ARGV5)
+    file(REMOVE "${source_path}")
+endif()
 
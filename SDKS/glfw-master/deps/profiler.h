@@ -0,0 +1,812 @@
+//========================================================================
+// Frame profiler for the GLFW examples
+// Copyright (c) 2026 agent <agent@local>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would
+//    be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not
+//    be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source
+//    distribution.
+//
+//========================================================================
+//
+// This is a single header profiler that records named CPU and GPU zones for
+// each frame into a ring buffer, draws them as a frame time graph and a flame
+// graph with nuklear and exports them as Chrome trace JSON, which can be
+// loaded into chrome://tracing or https://ui.perfetto.dev
+//
+// Include it after glad and GLFW, and after nuklear if the overlay is wanted,
+// with PROFILER_IMPLEMENTATION defined in exactly one source file.  When
+// nuklear_glfw_gl2.h is included as well, the profiler_overlay_* functions
+// set up nuklear for a window and draw the overlay on top of a frame
+//
+// Until profiler_init is called the other functions do nothing, so zones can
+// be left in place in programs where profiling is optional
+//
+// CPU zones are timed with glfwGetTimerValue.  GPU zones are timed with
+// timestamp queries when the context supports OpenGL 3.3 or
+// GL_ARB_timer_query, and their results are collected without stalling once
+// the GPU has caught up, so a frame is shown only after all its zones are
+// known.  GPU times are placed on the CPU timeline using a timestamp taken at
+// the start of each frame
+//
+// All functions must be called from the thread whose context was current when
+// profiler_init was called
+//
+//========================================================================
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// Number of frames kept in the history, must be a power of two
+#define PROFILER_FRAME_COUNT 128
+// Maximum number of zones, CPU and GPU combined, recorded for each frame
+#define PROFILER_MAX_ZONES 64
+// Maximum nesting depth of CPU zones and of GPU zones
+#define PROFILER_MAX_DEPTH 8
+
+typedef struct ProfilerZone
+{
+    // The name is not copied and must outlive the profiler
+    const char* name;
+    // Timer values as returned by glfwGetTimerValue
+    uint64_t start;
+    uint64_t end;
+    int depth;
+    int gpu;
+} ProfilerZone;
+
+typedef struct ProfilerFrame
+{
+    uint64_t number;
+    uint64_t start;
+    uint64_t end;
+    // Number of GPU zones whose queries have not yet been collected
+    int pending;
+    int zone_count;
+    ProfilerZone zones[PROFILER_MAX_ZONES];
+} ProfilerFrame;
+
+void profiler_init(void);
+void profiler_terminate(void);
+void profiler_begin_frame(void);
+void profiler_end_frame(void);
+int profiler_begin(const char* name);
+void profiler_end(int zone);
+int profiler_begin_gpu(const char* name);
+void profiler_end_gpu(int zone);
+const ProfilerFrame* profiler_get_frame(int age);
+int profiler_write_trace(const char* path);
+
+#if defined(NK_NUKLEAR_H_)
+void profiler_overlay(struct nk_context* nk, struct nk_rect bounds);
+#endif
+
+#if defined(NK_GLFW_GL2_H_)
+struct nk_context* profiler_overlay_init(GLFWwindow* window);
+void profiler_overlay_draw(GLFWwindow* window);
+void profiler_overlay_terminate(void);
+#endif
+
+// Times the statement or block following it as a zone, which must not be
+// left with break, goto or return
+#define PROFILER_ZONE(name) \
+    for (int profiler_zone_ = profiler_begin(name), profiler_once_ = 1; \
+         profiler_once_; \
+         profiler_end(profiler_zone_), profiler_once_ = 0)
+
+#define PROFILER_GPU_ZONE(name) \
+    for (int profiler_zone_ = profiler_begin_gpu(name), profiler_once_ = 1; \
+         profiler_once_; \
+         profiler_end_gpu(profiler_zone_), profiler_once_ = 0)
+
+#endif // PROFILER_H
+
+#if defined(PROFILER_IMPLEMENTATION)
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef GL_TIMESTAMP
+ #define GL_TIMESTAMP 0x8E28
+#endif
+
+typedef void (APIENTRYP PROFILERQUERYCOUNTERPROC)(GLuint, GLenum);
+typedef void (APIENTRYP PROFILERGETQUERYOBJECTUI64VPROC)(GLuint, GLenum, GLuint64*);
+typedef void (APIENTRYP PROFILERGETINTEGER64VPROC)(GLenum, GLint64*);
+
+static struct
+{
+    uint64_t frequency;
+    int enabled;
+    int gpu;
+    PROFILERQUERYCOUNTERPROC QueryCounter;
+    PROFILERGETQUERYOBJECTUI64VPROC GetQueryObjectui64v;
+    PROFILERGETINTEGER64VPROC GetInteger64v;
+
+    // Number of the next frame to begin, which also counts completed frames
+    uint64_t frame_number;
+    int in_frame;
+    ProfilerFrame frames[PROFILER_FRAME_COUNT];
+    // Start and end timestamp queries of each zone of each frame
+    GLuint queries[PROFILER_FRAME_COUNT][PROFILER_MAX_ZONES][2];
+    // Matching GPU and CPU times taken at the start of each frame
+    GLint64 gpu_reference[PROFILER_FRAME_COUNT];
+    uint64_t cpu_reference[PROFILER_FRAME_COUNT];
+
+    int cpu_stack[PROFILER_MAX_DEPTH];
+    int cpu_depth;
+    int gpu_stack[PROFILER_MAX_DEPTH];
+    int gpu_depth;
+
+    // The frame shown by the flame graph
+    ProfilerFrame shown;
+    int paused;
+} profiler_state;
+
+static int profiler_slot(uint64_t number)
+{
+    return (int) (number & (PROFILER_FRAME_COUNT - 1));
+}
+
+static uint64_t profiler_gpu_to_cpu(int slot, GLuint64 time)
+{
+    const double offset = ((double) time - (double) profiler_state.gpu_reference[slot]) *
+                          profiler_state.frequency / 1e9;
+
+    if (offset < 0.0 && -offset > profiler_state.cpu_reference[slot])
+        return 0;
+
+    return profiler_state.cpu_reference[slot] + (int64_t) offset;
+}
+
+// Collects the results of the GPU zones of a frame, waiting for them only if
+// requested
+//
+static int profiler_resolve(int slot, int wait)
+{
+    int i;
+    ProfilerFrame* frame = profiler_state.frames + slot;
+
+    for (i = 0;  i < frame->zone_count && frame->pending;  i++)
+    {
+        ProfilerZone* zone = frame->zones + i;
+        GLuint* queries = profiler_state.queries[slot][i];
+        GLuint64 start, end;
+
+        if (!zone->gpu || zone->end)
+            continue;
+
+        if (!wait)
+        {
+            GLint available;
+            glGetQueryObjectiv(queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return GLFW_FALSE;
+        }
+
+        profiler_state.GetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &start);
+        profiler_state.GetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end);
+
+        zone->start = profiler_gpu_to_cpu(slot, start);
+        zone->end = profiler_gpu_to_cpu(slot, end);
+        if (zone->end <= zone->start)
+            zone->end = zone->start + 1;
+
+        frame->pending--;
+    }
+
+    return GLFW_TRUE;
+}
+
+static void profiler_resolve_all(int wait)
+{
+    uint64_t number = 0;
+
+    if (profiler_state.frame_number > PROFILER_FRAME_COUNT)
+        number = profiler_state.frame_number - PROFILER_FRAME_COUNT;
+
+    for (;  number < profiler_state.frame_number;  number++)
+    {
+        if (!profiler_resolve(profiler_slot(number), wait))
+            break;
+    }
+}
+
+static int profiler_begin_zone(const char* name, int gpu)
+{
+    const int slot = profiler_slot(profiler_state.frame_number);
+    ProfilerFrame* frame = profiler_state.frames + slot;
+    ProfilerZone* zone;
+    int* stack = gpu ? profiler_state.gpu_stack : profiler_state.cpu_stack;
+    int* depth = gpu ? &profiler_state.gpu_depth : &profiler_state.cpu_depth;
+
+    if (!profiler_state.in_frame || (gpu && !profiler_state.gpu))
+        return -1;
+    if (frame->zone_count == PROFILER_MAX_ZONES || *depth == PROFILER_MAX_DEPTH)
+        return -1;
+
+    zone = frame->zones + frame->zone_count;
+    zone->name = name;
+    zone->depth = *depth;
+    zone->gpu = gpu;
+    zone->start = 0;
+    zone->end = 0;
+
+    if (gpu)
+    {
+        GLuint* queries = profiler_state.queries[slot][frame->zone_count];
+        if (!queries[0])
+            glGenQueries(2, queries);
+
+        profiler_state.QueryCounter(queries[0], GL_TIMESTAMP);
+        frame->pending++;
+    }
+    else
+        zone->start = glfwGetTimerValue();
+
+    stack[(*depth)++] = frame->zone_count;
+    return frame->zone_count++;
+}
+
+static void profiler_end_zone(int index, int gpu)
+{
+    const int slot = profiler_slot(profiler_state.frame_number);
+    ProfilerFrame* frame = profiler_state.frames + slot;
+    int* stack = gpu ? profiler_state.gpu_stack : profiler_state.cpu_stack;
+    int* depth = gpu ? &profiler_state.gpu_depth : &profiler_state.cpu_depth;
+
+    if (index < 0 || !profiler_state.in_frame)
+        return;
+
+    // Zones left open inside this one are ended along with it
+    while (*depth > 0)
+    {
+        const int top = stack[--(*depth)];
+
+        if (gpu)
+            profiler_state.QueryCounter(profiler_state.queries[slot][top][1], GL_TIMESTAMP);
+        else
+            frame->zones[top].end = glfwGetTimerValue();
+
+        if (top == index)
+            break;
+    }
+}
+
+void profiler_init(void)
+{
+    GLFWwindow* window = glfwGetCurrentContext();
+    const int major = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR);
+    const int minor = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MINOR);
+
+    memset(&profiler_state, 0, sizeof(profiler_state));
+    profiler_state.frequency = glfwGetTimerFrequency();
+    profiler_state.enabled = GLFW_TRUE;
+
+    if (major > 3 || (major == 3 && minor >= 3) ||
+        glfwExtensionSupported("GL_ARB_timer_query"))
+    {
+        profiler_state.QueryCounter = (PROFILERQUERYCOUNTERPROC)
+            glfwGetProcAddress("glQueryCounter");
+        profiler_state.GetQueryObjectui64v = (PROFILERGETQUERYOBJECTUI64VPROC)
+            glfwGetProcAddress("glGetQueryObjectui64v");
+        // Loaded here as glad only loads it for OpenGL 3.2, which contexts
+        // with only the extension may not have
+        profiler_state.GetInteger64v = (PROFILERGETINTEGER64VPROC)
+            glfwGetProcAddress("glGetInteger64v");
+
+        profiler_state.gpu = profiler_state.QueryCounter &&
+                             profiler_state.GetQueryObjectui64v &&
+                             profiler_state.GetInteger64v;
+    }
+}
+
+void profiler_terminate(void)
+{
+    int i, j;
+
+    for (i = 0;  i < PROFILER_FRAME_COUNT;  i++)
+    {
+        for (j = 0;  j < PROFILER_MAX_ZONES;  j++)
+        {
+            if (profiler_state.queries[i][j][0])
+                glDeleteQueries(2, profiler_state.queries[i][j]);
+        }
+    }
+
+    memset(&profiler_state, 0, sizeof(profiler_state));
+}
+
+void profiler_begin_frame(void)
+{
+    const int slot = profiler_slot(profiler_state.frame_number);
+    ProfilerFrame* frame = profiler_state.frames + slot;
+
+    if (!profiler_state.enabled)
+        return;
+
+    if (profiler_state.in_frame)
+        profiler_end_frame();
+
+    // The queries of this slot are about to be reused
+    if (frame->pending)
+        profiler_resolve(slot, GLFW_TRUE);
+
+    frame->number = profiler_state.frame_number;
+    frame->pending = 0;
+    frame->zone_count = 0;
+    frame->end = 0;
+    frame->start = glfwGetTimerValue();
+
+    if (profiler_state.gpu)
+    {
+        profiler_state.GetInteger64v(GL_TIMESTAMP, profiler_state.gpu_reference + slot);
+        profiler_state.cpu_reference[slot] = glfwGetTimerValue();
+    }
+
+    profiler_state.in_frame = GLFW_TRUE;
+}
+
+void profiler_end_frame(void)
+{
+    ProfilerFrame* frame;
+
+    if (!profiler_state.in_frame)
+        return;
+
+    if (profiler_state.cpu_depth)
+        profiler_end_zone(profiler_state.cpu_stack[0], GLFW_FALSE);
+    if (profiler_state.gpu_depth)
+        profiler_end_zone(profiler_state.gpu_stack[0], GLFW_TRUE);
+
+    frame = profiler_state.frames + profiler_slot(profiler_state.frame_number);
+    frame->end = glfwGetTimerValue();
+
+    profiler_state.in_frame = GLFW_FALSE;
+    profiler_state.frame_number++;
+
+    profiler_resolve_all(GLFW_FALSE);
+
+    if (!profiler_state.paused)
+    {
+        const ProfilerFrame* latest = profiler_get_frame(0);
+        if (latest)
+            profiler_state.shown = *latest;
+    }
+}
+
+int profiler_begin(const char* name)
+{
+    return profiler_begin_zone(name, GLFW_FALSE);
+}
+
+void profiler_end(int zone)
+{
+    profiler_end_zone(zone, GLFW_FALSE);
+}
+
+int profiler_begin_gpu(const char* name)
+{
+    return profiler_begin_zone(name, GLFW_TRUE);
+}
+
+void profiler_end_gpu(int zone)
+{
+    profiler_end_zone(zone, GLFW_TRUE);
+}
+
+// Returns the completed frame with all its zones known that is the specified
+// number of such frames older than the latest one, or NULL
+//
+const ProfilerFrame* profiler_get_frame(int age)
+{
+    uint64_t number = profiler_state.frame_number;
+    uint64_t first = 0;
+
+    if (number > PROFILER_FRAME_COUNT)
+        first = number - PROFILER_FRAME_COUNT;
+
+    // Frames are resolved in order, so the pending ones are the newest
+    while (number > first)
+    {
+        const ProfilerFrame* frame = profiler_state.frames + profiler_slot(number - 1);
+        if (!frame->pending)
+            break;
+
+        number--;
+    }
+
+    if (age < 0 || (uint64_t) age >= number - first)
+        return NULL;
+
+    return profiler_state.frames + profiler_slot(number - 1 - age);
+}
+
+static void profiler_write_event(FILE* file,
+                                 const char* name,
+                                 uint64_t number,
+                                 int tid,
+                                 uint64_t origin,
+                                 uint64_t start,
+                                 uint64_t end)
+{
+    const double scale = 1e6 / profiler_state.frequency;
+
+    fputs(",\n{\"name\":\"", file);
+
+    if (name)
+    {
+        for (;  *name;  name++)
+        {
+            if (*name == '"' || *name == '\\')
+                fprintf(file, "\\%c", *name);
+            else if ((unsigned char) *name < 0x20)
+                fprintf(file, "\\u%04x", *name);
+            else
+                fputc(*name, file);
+        }
+    }
+    else
+        fprintf(file, "Frame %llu", (unsigned long long) number);
+
+    fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+            tid,
+            (double) (start - origin) * scale,
+            (double) (end - start) * scale);
+}
+
+// Writes the frames in the history to a Chrome trace JSON file, with the CPU
+// zones nested inside each frame on one track and the GPU zones on another
+//
+int profiler_write_trace(const char* path)
+{
+    int age, count, i;
+    uint64_t origin = UINT64_MAX;
+    const ProfilerFrame* frame;
+    FILE* file;
+
+    if (profiler_state.in_frame)
+        profiler_end_frame();
+
+    profiler_resolve_all(GLFW_TRUE);
+
+    file = fopen(path, "w");
+    if (!file)
+        return GLFW_FALSE;
+
+    // GPU zones may start before the frame they were issued in
+    for (count = 0;  (frame = profiler_get_frame(count));  count++)
+    {
+        if (frame->start < origin)
+            origin = frame->start;
+
+        for (i = 0;  i < frame->zone_count;  i++)
+        {
+            if (frame->zones[i].start < origin)
+                origin = frame->zones[i].start;
+        }
+    }
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n", file);
+    fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}", file);
+
+    for (age = count - 1;  age >= 0;  age--)
+    {
+        frame = profiler_get_frame(age);
+        profiler_write_event(file, NULL, frame->number, 1, origin, frame->start, frame->end);
+
+        for (i = 0;  i < frame->zone_count;  i++)
+        {
+            const ProfilerZone* zone = frame->zones + i;
+            profiler_write_event(file, zone->name, frame->number, zone->gpu ? 2 : 1,
+                                 origin, zone->start, zone->end);
+        }
+    }
+
+    fputs("\n]}\n", file);
+    return fclose(file) == 0;
+}
+
+#if defined(NK_NUKLEAR_H_)
+
+#define PROFILER_ROW_HEIGHT 18.f
+#define PROFILER_GRAPH_HEIGHT 60.f
+
+static double profiler_ms(uint64_t start, uint64_t end)
+{
+    return (double) (end - start) * 1000.0 / profiler_state.frequency;
+}
+
+static struct nk_color profiler_zone_color(const char* name)
+{
+    uint32_t hash = 2166136261u;
+
+    for (;  *name;  name++)
+        hash = (hash ^ (unsigned char) *name) * 16777619u;
+
+    return nk_hsv_f((hash & 0xffff) / 65536.f, 0.55f, 0.8f);
+}
+
+// Draws the duration of each frame in the history as a bar, with lines at
+// 60 and 30 frames per second, and shows a frame in the flame graph when its
+// bar is clicked
+//
+static void profiler_draw_frame_graph(struct nk_context* nk)
+{
+    int age;
+    double max_ms = 1000.0 / 30.0;
+    float width;
+    struct nk_rect bounds;
+    struct nk_command_buffer* canvas = nk_window_get_canvas(nk);
+    const ProfilerFrame* frame;
+
+    if (!nk_widget(&bounds, nk))
+        return;
+
+    for (age = 0;  (frame = profiler_get_frame(age));  age++)
+    {
+        const double ms = profiler_ms(frame->start, frame->end);
+        if (ms > max_ms)
+            max_ms = ms;
+    }
+
+    max_ms *= 1.1;
+    width = bounds.w / PROFILER_FRAME_COUNT;
+
+    nk_fill_rect(canvas, bounds, 0.f, nk_rgba(0, 0, 0, 160));
+
+    for (age = 0;  (frame = profiler_get_frame(age));  age++)
+    {
+        const double ms = profiler_ms(frame->start, frame->end);
+        const float height = (float) (ms / max_ms) * bounds.h;
+        struct nk_rect bar = nk_rect(bounds.x + bounds.w - (age + 1) * width,
+                                     bounds.y + bounds.h - height,
+                                     width, height);
+        struct nk_color color = nk_rgb(80, 200, 80);
+
+        if (ms > 1000.0 / 30.0)
+            color = nk_rgb(220, 70, 60);
+        else if (ms > 1000.0 / 60.0)
+            color = nk_rgb(230, 190, 60);
+
+        if (frame->number == profiler_state.shown.number)
+            color = nk_rgb(240, 240, 240);
+
+        nk_fill_rect(canvas, bar, 0.f, color);
+
+        bar.y = bounds.y;
+        bar.h = bounds.h;
+
+        if (nk_input_is_mouse_hovering_rect(&nk->input, bar))
+            nk_tooltipf(nk, "Frame %llu: %.2f ms", (unsigned long long) frame->number, ms);
+
+        if (nk_input_is_mouse_click_in_rect(&nk->input, NK_BUTTON_LEFT, bar))
+        {
+            profiler_state.shown = *frame;
+            profiler_state.paused = GLFW_TRUE;
+        }
+    }
+
+    for (age = 1;  age <= 2;  age++)
+    {
+        const float y = bounds.y + bounds.h -
+                        (float) (1000.0 / (age * 30.0) / max_ms) * bounds.h;
+
+        nk_stroke_line(canvas, bounds.x, y, bounds.x + bounds.w, y, 1.f,
+                       nk_rgba(255, 255, 255, 96));
+    }
+}
+
+// Draws the zones of the shown frame as nested bars, CPU above GPU, on a
+// time axis spanning the frame and any GPU work that finished after it
+//
+static void profiler_draw_flame_graph(struct nk_context* nk, int cpu_rows)
+{
+    int i;
+    double scale;
+    uint64_t end;
+    struct nk_rect bounds;
+    struct nk_command_buffer* canvas = nk_window_get_canvas(nk);
+    const struct nk_user_font* font = nk->style.font;
+    const ProfilerFrame* frame = &profiler_state.shown;
+
+    if (!nk_widget(&bounds, nk))
+        return;
+
+    nk_fill_rect(canvas, bounds, 0.f, nk_rgba(0, 0, 0, 160));
+
+    end = frame->end;
+    for (i = 0;  i < frame->zone_count;  i++)
+    {
+        if (frame->zones[i].end > end)
+            end = frame->zones[i].end;
+    }
+
+    if (end <= frame->start)
+        return;
+
+    scale = bounds.w / (double) (end - frame->start);
+
+    for (i = 0;  i < frame->zone_count;  i++)
+    {
+        const ProfilerZone* zone = frame->zones + i;
+        const uint64_t start = zone->start > frame->start ? zone->start : frame->start;
+        const int row = zone->gpu ? cpu_rows + zone->depth : zone->depth;
+        const int length = (int) strlen(zone->name);
+        struct nk_rect rect;
+
+        if (zone->end <= start)
+            continue;
+
+        rect = nk_rect(bounds.x + (float) ((start - frame->start) * scale),
+                       bounds.y + row * PROFILER_ROW_HEIGHT,
+                       (float) ((zone->end - start) * scale),
+                       PROFILER_ROW_HEIGHT - 1.f);
+        if (rect.w < 1.f)
+            rect.w = 1.f;
+
+        nk_fill_rect(canvas, rect, 0.f, profiler_zone_color(zone->name));
+
+        if (font->width(font->userdata, font->height, zone->name, length) + 4.f < rect.w)
+        {
+            struct nk_rect text = nk_rect(rect.x + 2.f, rect.y, rect.w - 4.f, rect.h);
+            nk_draw_text(canvas, text, zone->name, length, font,
+                         nk_rgba(0, 0, 0, 0), nk_rgb(0, 0, 0));
+        }
+
+        if (nk_input_is_mouse_hovering_rect(&nk->input, rect))
+        {
+            nk_tooltipf(nk, "%s (%s): %.3f ms", zone->name,
+                        zone->gpu ? "GPU" : "CPU",
+                        profiler_ms(zone->start, zone->end));
+        }
+    }
+}
+
+void profiler_overlay(struct nk_context* nk, struct nk_rect bounds)
+{
+    const nk_flags flags = NK_WINDOW_BORDER | NK_WINDOW_MOVABLE |
+                           NK_WINDOW_SCALABLE | NK_WINDOW_MINIMIZABLE |
+                           NK_WINDOW_TITLE;
+
+    if (nk_begin(nk, "Profiler", bounds, flags))
+    {
+        int i, age, count = 0;
+        int cpu_rows = 0, gpu_rows = 0;
+        double total_ms = 0.0, max_ms = 0.0, cpu_ms = 0.0, gpu_ms = 0.0;
+        const ProfilerFrame* frame;
+        const ProfilerFrame* shown = &profiler_state.shown;
+
+        for (age = 0;  (frame = profiler_get_frame(age));  age++)
+        {
+            const double ms = profiler_ms(frame->start, frame->end);
+            total_ms += ms;
+            if (ms > max_ms)
+                max_ms = ms;
+            count++;
+        }
+
+        for (i = 0;  i < shown->zone_count;  i++)
+        {
+            const ProfilerZone* zone = shown->zones + i;
+
+            if (zone->gpu)
+            {
+                if (zone->depth + 1 > gpu_rows)
+                    gpu_rows = zone->depth + 1;
+                if (zone->depth == 0)
+                    gpu_ms += profiler_ms(zone->start, zone->end);
+            }
+            else
+            {
+                if (zone->depth + 1 > cpu_rows)
+                    cpu_rows = zone->depth + 1;
+                if (zone->depth == 0)
+                    cpu_ms += profiler_ms(zone->start, zone->end);
+            }
+        }
+
+        nk_layout_row_dynamic(nk, 20, 2);
+        nk_labelf(nk, NK_TEXT_LEFT, "Average %.2f ms, max %.2f ms",
+                  count ? total_ms / count : 0.0, max_ms);
+        nk_checkbox_label(nk, "Pause", &profiler_state.paused);
+
+        nk_layout_row_dynamic(nk, PROFILER_GRAPH_HEIGHT, 1);
+        profiler_draw_frame_graph(nk);
+
+        nk_layout_row_dynamic(nk, 20, 1);
+        if (profiler_state.gpu)
+        {
+            nk_labelf(nk, NK_TEXT_LEFT, "Frame %llu: %.2f ms, CPU zones %.2f ms, GPU zones %.2f ms",
+                      (unsigned long long) shown->number,
+                      profiler_ms(shown->start, shown->end), cpu_ms, gpu_ms);
+        }
+        else
+        {
+            nk_labelf(nk, NK_TEXT_LEFT, "Frame %llu: %.2f ms, CPU zones %.2f ms",
+                      (unsigned long long) shown->number,
+                      profiler_ms(shown->start, shown->end), cpu_ms);
+        }
+
+        if (cpu_rows + gpu_rows > 0)
+        {
+            nk_layout_row_dynamic(nk, (cpu_rows + gpu_rows) * PROFILER_ROW_HEIGHT, 1);
+            profiler_draw_flame_graph(nk, cpu_rows);
+        }
+    }
+
+    nk_end(nk);
+}
+
+#endif // NK_NUKLEAR_H_
+
+#if defined(NK_GLFW_GL2_H_)
+
+static struct nk_context* profiler_nk;
+
+// Sets up nuklear with its default font for the specified window, whose
+// context must be current
+//
+struct nk_context* profiler_overlay_init(GLFWwindow* window)
+{
+    struct nk_font_atlas* atlas;
+
+    profiler_nk = nk_glfw3_init(window, NK_GLFW3_DEFAULT);
+    nk_glfw3_font_stash_begin(&atlas);
+    nk_glfw3_font_stash_end();
+
+    return profiler_nk;
+}
+
+// Draws the overlay over the top half of the window as a GPU zone of its own,
+// filled even if the program draws in wireframe
+//
+void profiler_overlay_draw(GLFWwindow* window)
+{
+    int width, height;
+    const int zone = profiler_begin_gpu("Overlay");
+
+    glfwGetWindowSize(window, &width, &height);
+
+    glPushAttrib(GL_POLYGON_BIT);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    nk_glfw3_new_frame();
+    profiler_overlay(profiler_nk, nk_rect(10.f, 10.f, width - 20.f, height / 2.f));
+    nk_glfw3_render(NK_ANTI_ALIASING_ON);
+
+    glPopAttrib();
+
+    profiler_end_gpu(zone);
+}
+
+void profiler_overlay_terminate(void)
+{
+    if (!profiler_nk)
+        return;
+
+    nk_glfw3_shutdown();
+    profiler_nk = NULL;
+}
+
+#endif // NK_GLFW_GL2_H_
+
+#endif // PROFILER_IMPLEMENTATION
+
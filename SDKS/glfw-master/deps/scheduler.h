@@ -0,0 +1,284 @@
+//========================================================================
+// Frame scheduler for the GLFW examples and tests
+// Copyright (c) 2026 agent <agent@local>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would
+//    be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not
+//    be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source
+//    distribution.
+//
+//========================================================================
+//
+// This is a single header frame scheduler that swaps buffers at a steady
+// target frame time and keeps count of the frames that missed it
+//
+// The wait for the next frame first sleeps and then spins on
+// glfwGetTimerValue for the last part, which is sized by how late the sleeps
+// have been waking up, so frames are on time without a core being kept busy
+// for the whole wait
+//
+// With adaptive swap interval enabled, frames that are on time wait for
+// vertical sync but late ones are swapped at once and may tear.  This uses
+// a swap interval of -1 where the EXT_swap_control_tear extensions are
+// supported, and switches between 1 and 0 from frame to frame elsewhere
+//
+// Include it after GLFW, with SCHEDULER_IMPLEMENTATION defined in exactly one
+// source file
+//
+//========================================================================
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+typedef struct Scheduler
+{
+    uint64_t frequency;
+    // Target frame time in timer ticks, or zero to not limit the frame rate
+    uint64_t period;
+    // Refresh period of the monitor, for judging frames when not limited
+    uint64_t refresh_period;
+    // When the current frame should be swapped
+    uint64_t deadline;
+    // How long before the deadline to stop sleeping and start spinning
+    uint64_t margin;
+    int adaptive;
+    int swap_tear;
+    int interval;
+
+    // Frame statistics since the last reset
+    uint64_t frame_count;
+    uint64_t late_count;
+    uint64_t late_ticks;
+    uint64_t max_late_ticks;
+    uint64_t sleep_ticks;
+    uint64_t spin_ticks;
+} Scheduler;
+
+void scheduler_init(Scheduler* scheduler, double frame_time, int adaptive);
+void scheduler_set_frame_time(Scheduler* scheduler, double frame_time);
+void scheduler_set_adaptive(Scheduler* scheduler, int adaptive);
+void scheduler_swap_buffers(Scheduler* scheduler, GLFWwindow* window);
+void scheduler_reset_stats(Scheduler* scheduler);
+
+#endif // SCHEDULER_H
+
+#if defined(SCHEDULER_IMPLEMENTATION)
+
+#include <string.h>
+
+#if defined(_WIN32)
+ #include <windows.h>
+#else
+ #include <time.h>
+ #include <errno.h>
+#endif
+
+// Sleeps until the specified timer value or for the duration, whichever the
+// platform can do
+//
+static void scheduler_sleep(Scheduler* scheduler, uint64_t now, uint64_t wake)
+{
+#if defined(_WIN32)
+    const DWORD ms = (DWORD) ((wake - now) * 1000 / scheduler->frequency);
+    if (ms > 0)
+        Sleep(ms);
+#else
+    struct timespec ts;
+
+#if defined(CLOCK_MONOTONIC) && defined(TIMER_ABSTIME) && !defined(__APPLE__)
+    // The GLFW timer uses the monotonic clock when it has nanosecond ticks,
+    // so the wake-up time can be given as is and early wake-ups resumed
+    if (scheduler->frequency == 1000000000)
+    {
+        ts.tv_sec = (time_t) (wake / 1000000000);
+        ts.tv_nsec = (long) (wake % 1000000000);
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+            ;
+
+        return;
+    }
+#endif
+
+    {
+        const uint64_t ns = (wake - now) * 1000000000 / scheduler->frequency;
+        ts.tv_sec = (time_t) (ns / 1000000000);
+        ts.tv_nsec = (long) (ns % 1000000000);
+        nanosleep(&ts, NULL);
+    }
+#endif
+}
+
+static void scheduler_wait_until(Scheduler* scheduler, uint64_t target)
+{
+    uint64_t now = glfwGetTimerValue();
+    const uint64_t start = now;
+
+    if (target > now + scheduler->margin)
+    {
+        const uint64_t wake = target - scheduler->margin;
+
+        scheduler_sleep(scheduler, now, wake);
+        now = glfwGetTimerValue();
+        scheduler->sleep_ticks += now - start;
+
+        // Grow the margin at once to cover an oversleep, with some room to
+        // spare, and shrink it slowly back towards the typical oversleep
+        if (now > wake)
+        {
+            const uint64_t oversleep = now - wake;
+
+            if (oversleep + oversleep / 4 > scheduler->margin)
+                scheduler->margin = oversleep + oversleep / 4;
+            else
+                scheduler->margin -= (scheduler->margin - oversleep) / 16;
+        }
+        else
+            scheduler->margin -= scheduler->margin / 16;
+
+        if (scheduler->margin < scheduler->frequency / 10000)
+            scheduler->margin = scheduler->frequency / 10000;
+        if (scheduler->period && scheduler->margin > scheduler->period / 2)
+            scheduler->margin = scheduler->period / 2;
+    }
+
+    if (now < target)
+    {
+        const uint64_t spin_start = now;
+
+        while (now < target)
+            now = glfwGetTimerValue();
+
+        scheduler->spin_ticks += now - spin_start;
+    }
+}
+
+static void scheduler_set_interval(Scheduler* scheduler, int interval)
+{
+    if (scheduler->interval != interval)
+    {
+        scheduler->interval = interval;
+        glfwSwapInterval(interval);
+    }
+}
+
+// Sets up the scheduler for the current context, with a target frame time in
+// seconds or zero to not limit the frame rate
+//
+void scheduler_init(Scheduler* scheduler, double frame_time, int adaptive)
+{
+    const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+
+    memset(scheduler, 0, sizeof(Scheduler));
+    scheduler->frequency = glfwGetTimerFrequency();
+    scheduler->margin = scheduler->frequency / 1000;
+    scheduler->interval = -2;
+    scheduler->swap_tear = glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+                           glfwExtensionSupported("GLX_EXT_swap_control_tear");
+
+    if (mode && mode->refreshRate > 0)
+        scheduler->refresh_period = scheduler->frequency / mode->refreshRate;
+    else
+        scheduler->refresh_period = scheduler->frequency / 60;
+
+    scheduler_set_frame_time(scheduler, frame_time);
+    scheduler_set_adaptive(scheduler, adaptive);
+}
+
+void scheduler_set_frame_time(Scheduler* scheduler, double frame_time)
+{
+    if (frame_time > 0.0)
+        scheduler->period = (uint64_t) (frame_time * scheduler->frequency);
+    else
+        scheduler->period = 0;
+
+    scheduler->deadline = 0;
+}
+
+// Enables or disables adaptive swap interval, leaving the swap interval to
+// the application when disabled
+//
+void scheduler_set_adaptive(Scheduler* scheduler, int adaptive)
+{
+    scheduler->adaptive = adaptive;
+
+    if (adaptive)
+        scheduler_set_interval(scheduler, scheduler->swap_tear ? -1 : 1);
+    else
+        scheduler->interval = -2;
+}
+
+// Waits until the deadline of the current frame, or notes that it has been
+// missed, and swaps the buffers of the window
+//
+void scheduler_swap_buffers(Scheduler* scheduler, GLFWwindow* window)
+{
+    const uint64_t now = glfwGetTimerValue();
+    const uint64_t budget = scheduler->period ? scheduler->period
+                                              : scheduler->refresh_period;
+    int late = GLFW_FALSE;
+
+    if (!scheduler->deadline)
+        scheduler->deadline = now;
+
+    if (now > scheduler->deadline)
+    {
+        const uint64_t lateness = now - scheduler->deadline;
+
+        // Delays shorter than half a millisecond are not counted as late
+        if (lateness > scheduler->frequency / 2000)
+        {
+            late = GLFW_TRUE;
+            scheduler->late_count++;
+            scheduler->late_ticks += lateness;
+            if (lateness > scheduler->max_late_ticks)
+                scheduler->max_late_ticks = lateness;
+        }
+
+        // Start the next frame from now instead of trying to catch up
+        scheduler->deadline = now;
+    }
+    else if (scheduler->period)
+        scheduler_wait_until(scheduler, scheduler->deadline);
+
+    if (scheduler->adaptive && !scheduler->swap_tear)
+        scheduler_set_interval(scheduler, late ? 0 : 1);
+
+    glfwSwapBuffers(window);
+    scheduler->frame_count++;
+
+    // Without a target frame time the swap itself sets the pace
+    if (scheduler->period)
+        scheduler->deadline += budget;
+    else
+        scheduler->deadline = glfwGetTimerValue() + budget;
+}
+
+void scheduler_reset_stats(Scheduler* scheduler)
+{
+    scheduler->frame_count = 0;
+    scheduler->late_count = 0;
+    scheduler->late_ticks = 0;
+    scheduler->max_late_ticks = 0;
+    scheduler->sleep_ticks = 0;
+    scheduler->spin_ticks = 0;
+}
+
+#endif // SCHEDULER_IMPLEMENTATION
+
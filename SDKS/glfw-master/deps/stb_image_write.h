@@ -80,6 +80,16 @@ USAGE:
    TGA supports RLE or non-RLE compressed data. To use non-RLE-compressed
    data, set the global variable 'stbi_write_tga_with_rle' to 0.
 
+   PNG normally tries every row filter and runs a hash-chain deflate, which
+   is slow for large images. Set the global variable 'stbi_write_png_fast'
+   to 1 to filter each row once with Sub or Up and compress with a greedy
+   single-probe deflate, or to 2 to write the filtered rows as stored
+   blocks. The fast modes split the image into row bands that are
+   compressed independently and written as separate IDAT chunks. You can
+   #define STBIW_PARALLEL_FOR(count,func,data) to run func(data,i) for
+   every band i in [0,count) on your own threads. Otherwise the bands
+   are compressed with OpenMP when it is enabled, and serially when not.
+
 CREDITS:
 
    PNG/BMP/TGA
@@ -124,6 +134,7 @@ extern "C" {
 #else
 #define STBIWDEF extern
 extern int stbi_write_tga_with_rle;
+extern int stbi_write_png_fast;
 #endif
 
 #ifndef STBI_WRITE_NO_STDIO
@@ -236,8 +247,10 @@ typedef int stb_image_write_test[sizeof(stbiw_uint32)==4 ? 1 : -1];
 
 #ifdef STB_IMAGE_WRITE_STATIC
 static int stbi_write_tga_with_rle = 1;
+static int stbi_write_png_fast = 0;
 #else
 int stbi_write_tga_with_rle = 1;
+int stbi_write_png_fast = 0;
 #endif
 
 static void stbiw__writefv(stbi__write_context *s, const char *fmt, va_list v)
@@ -728,12 +741,15 @@ static unsigned int stbiw__zhash(unsigned char *data)
 
 #define stbiw__ZHASH   16384
 
+static unsigned short stbiw__lengthc[] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258, 259 };
+static unsigned char  stbiw__lengtheb[]= { 0,0,0,0,0,0,0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4,  4,  5,  5,  5,  5,  0 };
+static unsigned short stbiw__distc[]   = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577, 32768 };
+static unsigned char  stbiw__disteb[]  = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
 unsigned char * stbi_zlib_compress(unsigned char *data, int data_len, int *out_len, int quality)
 {
-   static unsigned short lengthc[] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258, 259 };
-   static unsigned char  lengtheb[]= { 0,0,0,0,0,0,0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4,  4,  5,  5,  5,  5,  0 };
-   static unsigned short distc[]   = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577, 32768 };
-   static unsigned char  disteb[]  = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+   unsigned short *lengthc = stbiw__lengthc, *distc = stbiw__distc;
+   unsigned char *lengtheb = stbiw__lengtheb, *disteb = stbiw__disteb;
    unsigned int bitbuf=0;
    int i,j, bitcount=0;
    unsigned char *out = NULL;
@@ -896,6 +912,312 @@ static unsigned char stbiw__paeth(int a, int b, int c)
    return STBIW_UCHAR(c);
 }
 
+// fast PNG path: rows are split into bands that are filtered, deflated and
+// checksummed independently; each band becomes one IDAT chunk, and the bands
+// join into a single zlib stream because every band but the last ends on a
+// byte boundary with an empty stored block
+#define stbiw__PNG_BAND_BYTES  (1 << 18)
+#define stbiw__FHASH_BITS      15
+
+#ifndef STBIW_PARALLEL_FOR
+#define STBIW_PARALLEL_FOR(count,func,data) stbiw__parallel_for(count,func,data)
+
+static void stbiw__parallel_for(int count, void (*func)(void *, int), void *data)
+{
+   int i;
+#ifdef _OPENMP
+   #pragma omp parallel for schedule(dynamic)
+#endif
+   for (i=0; i < count; ++i)
+      func(data, i);
+}
+#endif
+
+typedef struct
+{
+   unsigned char *chunk;
+   int chunk_len;
+   int data_len;
+   unsigned int adler;
+} stbiw__png_band;
+
+typedef struct
+{
+   unsigned char *pixels;
+   int stride_bytes, x, y, n;
+   int rows_per_band, band_count, store;
+   unsigned short lit_code[288];
+   unsigned char lit_bits[288];
+   unsigned char len_sym[259];
+   unsigned char dist_sym[512];
+   unsigned char dist_code[30];
+   stbiw__png_band *bands;
+} stbiw__png_fast;
+
+static unsigned int stbiw__adler32(unsigned char *data, int len)
+{
+   unsigned int s1=1, s2=0;
+   int i, j=0, blocklen = len % 5552;
+   while (j < len) {
+      for (i=0; i < blocklen; ++i) s1 += data[j+i], s2 += s1;
+      s1 %= 65521, s2 %= 65521;
+      j += blocklen;
+      blocklen = 5552;
+   }
+   return (s2 << 16) | s1;
+}
+
+// checksum of A followed by B, from the checksums of A and B and the length of B
+static unsigned int stbiw__adler32_combine(unsigned int a, unsigned int b, int len_b)
+{
+   unsigned int rem = (unsigned int) len_b % 65521;
+   unsigned int s1 = a & 0xffff;
+   unsigned int s2 = (rem * s1) % 65521;
+   s1 += (b & 0xffff) + 65521 - 1;
+   s2 += (a >> 16) + (b >> 16) + 65521 - rem;
+   if (s1 >= 65521) s1 -= 65521;
+   if (s1 >= 65521) s1 -= 65521;
+   if (s2 >= 65521*2) s2 -= 65521*2;
+   if (s2 >= 65521) s2 -= 65521;
+   return (s2 << 16) | s1;
+}
+
+// one estimation pass picks Sub or Up; the top row of the image always uses Sub
+static void stbiw__png_fast_filter_row(unsigned char *out, unsigned char *z, int stride_bytes, int top, int n, int row_bytes)
+{
+   int i, est_sub=0, est_up=0;
+   if (!top) {
+      for (i=0; i < n; ++i) {
+         est_sub += abs((signed char) z[i]);
+         est_up  += abs((signed char) (z[i] - z[i-stride_bytes]));
+      }
+      for (i=n; i < row_bytes; ++i) {
+         est_sub += abs((signed char) (z[i] - z[i-n]));
+         est_up  += abs((signed char) (z[i] - z[i-stride_bytes]));
+      }
+   }
+   if (!top && est_up <= est_sub) {
+      out[0] = 2;
+      for (i=0; i < row_bytes; ++i) out[i+1] = STBIW_UCHAR(z[i] - z[i-stride_bytes]);
+   } else {
+      out[0] = 1;
+      for (i=0; i < n; ++i) out[i+1] = z[i];
+      for (i=n; i < row_bytes; ++i) out[i+1] = STBIW_UCHAR(z[i] - z[i-n]);
+   }
+}
+
+#define stbiw__fflush() \
+      do { while (bitcount >= 8) { *o++ = STBIW_UCHAR(bitbuf); bitbuf >>= 8; bitcount -= 8; } } while (0)
+#define stbiw__fput(code,codebits) \
+      do { bitbuf |= (unsigned int) (code) << bitcount; bitcount += (codebits); stbiw__fflush(); } while (0)
+
+// greedy deflate with one hash probe per position and fixed huffman codes
+static unsigned char *stbiw__png_fast_deflate(stbiw__png_fast *png, unsigned char *data, int len, int last, unsigned char *o)
+{
+   unsigned int bitbuf=0;
+   int bitcount=0, i=0;
+   int *table = (int *) STBIW_MALLOC(sizeof(int) << stbiw__FHASH_BITS);
+   if (!table) return NULL;
+   memset(table, 0xff, sizeof(int) << stbiw__FHASH_BITS);
+
+   stbiw__fput(last ? 1 : 0, 1); // BFINAL
+   stbiw__fput(1, 2);            // BTYPE = 1 -- fixed huffman
+
+   while (i < len-2) {
+      stbiw_uint32 h = (stbiw_uint32) (data[i] | (data[i+1] << 8) | (data[i+2] << 16)) * 2654435761u;
+      int cand, best = 0;
+      h >>= 32 - stbiw__FHASH_BITS;
+      cand = table[h];
+      table[h] = i;
+      if (cand >= 0 && i - cand < 32768 &&
+          data[cand] == data[i] && data[cand+1] == data[i+1] && data[cand+2] == data[i+2]) {
+         int limit = len - i < 258 ? len - i : 258;
+         best = 3;
+         while (best < limit && data[cand+best] == data[i+best]) ++best;
+      }
+      if (best) {
+         int d = i - cand, j = png->len_sym[best], k;
+         stbiw__fput(png->lit_code[257+j], png->lit_bits[257+j]);
+         if (stbiw__lengtheb[j]) stbiw__fput(best - stbiw__lengthc[j], stbiw__lengtheb[j]);
+         k = png->dist_sym[d <= 256 ? d-1 : 256 + ((d-1) >> 7)];
+         stbiw__fput(png->dist_code[k], 5);
+         if (stbiw__disteb[k]) stbiw__fput(d - stbiw__distc[k], stbiw__disteb[k]);
+         i += best;
+      } else {
+         stbiw__fput(png->lit_code[data[i]], png->lit_bits[data[i]]);
+         ++i;
+      }
+   }
+   for (; i < len; ++i)
+      stbiw__fput(png->lit_code[data[i]], png->lit_bits[data[i]]);
+   stbiw__fput(png->lit_code[256], png->lit_bits[256]); // end of block
+
+   if (!last) {
+      // empty stored block so the next band starts on a byte boundary
+      stbiw__fput(0, 3);
+      if (bitcount) stbiw__fput(0, 8 - bitcount);
+      *o++ = 0; *o++ = 0; *o++ = 0xff; *o++ = 0xff;
+   } else if (bitcount)
+      stbiw__fput(0, 8 - bitcount);
+
+   STBIW_FREE(table);
+   return o;
+}
+
+#undef stbiw__fput
+#undef stbiw__fflush
+
+static unsigned char *stbiw__png_fast_store(unsigned char *data, int len, int last, unsigned char *o)
+{
+   int i = 0;
+   do {
+      int block = len - i < 65535 ? len - i : 65535;
+      *o++ = STBIW_UCHAR(last && i + block == len);
+      *o++ = STBIW_UCHAR(block);
+      *o++ = STBIW_UCHAR(block >> 8);
+      *o++ = STBIW_UCHAR(~block);
+      *o++ = STBIW_UCHAR(~block >> 8);
+      STBIW_MEMMOVE(o, data + i, block);
+      o += block;
+      i += block;
+   } while (i < len);
+   return o;
+}
+
+static void stbiw__png_fast_band(void *context, int index)
+{
+   stbiw__png_fast *png = (stbiw__png_fast *) context;
+   stbiw__png_band *band = png->bands + index;
+   int row_bytes = png->x * png->n;
+   int y0 = index * png->rows_per_band;
+   int y1 = y0 + png->rows_per_band < png->y ? y0 + png->rows_per_band : png->y;
+   int len = (y1 - y0) * (row_bytes + 1), j;
+   int last = index == png->band_count - 1;
+   unsigned char *filt, *o, *start;
+
+   band->chunk = NULL;
+   filt = (unsigned char *) STBIW_MALLOC(len);
+   if (!filt) return;
+   for (j=y0; j < y1; ++j)
+      stbiw__png_fast_filter_row(filt + (j-y0)*(row_bytes+1), png->pixels + png->stride_bytes*j,
+                                 png->stride_bytes, j == 0, png->n, row_bytes);
+   band->adler = stbiw__adler32(filt, len);
+   band->data_len = len;
+
+   // worst case: 9 bits per literal plus block headers, the zlib header
+   // on the first band and 12 bytes of chunk overhead
+   band->chunk = (unsigned char *) STBIW_MALLOC(len + len/8 + 5*(len/65535+1) + 32);
+   if (!band->chunk) { STBIW_FREE(filt); return; }
+
+   o = start = band->chunk + 8;
+   if (index == 0) {
+      *o++ = 0x78; // DEFLATE 32K window
+      *o++ = 0x01; // FLEVEL = 0
+   }
+   if (png->store)
+      o = stbiw__png_fast_store(filt, len, last, o);
+   else
+      o = stbiw__png_fast_deflate(png, filt, len, last, o);
+   STBIW_FREE(filt);
+   if (!o) { STBIW_FREE(band->chunk); band->chunk = NULL; return; }
+
+   band->chunk_len = (int) (o - start) + 12;
+   o = band->chunk;
+   stbiw__wp32(o, band->chunk_len - 12);
+   stbiw__wptag(o, "IDAT");
+   o += band->chunk_len - 12;
+   stbiw__wpcrc(&o, band->chunk_len - 12);
+}
+
+static unsigned char *stbiw__png_fast_to_mem(unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len)
+{
+   int ctype[5] = { -1, 0, 4, 2, 6 };
+   unsigned char sig[8] = { 137,80,78,71,13,10,26,10 };
+   stbiw__png_fast *png;
+   unsigned char *out = NULL, *o;
+   unsigned int adler;
+   int i, j, len, failed = 0;
+
+   png = (stbiw__png_fast *) STBIW_MALLOC(sizeof(*png));
+   if (!png) return 0;
+   png->pixels = pixels;
+   png->stride_bytes = stride_bytes;
+   png->x = x, png->y = y, png->n = n;
+   png->store = stbi_write_png_fast >= 2;
+   png->rows_per_band = stbiw__PNG_BAND_BYTES / (x*n+1);
+   if (png->rows_per_band < 1) png->rows_per_band = 1;
+   png->band_count = (y + png->rows_per_band - 1) / png->rows_per_band;
+
+   for (i=0; i < 288; ++i) {
+      if (i <= 143)      png->lit_code[i] = (unsigned short) stbiw__zlib_bitrev(0x30 + i, 8),       png->lit_bits[i] = 8;
+      else if (i <= 255) png->lit_code[i] = (unsigned short) stbiw__zlib_bitrev(0x190 + i-144, 9), png->lit_bits[i] = 9;
+      else if (i <= 279) png->lit_code[i] = (unsigned short) stbiw__zlib_bitrev(i-256, 7),         png->lit_bits[i] = 7;
+      else               png->lit_code[i] = (unsigned short) stbiw__zlib_bitrev(0xc0 + i-280, 8),  png->lit_bits[i] = 8;
+   }
+   for (i=0; i < 29; ++i)
+      for (j=stbiw__lengthc[i]; j < stbiw__lengthc[i+1]; ++j)
+         png->len_sym[j] = (unsigned char) i;
+   for (i=0; i < 30; ++i) {
+      png->dist_code[i] = (unsigned char) stbiw__zlib_bitrev(i, 5);
+      for (j=stbiw__distc[i]-1; j < stbiw__distc[i+1]-1; ++j)
+         png->dist_sym[j < 256 ? j : 256 + (j >> 7)] = (unsigned char) i;
+   }
+
+   png->bands = (stbiw__png_band *) STBIW_MALLOC(sizeof(stbiw__png_band) * png->band_count);
+   if (!png->bands) { STBIW_FREE(png); return 0; }
+
+   STBIW_PARALLEL_FOR(png->band_count, stbiw__png_fast_band, png);
+
+   len = 8 + 12+13 + 12+4 + 12;
+   adler = 1;
+   for (i=0; i < png->band_count; ++i) {
+      if (!png->bands[i].chunk) { failed = 1; continue; }
+      len += png->bands[i].chunk_len;
+      adler = stbiw__adler32_combine(adler, png->bands[i].adler, png->bands[i].data_len);
+   }
+
+   if (!failed)
+      out = (unsigned char *) STBIW_MALLOC(len);
+   if (out) {
+      *out_len = len;
+      o = out;
+      STBIW_MEMMOVE(o,sig,8); o+= 8;
+      stbiw__wp32(o, 13); // header length
+      stbiw__wptag(o, "IHDR");
+      stbiw__wp32(o, x);
+      stbiw__wp32(o, y);
+      *o++ = 8;
+      *o++ = STBIW_UCHAR(ctype[n]);
+      *o++ = 0;
+      *o++ = 0;
+      *o++ = 0;
+      stbiw__wpcrc(&o,13);
+
+      for (i=0; i < png->band_count; ++i) {
+         STBIW_MEMMOVE(o, png->bands[i].chunk, png->bands[i].chunk_len);
+         o += png->bands[i].chunk_len;
+      }
+
+      // the zlib checksum goes into its own chunk once all bands are done
+      stbiw__wp32(o, 4);
+      stbiw__wptag(o, "IDAT");
+      stbiw__wp32(o, adler);
+      stbiw__wpcrc(&o, 4);
+
+      stbiw__wp32(o,0);
+      stbiw__wptag(o, "IEND");
+      stbiw__wpcrc(&o,0);
+
+      STBIW_ASSERT(o == out + *out_len);
+   }
+
+   for (i=0; i < png->band_count; ++i)
+      STBIW_FREE(png->bands[i].chunk);
+   STBIW_FREE(png->bands);
+   STBIW_FREE(png);
+   return out;
+}
+
 unsigned char *stbi_write_png_to_mem(unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len)
 {
    int ctype[5] = { -1, 0, 4, 2, 6 };
@@ -907,6 +1229,9 @@ unsigned char *stbi_write_png_to_mem(unsigned char *pixels, int stride_bytes, in
    if (stride_bytes == 0)
       stride_bytes = x * n;
 
+   if (stbi_write_png_fast)
+      return stbiw__png_fast_to_mem(pixels, stride_bytes, x, y, n, out_len);
+
    filt = (unsigned char *) STBIW_MALLOC((x*n+1) * y); if (!filt) return 0;
    line_buffer = (signed char *) STBIW_MALLOC(x * n); if (!line_buffer) { STBIW_FREE(filt); return 0; }
    for (j=0; j < y; ++j) {
@@ -0,0 +1,387 @@
+//========================================================================
+// Resource streaming with shared worker contexts for the GLFW examples
+// Copyright (c) 2026 agent <agent@local>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would
+//    be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not
+//    be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source
+//    distribution.
+//
+//========================================================================
+//
+// This is a single header for creating textures, buffers and other OpenGL
+// objects on background threads, each with a hidden window whose context
+// shares objects with the render context
+//
+// Each job has an upload function, called on a worker thread with its
+// context current, and a ready function, called on the render thread once
+// the commands of the upload function have completed on the GPU.  Workers
+// mark that point with a fence and wake up the render thread with
+// glfwPostEmptyEvent, and the render thread only checks the fences, so it
+// never waits for an upload or for the GPU
+//
+// Include it after glad, GLFW and tinycthread, with STREAMER_IMPLEMENTATION
+// defined in exactly one source file
+//
+// streamer_create and streamer_destroy must be called from the main thread,
+// as they create and destroy windows, and streamer_collect from the thread
+// where the render context is current.  Jobs may be submitted from any thread
+//
+// streamer_create resets the window hints to their defaults
+//
+// streamer_destroy discards jobs that have not been collected without calling
+// any of their functions, so anything their user data owns is leaked unless
+// the caller first collects until streamer_busy returns zero
+//
+//========================================================================
+
+#ifndef STREAMER_H
+#define STREAMER_H
+
+typedef struct Streamer Streamer;
+
+// Called on a worker thread, with a context sharing objects with the render
+// context current, to create or update OpenGL objects
+typedef void (*StreamerUploadFun)(void* user);
+// Called on the render thread once the objects are ready for use
+typedef void (*StreamerReadyFun)(void* user);
+
+Streamer* streamer_create(GLFWwindow* share, int worker_count);
+void streamer_destroy(Streamer* streamer);
+int streamer_submit(Streamer* streamer,
+                    StreamerUploadFun upload,
+                    StreamerReadyFun ready,
+                    void* user);
+int streamer_collect(Streamer* streamer);
+int streamer_busy(Streamer* streamer);
+
+#endif // STREAMER_H
+
+#if defined(STREAMER_IMPLEMENTATION)
+
+#include <stdlib.h>
+
+#define STREAMER_MAX_WORKERS 16
+
+typedef struct StreamerJob
+{
+    struct StreamerJob* next;
+    StreamerUploadFun upload;
+    StreamerReadyFun ready;
+    void* user;
+    // Signalled when the commands of the upload function have completed
+    GLsync fence;
+} StreamerJob;
+
+typedef struct StreamerWorker
+{
+    Streamer* streamer;
+    GLFWwindow* window;
+    thrd_t thread;
+} StreamerWorker;
+
+struct Streamer
+{
+    mtx_t lock;
+    cnd_t wakeup;
+    int quit;
+    // Jobs waiting for a worker, in submission order
+    StreamerJob* queued;
+    StreamerJob** queued_tail;
+    // Jobs uploaded by a worker, in completion order
+    StreamerJob* uploaded;
+    StreamerJob** uploaded_tail;
+    // Jobs whose fences have not yet been signalled, only touched by the
+    // render thread
+    StreamerJob* fenced;
+    // Jobs submitted but not yet collected
+    int busy;
+    int use_fences;
+    int worker_count;
+    StreamerWorker workers[STREAMER_MAX_WORKERS];
+};
+
+static int streamer_worker_main(void* arg)
+{
+    StreamerWorker* worker = arg;
+    Streamer* streamer = worker->streamer;
+
+    glfwMakeContextCurrent(worker->window);
+
+    mtx_lock(&streamer->lock);
+
+    for (;;)
+    {
+        StreamerJob* job;
+
+        while (!streamer->quit && !streamer->queued)
+            cnd_wait(&streamer->wakeup, &streamer->lock);
+
+        if (streamer->quit)
+            break;
+
+        job = streamer->queued;
+        streamer->queued = job->next;
+        if (!streamer->queued)
+            streamer->queued_tail = &streamer->queued;
+
+        mtx_unlock(&streamer->lock);
+
+        job->upload(job->user);
+
+        // The flush makes sure the fence reaches the GPU, so that waiting on
+        // it from another context cannot wait forever
+        if (streamer->use_fences)
+        {
+            job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+        }
+        else
+            glFinish();
+
+        mtx_lock(&streamer->lock);
+
+        job->next = NULL;
+        *streamer->uploaded_tail = job;
+        streamer->uploaded_tail = &job->next;
+
+        glfwPostEmptyEvent();
+    }
+
+    mtx_unlock(&streamer->lock);
+
+    glfwMakeContextCurrent(NULL);
+    return 0;
+}
+
+// Creates the specified number of workers with hidden windows sharing objects
+// with the specified window, using the current window hints
+//
+// GLFW has no way to query a hint, so the hint that keeps the workers' windows
+// hidden cannot be put back as it was.  Instead all window hints are reset to
+// their defaults with glfwDefaultWindowHints before this returns, and any the
+// caller needs for later windows must be set again
+//
+Streamer* streamer_create(GLFWwindow* share, int worker_count)
+{
+    int i;
+    Streamer* streamer;
+
+    if (worker_count < 1)
+        worker_count = 1;
+    if (worker_count > STREAMER_MAX_WORKERS)
+        worker_count = STREAMER_MAX_WORKERS;
+
+    streamer = calloc(1, sizeof(Streamer));
+    if (!streamer)
+        return NULL;
+
+    streamer->queued_tail = &streamer->queued;
+    streamer->uploaded_tail = &streamer->uploaded;
+
+    // Fences need OpenGL 3.2, otherwise each upload is finished on the worker
+    // before it is handed over
+    streamer->use_fences = GLAD_GL_VERSION_3_2;
+
+    mtx_init(&streamer->lock, mtx_plain);
+    cnd_init(&streamer->wakeup);
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    for (i = 0;  i < worker_count;  i++)
+    {
+        StreamerWorker* worker = streamer->workers + streamer->worker_count;
+
+        worker->streamer = streamer;
+        worker->window = glfwCreateWindow(1, 1, "Streamer", NULL, share);
+        if (!worker->window)
+            break;
+
+        if (thrd_create(&worker->thread, streamer_worker_main, worker) != thrd_success)
+        {
+            glfwDestroyWindow(worker->window);
+            break;
+        }
+
+        streamer->worker_count++;
+    }
+
+    glfwDefaultWindowHints();
+
+    if (!streamer->worker_count)
+    {
+        streamer_destroy(streamer);
+        return NULL;
+    }
+
+    return streamer;
+}
+
+// Stops the workers once they have finished their current jobs and discards
+// all jobs not yet collected, without calling their ready functions, so their
+// user data is not freed.  Collect until streamer_busy returns zero first to
+// have every job made ready
+//
+void streamer_destroy(Streamer* streamer)
+{
+    int i;
+    StreamerJob* lists[3];
+
+    if (!streamer)
+        return;
+
+    mtx_lock(&streamer->lock);
+    streamer->quit = GLFW_TRUE;
+    cnd_broadcast(&streamer->wakeup);
+    mtx_unlock(&streamer->lock);
+
+    for (i = 0;  i < streamer->worker_count;  i++)
+    {
+        thrd_join(streamer->workers[i].thread, NULL);
+        glfwDestroyWindow(streamer->workers[i].window);
+    }
+
+    lists[0] = streamer->queued;
+    lists[1] = streamer->uploaded;
+    lists[2] = streamer->fenced;
+
+    for (i = 0;  i < 3;  i++)
+    {
+        while (lists[i])
+        {
+            StreamerJob* job = lists[i];
+            lists[i] = job->next;
+
+            if (job->fence)
+                glDeleteSync(job->fence);
+
+            free(job);
+        }
+    }
+
+    cnd_destroy(&streamer->wakeup);
+    mtx_destroy(&streamer->lock);
+    free(streamer);
+}
+
+int streamer_submit(Streamer* streamer,
+                    StreamerUploadFun upload,
+                    StreamerReadyFun ready,
+                    void* user)
+{
+    StreamerJob* job = calloc(1, sizeof(StreamerJob));
+    if (!job)
+        return GLFW_FALSE;
+
+    job->upload = upload;
+    job->ready = ready;
+    job->user = user;
+
+    mtx_lock(&streamer->lock);
+
+    *streamer->queued_tail = job;
+    streamer->queued_tail = &job->next;
+    streamer->busy++;
+
+    cnd_signal(&streamer->wakeup);
+    mtx_unlock(&streamer->lock);
+
+    return GLFW_TRUE;
+}
+
+// Calls the ready function of each uploaded job whose fence has been
+// signalled, without waiting for the rest, and returns the number of jobs
+// made ready
+//
+int streamer_collect(Streamer* streamer)
+{
+    int count = 0;
+    StreamerJob* job;
+    StreamerJob* pending = NULL;
+    StreamerJob** pending_tail = &pending;
+
+    mtx_lock(&streamer->lock);
+
+    job = streamer->uploaded;
+    streamer->uploaded = NULL;
+    streamer->uploaded_tail = &streamer->uploaded;
+
+    mtx_unlock(&streamer->lock);
+
+    // Check the older jobs still waiting on their fences first
+    if (streamer->fenced)
+    {
+        StreamerJob* last = streamer->fenced;
+        while (last->next)
+            last = last->next;
+
+        last->next = job;
+        job = streamer->fenced;
+        streamer->fenced = NULL;
+    }
+
+    while (job)
+    {
+        StreamerJob* next = job->next;
+
+        if (job->fence)
+        {
+            const GLenum result = glClientWaitSync(job->fence, 0, 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+            {
+                job->next = NULL;
+                *pending_tail = job;
+                pending_tail = &job->next;
+                job = next;
+                continue;
+            }
+
+            glDeleteSync(job->fence);
+        }
+
+        if (job->ready)
+            job->ready(job->user);
+
+        free(job);
+        count++;
+        job = next;
+    }
+
+    streamer->fenced = pending;
+
+    mtx_lock(&streamer->lock);
+    streamer->busy -= count;
+    mtx_unlock(&streamer->lock);
+
+    return count;
+}
+
+// Returns the number of jobs submitted but not yet made ready
+//
+int streamer_busy(Streamer* streamer)
+{
+    int busy;
+
+    mtx_lock(&streamer->lock);
+    busy = streamer->busy;
+    mtx_unlock(&streamer->lock);
+
+    return busy;
+}
+
+#endif // STREAMER_IMPLEMENTATION
+
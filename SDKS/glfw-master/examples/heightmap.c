@@ -32,6 +32,11 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <getopt.h>
+
+#define PROFILER_IMPLEMENTATION
+#include <profiler.h>
+
 /* Map height updates */
 #define MAX_CIRCLE_SIZE (5.0f)
 #define MAX_DISPLACEMENT (1.0f)
@@ -396,9 +401,19 @@ static void error_callback(int error, const char* description)
     fprintf(stderr, "Error: %s\n", description);
 }
 
+static void usage(void)
+{
+    printf("Usage: heightmap [-h] [-o FILE]\n");
+    printf("Options:\n");
+    printf("  -h show this help\n");
+    printf("  -o write a Chrome trace of the last frames to FILE on exit\n");
+}
+
 int main(int argc, char** argv)
 {
     GLFWwindow* window;
+    int ch, zone, gpu_zone;
+    const char* trace_path = NULL;
     int iter;
     double dt;
     double last_update_time;
@@ -410,6 +425,22 @@ int main(int argc, char** argv)
 
     GLuint shader_program;
 
+    while ((ch = getopt(argc, argv, "ho:")) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+                usage();
+                exit(EXIT_SUCCESS);
+            case 'o':
+                trace_path = optarg;
+                break;
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
     glfwSetErrorCallback(error_callback);
 
     if (!glfwInit())
@@ -474,6 +505,9 @@ int main(int argc, char** argv)
     glViewport(0, 0, width, height);
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
+    if (trace_path)
+        profiler_init();
+
     /* main loop */
     frame = 0;
     iter = 0;
@@ -481,14 +515,26 @@ int main(int argc, char** argv)
 
     while (!glfwWindowShouldClose(window))
     {
+        profiler_begin_frame();
+
         ++frame;
         /* render the next frame */
+        zone = profiler_begin("Draw");
+        gpu_zone = profiler_begin_gpu("Draw");
         glClear(GL_COLOR_BUFFER_BIT);
         glDrawElements(GL_LINES, 2* MAP_NUM_LINES , GL_UNSIGNED_INT, 0);
+        profiler_end_gpu(gpu_zone);
+        profiler_end(zone);
 
         /* display and process events through callbacks */
+        zone = profiler_begin("Swap");
         glfwSwapBuffers(window);
+        profiler_end(zone);
+
+        zone = profiler_begin("Events");
         glfwPollEvents();
+        profiler_end(zone);
+
         /* Check the frame rate and update the heightmap if needed */
         dt = glfwGetTime();
         if ((dt - last_update_time) > 0.2)
@@ -496,15 +542,24 @@ int main(int argc, char** argv)
             /* generate the next iteration of the heightmap */
             if (iter < MAX_ITER)
             {
+                zone = profiler_begin("Update");
                 update_map(NUM_ITER_AT_A_TIME);
                 update_mesh();
+                profiler_end(zone);
                 iter += NUM_ITER_AT_A_TIME;
             }
             last_update_time = dt;
             frame = 0;
         }
+
+        profiler_end_frame();
     }
 
+    if (trace_path && !profiler_write_trace(trace_path))
+        fprintf(stderr, "Failed to write trace to %s\n", trace_path);
+
+    profiler_terminate();
+
     glfwTerminate();
     exit(EXIT_SUCCESS);
 }
@@ -23,6 +23,11 @@
 //
 //========================================================================
 
+#if defined(_MSC_VER)
+ // Make MS math.h define M_PI
+ #define _USE_MATH_DEFINES
+#endif
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -35,10 +40,49 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+ #include <unistd.h>
+#endif
+
+#include <tinycthread.h>
+#include <getopt.h>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
+#define MAX_ENCODERS 64
+
+// A rendered frame waiting to be encoded, stored bottom-up as read back
+typedef struct
+{
+    int index;
+    unsigned char* pixels;
+} Frame;
+
+// Bounded queue between the render thread and the encoder threads
+typedef struct
+{
+    Frame* frames;
+    int capacity;
+    int head;
+    int count;
+    int closed;
+    mtx_t lock;
+    cnd_t not_empty;
+    cnd_t not_full;
+} FrameQueue;
+
+static struct
+{
+    FrameQueue queue;
+    thrd_t threads[MAX_ENCODERS];
+    int count;
+    int width, height;
+    const char* pattern;
+} encoders;
+
 static const struct
 {
     float x, y;
@@ -70,20 +114,257 @@ static const char* fragment_shader_text =
 "    gl_FragColor = vec4(color, 1.0);\n"
 "}\n";
 
+static void usage(void)
+{
+    printf("Usage: offscreen [OPTION]...\n");
+    printf("Options:\n");
+    printf("  -c, --compression=MODE PNG compression: default, fast or store\n");
+    printf("  -f, --frames=COUNT     render COUNT frames of the animation\n");
+    printf("  -h, --help             show this help\n");
+    printf("  -j, --jobs=COUNT       use COUNT encoder threads\n");
+    printf("  -o, --output=PATTERN   printf pattern for the frame file names\n");
+    printf("  -q, --queue=COUNT      keep at most COUNT frames waiting to be encoded\n");
+    printf("  -s, --size=WxH         render frames of the specified size\n");
+}
+
 static void error_callback(int error, const char* description)
 {
     fprintf(stderr, "Error: %s\n", description);
 }
 
-int main(void)
+static int count_processors(void)
+{
+    int count = 1;
+
+#if defined(_WIN32)
+    const char* value = getenv("NUMBER_OF_PROCESSORS");
+    if (value)
+        count = atoi(value);
+#elif defined(_SC_NPROCESSORS_ONLN)
+    count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    if (count < 1)
+        count = 1;
+    if (count > MAX_ENCODERS)
+        count = MAX_ENCODERS;
+
+    return count;
+}
+
+static void init_queue(FrameQueue* queue, int capacity)
+{
+    queue->frames = calloc(capacity, sizeof(Frame));
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    queue->closed = GLFW_FALSE;
+
+    mtx_init(&queue->lock, mtx_plain);
+    cnd_init(&queue->not_empty);
+    cnd_init(&queue->not_full);
+}
+
+static void destroy_queue(FrameQueue* queue)
+{
+    cnd_destroy(&queue->not_full);
+    cnd_destroy(&queue->not_empty);
+    mtx_destroy(&queue->lock);
+    free(queue->frames);
+}
+
+// Blocks while the queue is full, which bounds the memory held by
+// frames the encoders have not caught up with yet
+static void push_frame(FrameQueue* queue, Frame frame)
+{
+    mtx_lock(&queue->lock);
+
+    while (queue->count == queue->capacity)
+        cnd_wait(&queue->not_full, &queue->lock);
+
+    queue->frames[(queue->head + queue->count) % queue->capacity] = frame;
+    queue->count++;
+
+    cnd_signal(&queue->not_empty);
+    mtx_unlock(&queue->lock);
+}
+
+// Returns GLFW_FALSE once the queue has been closed and drained
+static int pop_frame(FrameQueue* queue, Frame* frame)
+{
+    mtx_lock(&queue->lock);
+
+    while (queue->count == 0 && !queue->closed)
+        cnd_wait(&queue->not_empty, &queue->lock);
+
+    if (queue->count == 0)
+    {
+        mtx_unlock(&queue->lock);
+        return GLFW_FALSE;
+    }
+
+    *frame = queue->frames[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+
+    cnd_signal(&queue->not_full);
+    mtx_unlock(&queue->lock);
+    return GLFW_TRUE;
+}
+
+static void close_queue(FrameQueue* queue)
+{
+    mtx_lock(&queue->lock);
+    queue->closed = GLFW_TRUE;
+    cnd_broadcast(&queue->not_empty);
+    mtx_unlock(&queue->lock);
+}
+
+static int encoder_main(void* arg)
+{
+    const int stride = encoders.width * 4;
+    Frame frame;
+
+    while (pop_frame(&encoders.queue, &frame))
+    {
+        char path[1024];
+        snprintf(path, sizeof(path), encoders.pattern, frame.index);
+
+        // Write image Y-flipped because OpenGL
+        if (!stbi_write_png(path,
+                            encoders.width, encoders.height, 4,
+                            frame.pixels + stride * (encoders.height - 1),
+                            -stride))
+        {
+            fprintf(stderr, "Failed to write %s\n", path);
+        }
+
+        free(frame.pixels);
+    }
+
+    return 0;
+}
+
+static void start_encoders(int count, int capacity)
+{
+    int i;
+
+    init_queue(&encoders.queue, capacity);
+
+    encoders.count = 0;
+    for (i = 0;  i < count;  i++)
+    {
+        if (thrd_create(&encoders.threads[i], encoder_main, NULL) != thrd_success)
+            break;
+
+        encoders.count++;
+    }
+}
+
+static void stop_encoders(void)
+{
+    int i;
+
+    close_queue(&encoders.queue);
+
+    for (i = 0;  i < encoders.count;  i++)
+        thrd_join(encoders.threads[i], NULL);
+
+    destroy_queue(&encoders.queue);
+}
+
+int main(int argc, char** argv)
 {
+    int ch, frame_count = 1, job_count = 0, queue_size = 0;
+    int frame;
+    const char* pattern = NULL;
     GLFWwindow* window;
     GLuint vertex_buffer, vertex_shader, fragment_shader, program;
     GLint mvp_location, vpos_location, vcol_location;
     float ratio;
-    int width, height;
-    mat4x4 mvp;
-    char* buffer;
+    int width = 640, height = 480;
+    double start, elapsed;
+
+    enum { COMPRESSION, FRAMES, HELP, JOBS, OUTPUT, QUEUE, SIZE };
+    const struct option options[] =
+    {
+        { "compression", 1, NULL, COMPRESSION },
+        { "frames",      1, NULL, FRAMES },
+        { "help",        0, NULL, HELP },
+        { "jobs",        1, NULL, JOBS },
+        { "output",      1, NULL, OUTPUT },
+        { "queue",       1, NULL, QUEUE },
+        { "size",        1, NULL, SIZE },
+        { NULL, 0, NULL, 0 }
+    };
+
+    while ((ch = getopt_long(argc, argv, "c:f:hj:o:q:s:", options, NULL)) != -1)
+    {
+        switch (ch)
+        {
+            case 'c':
+            case COMPRESSION:
+                if (strcmp(optarg, "default") == 0)
+                    stbi_write_png_fast = 0;
+                else if (strcmp(optarg, "fast") == 0)
+                    stbi_write_png_fast = 1;
+                else if (strcmp(optarg, "store") == 0)
+                    stbi_write_png_fast = 2;
+                else
+                {
+                    usage();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'f':
+            case FRAMES:
+                frame_count = atoi(optarg);
+                break;
+            case 'h':
+            case HELP:
+                usage();
+                exit(EXIT_SUCCESS);
+            case 'j':
+            case JOBS:
+                job_count = atoi(optarg);
+                break;
+            case 'o':
+            case OUTPUT:
+                pattern = optarg;
+                break;
+            case 'q':
+            case QUEUE:
+                queue_size = atoi(optarg);
+                break;
+            case 's':
+            case SIZE:
+                if (sscanf(optarg, "%ix%i", &width, &height) != 2 ||
+                    width <= 0 || height <= 0)
+                {
+                    usage();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (frame_count < 1)
+        frame_count = 1;
+
+    if (job_count < 1)
+        job_count = count_processors();
+    if (job_count > MAX_ENCODERS)
+        job_count = MAX_ENCODERS;
+
+    // Let every encoder have one frame waiting by default
+    if (queue_size < 1)
+        queue_size = job_count;
+
+    if (!pattern)
+        pattern = frame_count > 1 ? "offscreen%04i.png" : "offscreen.png";
 
     glfwSetErrorCallback(error_callback);
 
@@ -96,7 +377,7 @@ int main(void)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
     glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
-    window = glfwCreateWindow(640, 480, "Simple example", NULL, NULL);
+    window = glfwCreateWindow(width, height, "Simple example", NULL, NULL);
     if (!window)
     {
         glfwTerminate();
@@ -140,33 +421,70 @@ int main(void)
     ratio = width / (float) height;
 
     glViewport(0, 0, width, height);
-    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(program);
 
-    mat4x4_ortho(mvp, -ratio, ratio, -1.f, 1.f, 1.f, -1.f);
+    encoders.width = width;
+    encoders.height = height;
+    encoders.pattern = pattern;
 
-    glUseProgram(program);
-    glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*) mvp);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+    start_encoders(job_count, queue_size);
+    if (!encoders.count)
+    {
+        fprintf(stderr, "Failed to create encoder threads\n");
+        destroy_queue(&encoders.queue);
+        glfwTerminate();
+        exit(EXIT_FAILURE);
+    }
 
-#if USE_NATIVE_OSMESA
-    glfwGetOSMesaColorBuffer(window, &width, &height, NULL, (void**) &buffer);
-#else
-    buffer = calloc(4, width * height);
-    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, buffer);
-#endif
+    start = glfwGetTime();
+
+    for (frame = 0;  frame < frame_count;  frame++)
+    {
+        // One full turn of the triangle over the whole sequence
+        const float angle = 2.f * (float) M_PI * frame / frame_count;
+        mat4x4 m, p, mvp;
+        Frame output;
 
-    // Write image Y-flipped because OpenGL
-    stbi_write_png("offscreen.png",
-                   width, height, 4,
-                   buffer + (width * 4 * (height - 1)),
-                   -width * 4);
+        mat4x4_identity(m);
+        mat4x4_rotate_Z(m, m, angle);
+        mat4x4_ortho(p, -ratio, ratio, -1.f, 1.f, 1.f, -1.f);
+        mat4x4_mul(mvp, p, m);
+
+        glClear(GL_COLOR_BUFFER_BIT);
+        glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*) mvp);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        // The encoders own each copy, so the next frame can be rendered
+        // while this one is still being compressed
+        output.index = frame;
+        output.pixels = malloc(width * height * 4);
 
 #if USE_NATIVE_OSMESA
-    // Here is where there's nothing
+        {
+            int buffer_width, buffer_height;
+            void* buffer;
+
+            glFinish();
+            glfwGetOSMesaColorBuffer(window, &buffer_width, &buffer_height,
+                                     NULL, &buffer);
+            memcpy(output.pixels, buffer, width * height * 4);
+        }
 #else
-    free(buffer);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, output.pixels);
 #endif
 
+        push_frame(&encoders.queue, output);
+    }
+
+    stop_encoders();
+
+    elapsed = glfwGetTime() - start;
+    if (frame_count > 1)
+    {
+        printf("Wrote %i frames with %i encoders in %.2f seconds (%.1f frames/s)\n",
+               frame_count, encoders.count, elapsed, frame_count / elapsed);
+    }
+
     glfwDestroyWindow(window);
 
     glfwTerminate();
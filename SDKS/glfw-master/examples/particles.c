@@ -42,6 +42,21 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#define NK_IMPLEMENTATION
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_FONT_BAKING
+#define NK_INCLUDE_DEFAULT_FONT
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+#define NK_INCLUDE_STANDARD_VARARGS
+#include <nuklear.h>
+
+#define NK_GLFW_GL2_IMPLEMENTATION
+#include <nuklear_glfw_gl2.h>
+
+#define PROFILER_IMPLEMENTATION
+#include <profiler.h>
+
 // Define tokens for GL_EXT_separate_specular_color if not already defined
 #ifndef GL_EXT_separate_specular_color
 #define GL_LIGHT_MODEL_COLOR_CONTROL_EXT  0x81F8
@@ -84,6 +99,10 @@ float aspect_ratio;
 // "wireframe" flag (true if we use wireframe view)
 int wireframe;
 
+// Profiler overlay, only set up when profiling
+struct nk_context* nk;
+int show_profiler;
+
 // Thread synchronization
 struct {
     double    t;         // Time (s)
@@ -224,13 +243,16 @@ const GLfloat fog_color[4]         = { 0.1f, 0.1f, 0.1f, 1.f };
 
 static void usage(void)
 {
-    printf("Usage: particles [-bfhs]\n");
+    printf("Usage: particles [-bfhps] [-o FILE]\n");
     printf("Options:\n");
     printf(" -f   Run in full screen\n");
     printf(" -h   Display this help\n");
+    printf(" -o   Write a Chrome trace of the last frames to FILE on exit\n");
+    printf(" -p   Show the profiler overlay\n");
     printf(" -s   Run program as single thread (default is to use two threads)\n");
     printf("\n");
     printf("Program runtime controls:\n");
+    printf(" P    Toggle profiler overlay (with -o or -p)\n");
     printf(" W    Toggle wireframe mode\n");
     printf(" Esc  Exit program\n");
 }
@@ -787,6 +809,7 @@ static void draw_scene(GLFWwindow* window, double t)
 {
     double xpos, ypos, zpos, angle_x, angle_y, angle_z;
     static double t_old = 0.0;
+    int zone, gpu_zone;
     float dt;
     mat4x4 projection;
 
@@ -837,19 +860,31 @@ static void draw_scene(GLFWwindow* window, double t)
     glFogf(GL_FOG_DENSITY, 0.05f);
     glFogfv(GL_FOG_COLOR, fog_color);
 
+    zone = profiler_begin("Floor");
+    gpu_zone = profiler_begin_gpu("Floor");
     draw_floor();
+    profiler_end_gpu(gpu_zone);
+    profiler_end(zone);
 
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
     glDepthMask(GL_TRUE);
 
+    zone = profiler_begin("Fountain");
+    gpu_zone = profiler_begin_gpu("Fountain");
     draw_fountain();
+    profiler_end_gpu(gpu_zone);
+    profiler_end(zone);
 
     glDisable(GL_LIGHTING);
     glDisable(GL_FOG);
 
     // Particles must be drawn after all solid objects have been drawn
+    zone = profiler_begin("Particles");
+    gpu_zone = profiler_begin_gpu("Particles");
     draw_particles(window, t, dt);
+    profiler_end_gpu(gpu_zone);
+    profiler_end(zone);
 
     // Z-buffer not needed anymore
     glDisable(GL_DEPTH_TEST);
@@ -885,6 +920,10 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
                 glPolygonMode(GL_FRONT_AND_BACK,
                               wireframe ? GL_LINE : GL_FILL);
                 break;
+            case GLFW_KEY_P:
+                if (nk)
+                    show_profiler = !show_profiler;
+                break;
             default:
                 break;
         }
@@ -940,10 +979,11 @@ static int physics_thread_main(void* arg)
 
 int main(int argc, char** argv)
 {
-    int ch, width, height;
+    int ch, width, height, zone;
     thrd_t physics_thread = 0;
     GLFWwindow* window;
     GLFWmonitor* monitor = NULL;
+    const char* trace_path = NULL;
 
     if (!glfwInit())
     {
@@ -951,13 +991,19 @@ int main(int argc, char** argv)
         exit(EXIT_FAILURE);
     }
 
-    while ((ch = getopt(argc, argv, "fh")) != -1)
+    while ((ch = getopt(argc, argv, "fho:p")) != -1)
     {
         switch (ch)
         {
             case 'f':
                 monitor = glfwGetPrimaryMonitor();
                 break;
+            case 'o':
+                trace_path = optarg;
+                break;
+            case 'p':
+                show_profiler = GLFW_TRUE;
+                break;
             case 'h':
                 usage();
                 exit(EXIT_SUCCESS);
@@ -1052,16 +1098,41 @@ int main(int argc, char** argv)
         exit(EXIT_FAILURE);
     }
 
+    if (show_profiler || trace_path)
+    {
+        profiler_init();
+        nk = profiler_overlay_init(window);
+    }
+
     glfwSetTime(0.0);
 
     while (!glfwWindowShouldClose(window))
     {
+        profiler_begin_frame();
+
+        zone = profiler_begin("Draw");
         draw_scene(window, glfwGetTime());
+        if (show_profiler)
+            profiler_overlay_draw(window);
+        profiler_end(zone);
 
+        zone = profiler_begin("Swap");
         glfwSwapBuffers(window);
+        profiler_end(zone);
+
+        zone = profiler_begin("Events");
         glfwPollEvents();
+        profiler_end(zone);
+
+        profiler_end_frame();
     }
 
+    if (trace_path && !profiler_write_trace(trace_path))
+        fprintf(stderr, "Failed to write trace to %s\n", trace_path);
+
+    profiler_terminate();
+    profiler_overlay_terminate();
+
     thrd_join(physics_thread, NULL);
 
     glfwDestroyWindow(window);
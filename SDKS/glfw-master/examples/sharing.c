@@ -29,9 +29,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "tinycthread.h"
 #include "getopt.h"
 #include "linmath.h"
 
+#define STREAMER_IMPLEMENTATION
+#include "streamer.h"
+
+// Seconds between texture uploads
+#define UPLOAD_INTERVAL 1.0
+
 static const char* vertex_shader_text =
 "#version 110\n"
 "uniform mat4 MVP;\n"
@@ -61,6 +68,97 @@ static const vec2 vertices[4] =
     { 0.f, 1.f }
 };
 
+typedef struct
+{
+    int size;
+    unsigned int seed;
+    GLuint texture;
+} TextureJob;
+
+typedef struct
+{
+    GLuint buffer;
+} BufferJob;
+
+// The most recently uploaded objects ready for rendering
+static GLuint texture, vertex_buffer;
+
+static void usage(void)
+{
+    printf("Usage: sharing [-h] [-s SIZE] [-t THREADS]\n");
+    printf("Options:\n");
+    printf("  -h show this help\n");
+    printf("  -s size in texels of each side of the uploaded textures (default 16)\n");
+    printf("  -t number of upload threads (default 2)\n");
+}
+
+// Creates a texture of random gray levels, on a worker thread
+//
+static void upload_texture(void* user)
+{
+    int i;
+    TextureJob* job = user;
+    unsigned char* pixels = malloc((size_t) job->size * job->size);
+
+    // rand is not thread safe, so use a generator with its state in the job
+    for (i = 0;  i < job->size * job->size;  i++)
+    {
+        job->seed = job->seed * 1103515245 + 12345;
+        pixels[i] = (unsigned char) (job->seed >> 16);
+    }
+
+    glGenTextures(1, &job->texture);
+    glBindTexture(GL_TEXTURE_2D, job->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, job->size, job->size, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    free(pixels);
+}
+
+// Replaces the drawn texture with the new one, on the render thread
+//
+static void texture_ready(void* user)
+{
+    TextureJob* job = user;
+
+    glDeleteTextures(1, &texture);
+    texture = job->texture;
+
+    free(job);
+}
+
+static void upload_vertex_buffer(void* user)
+{
+    BufferJob* job = user;
+
+    glGenBuffers(1, &job->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, job->buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void vertex_buffer_ready(void* user)
+{
+    BufferJob* job = user;
+
+    vertex_buffer = job->buffer;
+
+    free(job);
+}
+
+static void submit_texture(Streamer* streamer, int size)
+{
+    TextureJob* job = calloc(1, sizeof(TextureJob));
+    job->size = size;
+    job->seed = (unsigned int) glfwGetTimerValue();
+
+    if (!streamer_submit(streamer, upload_texture, texture_ready, job))
+        free(job);
+}
+
 static void error_callback(int error, const char* description)
 {
     fprintf(stderr, "Error: %s\n", description);
@@ -75,8 +173,37 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
 int main(int argc, char** argv)
 {
     GLFWwindow* windows[2];
-    GLuint texture, program, vertex_buffer;
+    GLuint program;
     GLint mvp_location, vpos_location, color_location, texture_location;
+    Streamer* streamer;
+    BufferJob* buffer_job;
+    int ch, size = 16, threads = 2;
+    double next_upload, timeout;
+
+    while ((ch = getopt(argc, argv, "hs:t:")) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+                usage();
+                exit(EXIT_SUCCESS);
+            case 's':
+                size = atoi(optarg);
+                break;
+            case 't':
+                threads = atoi(optarg);
+                break;
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (size < 1 || threads < 1)
+    {
+        usage();
+        exit(EXIT_FAILURE);
+    }
 
     glfwSetErrorCallback(error_callback);
 
@@ -105,28 +232,12 @@ int main(int argc, char** argv)
     // pointers should be re-usable between them
     gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
 
-    // Create the OpenGL objects inside the first context, created above
-    // All objects will be shared with the second context, created below
+    // Create the program inside the first context, created above
+    // All objects will be shared with the second context, created below, and
+    // with the upload contexts, which create the texture and vertex buffer
     {
-        int x, y;
-        char pixels[16 * 16];
         GLuint vertex_shader, fragment_shader;
 
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        srand((unsigned int) glfwGetTimerValue());
-
-        for (y = 0;  y < 16;  y++)
-        {
-            for (x = 0;  x < 16;  x++)
-                pixels[y * 16 + x] = rand() % 256;
-        }
-
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, 16, 16, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
         vertex_shader = glCreateShader(GL_VERTEX_SHADER);
         glShaderSource(vertex_shader, 1, &vertex_shader_text, NULL);
         glCompileShader(vertex_shader);
@@ -144,22 +255,13 @@ int main(int argc, char** argv)
         color_location = glGetUniformLocation(program, "color");
         texture_location = glGetUniformLocation(program, "texture");
         vpos_location = glGetAttribLocation(program, "vPos");
-
-        glGenBuffers(1, &vertex_buffer);
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
     }
 
     glUseProgram(program);
     glUniform1i(texture_location, 0);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
     glEnableVertexAttribArray(vpos_location);
-    glVertexAttribPointer(vpos_location, 2, GL_FLOAT, GL_FALSE,
-                          sizeof(vertices[0]), (void*) 0);
 
     windows[1] = glfwCreateWindow(400, 400, "Second", NULL, windows[0]);
     if (!windows[1])
@@ -189,12 +291,22 @@ int main(int argc, char** argv)
     glUseProgram(program);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
     glEnableVertexAttribArray(vpos_location);
-    glVertexAttribPointer(vpos_location, 2, GL_FLOAT, GL_FALSE,
-                          sizeof(vertices[0]), (void*) 0);
+
+    // The upload contexts are created with the same hints as the windows
+    streamer = streamer_create(windows[0], threads);
+    if (!streamer)
+    {
+        glfwTerminate();
+        exit(EXIT_FAILURE);
+    }
+
+    buffer_job = calloc(1, sizeof(BufferJob));
+    if (!streamer_submit(streamer, upload_vertex_buffer, vertex_buffer_ready, buffer_job))
+        free(buffer_job);
+
+    submit_texture(streamer, size);
+    next_upload = glfwGetTime() + UPLOAD_INTERVAL;
 
     while (!glfwWindowShouldClose(windows[0]) &&
            !glfwWindowShouldClose(windows[1]))
@@ -206,6 +318,21 @@ int main(int argc, char** argv)
             { 0.3f, 0.4f, 1.f }
         };
 
+        // Pick up the objects whose uploads have completed, without waiting
+        // for the rest
+        glfwMakeContextCurrent(windows[0]);
+        streamer_collect(streamer);
+
+        // Keep at most one texture in flight, so slow uploads are skipped
+        // rather than queued up
+        if (glfwGetTime() >= next_upload)
+        {
+            if (streamer_busy(streamer) == 0)
+                submit_texture(streamer, size);
+
+            next_upload = glfwGetTime() + UPLOAD_INTERVAL;
+        }
+
         for (i = 0;  i < 2;  i++)
         {
             int width, height;
@@ -216,6 +343,20 @@ int main(int argc, char** argv)
 
             glViewport(0, 0, width, height);
 
+            if (!texture || !vertex_buffer)
+            {
+                glClear(GL_COLOR_BUFFER_BIT);
+                glfwSwapBuffers(windows[i]);
+                continue;
+            }
+
+            // Objects made ready by another context must be bound again in
+            // this one for their new contents to be seen
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+            glVertexAttribPointer(vpos_location, 2, GL_FLOAT, GL_FALSE,
+                                  sizeof(vertices[0]), (void*) 0);
+
             mat4x4_ortho(mvp, 0.f, 1.f, 0.f, 1.f, 0.f, 1.f);
             glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*) mvp);
             glUniform3fv(color_location, 1, colors[i]);
@@ -224,9 +365,21 @@ int main(int argc, char** argv)
             glfwSwapBuffers(windows[i]);
         }
 
-        glfwWaitEvents();
+        // The workers post an empty event when an upload is done
+        timeout = next_upload - glfwGetTime();
+        glfwWaitEventsTimeout(timeout > 0.0 ? timeout : 0.0);
     }
 
+    // Let the jobs still in flight finish, so their ready functions free them
+    glfwMakeContextCurrent(windows[0]);
+    while (streamer_busy(streamer))
+    {
+        streamer_collect(streamer);
+        glfwWaitEventsTimeout(0.01);
+    }
+
+    streamer_destroy(streamer);
+
     glfwTerminate();
     exit(EXIT_SUCCESS);
 }
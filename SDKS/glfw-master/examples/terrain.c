@@ -0,0 +1,1364 @@
+//========================================================================
+// Chunked LOD terrain example program using OpenGL 3 core profile
+// Based on the heightmap example, Copyright (c) 2010 Olivier Delannoy
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would
+//    be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not
+//    be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source
+//    distribution.
+//
+//========================================================================
+//
+// The terrain is split into a quadtree of square chunks.  Every chunk, at
+// every level, is drawn as the same (CHUNK_QUADS + 1)^2 vertex grid; a chunk
+// at level L simply samples the heightfield with a stride of 2^L.  Each frame
+// the quadtree is refined where the screen-space projection of a chunk's
+// geometric error exceeds the pixel tolerance, and chunks outside the view
+// frustum are culled.
+//
+// Neighbouring chunks are kept at most one level apart.  When a neighbour is
+// one level coarser, the shared edge is drawn with an index buffer variant
+// that collapses every odd edge vertex onto its even predecessor, so the edge
+// matches the coarser chunk exactly and no cracks appear.  There are sixteen
+// such variants, one for each combination of stitched edges.
+//
+// Heights are read on demand from a memory-mapped file of raw little-endian
+// 16-bit samples, apart from one pass over the whole file on the first frame
+// that computes the height range and error of every chunk, and only the heights of resident chunks are kept on the GPU,
+// in an LRU cache, which grows only when a frame draws more chunks than it
+// holds.  Memory use is therefore bounded by the cache size and the quadtree
+// bookkeeping, not by the size of the heightfield.
+//
+//========================================================================
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(_WIN32)
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+#include <getopt.h>
+#include <linmath.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// Chunk geometry
+#define CHUNK_QUADS 64
+#define CHUNK_VERTICES (CHUNK_QUADS + 1)
+#define CHUNK_TOTAL_VERTICES (CHUNK_VERTICES * CHUNK_VERTICES)
+
+// Edge bits used to select a stitched index buffer variant
+#define EDGE_WEST  1
+#define EDGE_EAST  2
+#define EDGE_NORTH 4
+#define EDGE_SOUTH 8
+
+// Defaults for the command-line options
+#define DEFAULT_GENERATED_SIZE 2049
+#define DEFAULT_CACHE_CHUNKS 1024
+#define DEFAULT_PIXEL_ERROR 2.0f
+
+// Camera
+#define VIEW_ANGLE 1.0f
+#define Z_NEAR 0.5f
+#define MOVE_SPEED 0.25f
+
+
+//========================================================================
+// Type definitions
+//========================================================================
+
+// A square heightfield of 16-bit samples, either memory-mapped from a file
+// or generated in memory
+typedef struct
+{
+    int size;
+    const unsigned short* samples;
+    unsigned short* generated;
+    size_t length;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} Heightfield;
+
+enum
+{
+    NODE_UNVISITED,
+    NODE_SPLIT,
+    NODE_DRAWN,
+    NODE_CULLED
+};
+
+// Quadtree node bookkeeping; the geometry itself lives in the chunk cache
+typedef struct
+{
+    float error;
+    float min_y, max_y;
+    int slot;
+    unsigned char has_bounds;
+    unsigned char state;
+    unsigned char edges;
+} Node;
+
+typedef struct
+{
+    int level, x, z;
+} NodeRef;
+
+typedef struct
+{
+    NodeRef* items;
+    int count;
+    int capacity;
+} NodeList;
+
+
+//========================================================================
+// Program state
+//========================================================================
+
+static Heightfield heightfield;
+
+// Quadtree layout
+static int root_chunks;
+static int max_level;
+static int level_offset[32];
+static Node* nodes;
+
+// World scale
+static float cell_spacing = 1.f;
+static float height_scale = 0.f;
+static float extent;
+
+// Level-of-detail selection
+static float pixel_error = DEFAULT_PIXEL_ERROR;
+static float lod_factor;
+static NodeList touched_nodes;
+static NodeList drawn_nodes;
+
+// Chunk cache
+static int cache_chunks = DEFAULT_CACHE_CHUNKS;
+static int* slot_owner;
+static unsigned int* slot_frame;
+static unsigned int frame_count;
+static int uploads;
+
+// GL objects
+static GLuint program;
+static GLuint vertex_array;
+static GLuint grid_buffer;
+static GLuint height_buffer;
+static GLuint index_buffer;
+static GLint height_location;
+static GLint uloc_origin;
+static GLint uloc_scale;
+static GLint uloc_extent;
+static GLint uloc_mvp;
+static GLint uloc_eye;
+static GLsizei index_count[16];
+static size_t index_offset[16];
+
+// Camera and input
+static vec3 eye_position;
+static float yaw = 0.7f, pitch = -0.3f;
+static double cursor_x, cursor_y;
+static int rotating;
+static int wireframe;
+static int window_width, window_height;
+
+
+//========================================================================
+// Shaders
+//========================================================================
+
+static const char* vertex_shader_text =
+"#version 150\n"
+"uniform mat4 mvp;\n"
+"uniform vec2 origin;\n"
+"uniform float scale;\n"
+"uniform float extent;\n"
+"in vec2 grid;\n"
+"in float height;\n"
+"out vec3 position;\n"
+"void main()\n"
+"{\n"
+"    vec2 xz = min(origin + grid * scale, vec2(extent));\n"
+"    position = vec3(xz.x, height, xz.y);\n"
+"    gl_Position = mvp * vec4(position, 1.0);\n"
+"}\n";
+
+static const char* fragment_shader_text =
+"#version 150\n"
+"uniform vec3 eye;\n"
+"uniform float extent;\n"
+"in vec3 position;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"    vec3 normal = normalize(cross(dFdx(position), dFdy(position)));\n"
+"    float light = 0.3 + 0.7 * abs(dot(normal, normalize(vec3(0.4, 1.0, 0.3))));\n"
+"    float fog = clamp(length(position - eye) / extent, 0.0, 1.0);\n"
+"    vec3 base = mix(vec3(0.2, 0.5, 0.2), vec3(0.6, 0.55, 0.5), smoothstep(0.9, 0.7, abs(normal.y)));\n"
+"    color = vec4(mix(base * light, vec3(0.6, 0.7, 0.8), fog), 1.0);\n"
+"}\n";
+
+
+//========================================================================
+// Print usage information
+//========================================================================
+
+static void usage(void)
+{
+    printf("Usage: terrain [-h] [-c CHUNKS] [-d SPACING] [-e PIXELS] [-s SIZE] [-v SCALE] [FILE]\n");
+    printf("Options:\n");
+    printf(" -c   Initial number of chunks kept in the GPU cache (default %i)\n", DEFAULT_CACHE_CHUNKS);
+    printf(" -d   Horizontal distance between samples (default 1)\n");
+    printf(" -e   Maximum screen-space error in pixels (default %.1f)\n", DEFAULT_PIXEL_ERROR);
+    printf(" -h   Display this help\n");
+    printf(" -s   Size of the generated heightfield when no file is given (default %i)\n",
+           DEFAULT_GENERATED_SIZE);
+    printf(" -v   Height of the largest sample value (default a tenth of the terrain size)\n");
+    printf("\n");
+    printf("FILE is a square heightfield of raw little-endian 16-bit samples.\n");
+    printf("\n");
+    printf("Program runtime controls:\n");
+    printf(" WASD       Move\n");
+    printf(" Q/E        Move down/up\n");
+    printf(" Mouse      Look around while holding the left button\n");
+    printf(" Space      Toggle wireframe mode\n");
+    printf(" +/-        Change the pixel error tolerance\n");
+    printf(" Esc        Exit program\n");
+}
+
+
+//========================================================================
+// Heightfield sources
+//========================================================================
+
+static int open_heightfield(Heightfield* hf, const char* path)
+{
+    size_t count;
+
+    memset(hf, 0, sizeof(Heightfield));
+
+#if defined(_WIN32)
+    {
+        LARGE_INTEGER size;
+
+        hf->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+        if (hf->file == INVALID_HANDLE_VALUE)
+        {
+            fprintf(stderr, "Failed to open %s\n", path);
+            return GLFW_FALSE;
+        }
+
+        GetFileSizeEx(hf->file, &size);
+        hf->length = (size_t) size.QuadPart;
+
+        hf->mapping = CreateFileMappingA(hf->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!hf->mapping)
+        {
+            fprintf(stderr, "Failed to map %s\n", path);
+            CloseHandle(hf->file);
+            return GLFW_FALSE;
+        }
+
+        hf->samples = MapViewOfFile(hf->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!hf->samples)
+        {
+            fprintf(stderr, "Failed to map %s\n", path);
+            CloseHandle(hf->mapping);
+            CloseHandle(hf->file);
+            return GLFW_FALSE;
+        }
+    }
+#else
+    {
+        struct stat st;
+        void* address;
+
+        hf->fd = open(path, O_RDONLY);
+        if (hf->fd == -1)
+        {
+            fprintf(stderr, "Failed to open %s\n", path);
+            return GLFW_FALSE;
+        }
+
+        fstat(hf->fd, &st);
+        hf->length = (size_t) st.st_size;
+
+        address = mmap(NULL, hf->length, PROT_READ, MAP_SHARED, hf->fd, 0);
+        if (address == MAP_FAILED)
+        {
+            fprintf(stderr, "Failed to map %s\n", path);
+            close(hf->fd);
+            return GLFW_FALSE;
+        }
+
+        // Chunks are sampled sparsely, so read-ahead would only waste memory
+        madvise(address, hf->length, MADV_RANDOM);
+        hf->samples = address;
+    }
+#endif
+
+    count = hf->length / sizeof(unsigned short);
+    hf->size = (int) sqrt((double) count);
+    while ((size_t) hf->size * hf->size > count)
+        hf->size--;
+    while ((size_t) (hf->size + 1) * (hf->size + 1) <= count)
+        hf->size++;
+
+    if (hf->size < 2 || (size_t) hf->size * hf->size != count)
+        fprintf(stderr, "%s is not a square heightfield, using the first %i rows\n", path, hf->size);
+
+    return hf->size >= 2;
+}
+
+static float lattice_noise(int x, int z)
+{
+    unsigned int h = (unsigned int) x * 374761393u + (unsigned int) z * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return (float) ((h ^ (h >> 16)) & 0xffff) / 65535.f;
+}
+
+static float value_noise(float x, float z)
+{
+    const int ix = (int) floorf(x), iz = (int) floorf(z);
+    const float fx = x - ix, fz = z - iz;
+    const float sx = fx * fx * (3.f - 2.f * fx), sz = fz * fz * (3.f - 2.f * fz);
+    const float a = lattice_noise(ix, iz), b = lattice_noise(ix + 1, iz);
+    const float c = lattice_noise(ix, iz + 1), d = lattice_noise(ix + 1, iz + 1);
+    return (a + (b - a) * sx) + ((c + (d - c) * sx) - (a + (b - a) * sx)) * sz;
+}
+
+static void generate_heightfield(Heightfield* hf, int size)
+{
+    int x, z;
+
+    memset(hf, 0, sizeof(Heightfield));
+    hf->size = size;
+    hf->generated = calloc((size_t) size * size, sizeof(unsigned short));
+    hf->samples = hf->generated;
+
+    for (z = 0;  z < size;  z++)
+    {
+        for (x = 0;  x < size;  x++)
+        {
+            float sum = 0.f, amplitude = 0.5f, frequency = 4.f / size;
+            int octave;
+
+            for (octave = 0;  octave < 8;  octave++)
+            {
+                sum += amplitude * value_noise(x * frequency, z * frequency);
+                amplitude *= 0.5f;
+                frequency *= 2.f;
+            }
+
+            hf->generated[(size_t) z * size + x] = (unsigned short) (sum * sum * 65535.f);
+        }
+    }
+}
+
+static void close_heightfield(Heightfield* hf)
+{
+    if (hf->generated)
+    {
+        free(hf->generated);
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(hf->samples);
+    CloseHandle(hf->mapping);
+    CloseHandle(hf->file);
+#else
+    munmap((void*) hf->samples, hf->length);
+    close(hf->fd);
+#endif
+}
+
+// Returns the world height of the specified sample, clamping to the edges
+static float sample_height(int x, int z)
+{
+    const int last = heightfield.size - 1;
+    const unsigned char* bytes;
+
+    if (x > last)
+        x = last;
+    if (z > last)
+        z = last;
+
+    // The file is little-endian regardless of the host
+    bytes = (const unsigned char*) (heightfield.samples + (size_t) z * heightfield.size + x);
+    return (bytes[0] | (bytes[1] << 8)) * height_scale;
+}
+
+
+//========================================================================
+// Quadtree
+//========================================================================
+
+static int node_index(int level, int x, int z)
+{
+    return level_offset[level] + z * (root_chunks >> level) + x;
+}
+
+static int node_exists(int level, int x, int z)
+{
+    const int chunks = root_chunks >> level;
+    const int samples = CHUNK_QUADS << level;
+
+    return x >= 0 && z >= 0 && x < chunks && z < chunks &&
+           x * samples < heightfield.size - 1 && z * samples < heightfield.size - 1;
+}
+
+static void create_quadtree(void)
+{
+    int level, count = 0;
+
+    root_chunks = 1;
+    max_level = 0;
+    while (root_chunks * CHUNK_QUADS < heightfield.size - 1)
+    {
+        root_chunks *= 2;
+        max_level++;
+    }
+
+    for (level = 0;  level <= max_level;  level++)
+    {
+        const int chunks = root_chunks >> level;
+        level_offset[level] = count;
+        count += chunks * chunks;
+    }
+
+    nodes = calloc(count, sizeof(Node));
+    for (level = 0;  level < count;  level++)
+        nodes[level].slot = -1;
+
+    extent = (heightfield.size - 1) * cell_spacing;
+}
+
+// Computes the height range of a chunk and its geometric error, which is the
+// largest vertical distance between the chunk surface and the surface of its
+// children
+//
+// The bounds of the children are computed first and merged in, so the range
+// covers every finer sample below the chunk and the error never grows on the
+// way down the tree.  A culled chunk then has no visible descendants, and a
+// chunk accurate enough to draw has no descendant that would differ from it
+// by more than its error
+static void compute_node_bounds(Node* node, int level, int x, int z)
+{
+    const int stride = 1 << level;
+    const int sx = x * (CHUNK_QUADS << level), sz = z * (CHUNK_QUADS << level);
+    int i, j;
+
+    node->min_y = node->max_y = sample_height(sx, sz);
+    node->error = 0.f;
+    node->has_bounds = GLFW_TRUE;
+
+    for (j = 0;  j < CHUNK_VERTICES;  j++)
+    {
+        for (i = 0;  i < CHUNK_VERTICES;  i++)
+        {
+            const float y = sample_height(sx + i * stride, sz + j * stride);
+            if (y < node->min_y)
+                node->min_y = y;
+            if (y > node->max_y)
+                node->max_y = y;
+        }
+    }
+
+    if (level == 0)
+        return;
+
+    // Odd samples of the child grid lie on the edges and diagonals of the
+    // triangles drawn for this chunk, so compare them to their midpoints
+    for (j = 0;  j <= CHUNK_QUADS * 2;  j++)
+    {
+        for (i = 0;  i <= CHUNK_QUADS * 2;  i++)
+        {
+            const int half = stride / 2;
+            const int px = sx + i * half, pz = sz + j * half;
+            float y, expected;
+
+            if (!(i & 1) && !(j & 1))
+                continue;
+
+            y = sample_height(px, pz);
+            if (y < node->min_y)
+                node->min_y = y;
+            if (y > node->max_y)
+                node->max_y = y;
+
+            if ((i & 1) && (j & 1))
+            {
+                expected = (sample_height(px - half, pz - half) +
+                            sample_height(px + half, pz + half)) * 0.5f;
+            }
+            else if (i & 1)
+            {
+                expected = (sample_height(px - half, pz) +
+                            sample_height(px + half, pz)) * 0.5f;
+            }
+            else
+            {
+                expected = (sample_height(px, pz - half) +
+                            sample_height(px, pz + half)) * 0.5f;
+            }
+
+            if (fabsf(y - expected) > node->error)
+                node->error = fabsf(y - expected);
+        }
+    }
+
+    for (i = 0;  i < 4;  i++)
+    {
+        const int cx = x * 2 + (i & 1), cz = z * 2 + (i >> 1);
+        Node* child;
+
+        if (!node_exists(level - 1, cx, cz))
+            continue;
+
+        child = nodes + node_index(level - 1, cx, cz);
+        if (!child->has_bounds)
+            compute_node_bounds(child, level - 1, cx, cz);
+
+        if (child->min_y < node->min_y)
+            node->min_y = child->min_y;
+        if (child->max_y > node->max_y)
+            node->max_y = child->max_y;
+        if (child->error > node->error)
+            node->error = child->error;
+    }
+}
+
+static void push_node(NodeList* list, int level, int x, int z)
+{
+    if (list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 256;
+        list->items = realloc(list->items, list->capacity * sizeof(NodeRef));
+    }
+
+    list->items[list->count].level = level;
+    list->items[list->count].x = x;
+    list->items[list->count].z = z;
+    list->count++;
+}
+
+static void node_box(const Node* node, int level, int x, int z, vec3 lo, vec3 hi)
+{
+    const float size = (CHUNK_QUADS << level) * cell_spacing;
+
+    lo[0] = x * size;
+    lo[1] = node->min_y;
+    lo[2] = z * size;
+    hi[0] = fminf(lo[0] + size, extent);
+    hi[1] = node->max_y;
+    hi[2] = fminf(lo[2] + size, extent);
+}
+
+static int box_in_frustum(vec4 planes[6], vec3 lo, vec3 hi)
+{
+    int i;
+
+    for (i = 0;  i < 6;  i++)
+    {
+        const float px = planes[i][0] > 0.f ? hi[0] : lo[0];
+        const float py = planes[i][1] > 0.f ? hi[1] : lo[1];
+        const float pz = planes[i][2] > 0.f ? hi[2] : lo[2];
+
+        if (planes[i][0] * px + planes[i][1] * py + planes[i][2] * pz + planes[i][3] < 0.f)
+            return GLFW_FALSE;
+    }
+
+    return GLFW_TRUE;
+}
+
+static float box_distance(vec3 lo, vec3 hi)
+{
+    vec3 d;
+    int i;
+
+    for (i = 0;  i < 3;  i++)
+    {
+        if (eye_position[i] < lo[i])
+            d[i] = lo[i] - eye_position[i];
+        else if (eye_position[i] > hi[i])
+            d[i] = eye_position[i] - hi[i];
+        else
+            d[i] = 0.f;
+    }
+
+    return vec3_len(d);
+}
+
+// Marks a node as drawn or culled, depending on the frustum
+static void classify_node(vec4 planes[6], int level, int x, int z)
+{
+    Node* node = nodes + node_index(level, x, z);
+    vec3 lo, hi;
+
+    if (!node->has_bounds)
+        compute_node_bounds(node, level, x, z);
+
+    node_box(node, level, x, z, lo, hi);
+
+    if (node->state == NODE_UNVISITED)
+        push_node(&touched_nodes, level, x, z);
+
+    if (box_in_frustum(planes, lo, hi))
+    {
+        node->state = NODE_DRAWN;
+        push_node(&drawn_nodes, level, x, z);
+    }
+    else
+        node->state = NODE_CULLED;
+}
+
+static void select_nodes(vec4 planes[6], int level, int x, int z)
+{
+    Node* node;
+    vec3 lo, hi;
+    int i;
+
+    if (!node_exists(level, x, z))
+        return;
+
+    classify_node(planes, level, x, z);
+
+    node = nodes + node_index(level, x, z);
+    if (node->state != NODE_DRAWN || level == 0)
+        return;
+
+    node_box(node, level, x, z, lo, hi);
+    if (node->error * lod_factor <= pixel_error * fmaxf(box_distance(lo, hi), Z_NEAR))
+        return;
+
+    node->state = NODE_SPLIT;
+    drawn_nodes.count--;
+
+    for (i = 0;  i < 4;  i++)
+        select_nodes(planes, level - 1, x * 2 + (i & 1), z * 2 + (i >> 1));
+}
+
+// Returns the drawn or culled node covering the specified same-level position,
+// or NULL if that area is covered by finer nodes or lies outside the terrain
+static Node* find_leaf(int* level, int* x, int* z)
+{
+    if (!node_exists(*level, *x, *z))
+        return NULL;
+
+    while (*level <= max_level)
+    {
+        Node* node = nodes + node_index(*level, *x, *z);
+
+        if (node->state == NODE_SPLIT)
+            return NULL;
+        if (node->state != NODE_UNVISITED)
+            return node;
+
+        (*level)++;
+        *x /= 2;
+        *z /= 2;
+    }
+
+    return NULL;
+}
+
+// Splits drawn nodes until no drawn node has a neighbour more than one level
+// coarser than itself, then records which edges need stitching
+static void restrict_nodes(vec4 planes[6])
+{
+    static const int dx[4] = { -1, 1, 0, 0 };
+    static const int dz[4] = { 0, 0, -1, 1 };
+    static const unsigned char bits[4] = { EDGE_WEST, EDGE_EAST, EDGE_NORTH, EDGE_SOUTH };
+    int i, j, count;
+
+    // Newly split nodes append their children, which are checked in turn
+    for (i = 0;  i < drawn_nodes.count;  i++)
+    {
+        const NodeRef ref = drawn_nodes.items[i];
+
+        if (nodes[node_index(ref.level, ref.x, ref.z)].state != NODE_DRAWN)
+            continue;
+
+        for (j = 0;  j < 4;  j++)
+        {
+            int level = ref.level, x = ref.x + dx[j], z = ref.z + dz[j], k;
+            Node* neighbor = find_leaf(&level, &x, &z);
+
+            if (!neighbor || neighbor->state != NODE_DRAWN || level <= ref.level + 1)
+                continue;
+
+            neighbor->state = NODE_SPLIT;
+            for (k = 0;  k < 4;  k++)
+            {
+                const int cx = x * 2 + (k & 1), cz = z * 2 + (k >> 1);
+                if (node_exists(level - 1, cx, cz))
+                    classify_node(planes, level - 1, cx, cz);
+            }
+
+            // Re-check this node, as the split neighbour may still be too coarse
+            j--;
+        }
+    }
+
+    // Compact the list and compute the stitched edges of each remaining node
+    count = 0;
+    for (i = 0;  i < drawn_nodes.count;  i++)
+    {
+        const NodeRef ref = drawn_nodes.items[i];
+        Node* node = nodes + node_index(ref.level, ref.x, ref.z);
+
+        if (node->state != NODE_DRAWN)
+            continue;
+
+        node->edges = 0;
+        for (j = 0;  j < 4;  j++)
+        {
+            int level = ref.level, x = ref.x + dx[j], z = ref.z + dz[j];
+            const Node* neighbor = find_leaf(&level, &x, &z);
+
+            if (neighbor && neighbor->state == NODE_DRAWN && level == ref.level + 1)
+                node->edges |= bits[j];
+        }
+
+        drawn_nodes.items[count++] = ref;
+    }
+
+    drawn_nodes.count = count;
+}
+
+static void reset_nodes(void)
+{
+    int i;
+
+    for (i = 0;  i < touched_nodes.count;  i++)
+    {
+        const NodeRef ref = touched_nodes.items[i];
+        nodes[node_index(ref.level, ref.x, ref.z)].state = NODE_UNVISITED;
+    }
+
+    touched_nodes.count = 0;
+    drawn_nodes.count = 0;
+}
+
+
+//========================================================================
+// Chunk cache
+//========================================================================
+
+static void create_cache(void)
+{
+    int i;
+
+    slot_owner = calloc(cache_chunks, sizeof(int));
+    slot_frame = calloc(cache_chunks, sizeof(unsigned int));
+
+    for (i = 0;  i < cache_chunks;  i++)
+        slot_owner[i] = -1;
+
+    glGenBuffers(1, &height_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, height_buffer);
+    glBufferData(GL_ARRAY_BUFFER,
+                 (GLsizeiptr) cache_chunks * CHUNK_TOTAL_VERTICES * sizeof(GLfloat),
+                 NULL, GL_DYNAMIC_DRAW);
+}
+
+// Doubles the number of cache slots, keeping the chunks already resident
+static void grow_cache(void)
+{
+    const GLsizeiptr size = (GLsizeiptr) cache_chunks * CHUNK_TOTAL_VERTICES * sizeof(GLfloat);
+    const int count = cache_chunks * 2;
+    GLuint buffer;
+    int i;
+
+    slot_owner = realloc(slot_owner, count * sizeof(int));
+    slot_frame = realloc(slot_frame, count * sizeof(unsigned int));
+
+    for (i = cache_chunks;  i < count;  i++)
+    {
+        slot_owner[i] = -1;
+        slot_frame[i] = 0;
+    }
+
+    // Draws already issued this frame still read the old buffer
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, size * 2, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, height_buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glDeleteBuffers(1, &height_buffer);
+    height_buffer = buffer;
+    glBindBuffer(GL_ARRAY_BUFFER, height_buffer);
+
+    printf("Chunk cache grown to %i chunks, as %i were drawn in one frame\n",
+           count, cache_chunks + 1);
+
+    cache_chunks = count;
+}
+
+// Returns the cache slot holding the heights of the specified node, uploading
+// them into the least recently used slot if necessary.  The cache grows when
+// every slot is already used by the current frame
+static int acquire_slot(int level, int x, int z)
+{
+    const int index = node_index(level, x, z);
+    Node* node = nodes + index;
+    GLfloat heights[CHUNK_TOTAL_VERTICES];
+    const int stride = 1 << level;
+    const int sx = x * (CHUNK_QUADS << level), sz = z * (CHUNK_QUADS << level);
+    int i, j, slot = -1;
+
+    if (node->slot == -1)
+    {
+        for (i = 0;  i < cache_chunks;  i++)
+        {
+            if (slot_owner[i] == -1)
+            {
+                slot = i;
+                break;
+            }
+
+            if (slot_frame[i] != frame_count &&
+                (slot == -1 || slot_frame[i] < slot_frame[slot]))
+            {
+                slot = i;
+            }
+        }
+
+        // Every slot is in use by this frame
+        if (slot == -1)
+        {
+            slot = cache_chunks;
+            grow_cache();
+        }
+
+        if (slot_owner[slot] != -1)
+            nodes[slot_owner[slot]].slot = -1;
+
+        for (j = 0;  j < CHUNK_VERTICES;  j++)
+        {
+            for (i = 0;  i < CHUNK_VERTICES;  i++)
+                heights[j * CHUNK_VERTICES + i] = sample_height(sx + i * stride, sz + j * stride);
+        }
+
+        glBufferSubData(GL_ARRAY_BUFFER,
+                        (GLintptr) slot * sizeof(heights),
+                        sizeof(heights), heights);
+
+        slot_owner[slot] = index;
+        node->slot = slot;
+        uploads++;
+    }
+
+    slot_frame[node->slot] = frame_count;
+    return node->slot;
+}
+
+
+//========================================================================
+// Geometry creation
+//========================================================================
+
+// Maps a vertex index onto its even predecessor along stitched edges
+static int stitch_vertex(int i, int j, int edges)
+{
+    if ((i & 1) && (((edges & EDGE_NORTH) && j == 0) ||
+                    ((edges & EDGE_SOUTH) && j == CHUNK_QUADS)))
+    {
+        i--;
+    }
+
+    if ((j & 1) && (((edges & EDGE_WEST) && i == 0) ||
+                    ((edges & EDGE_EAST) && i == CHUNK_QUADS)))
+    {
+        j--;
+    }
+
+    return j * CHUNK_VERTICES + i;
+}
+
+static void make_mesh(void)
+{
+    GLfloat* grid;
+    GLushort* indices;
+    GLsizei count = 0;
+    int edges, i, j, k;
+
+    grid = calloc(CHUNK_TOTAL_VERTICES * 2, sizeof(GLfloat));
+    for (j = 0;  j < CHUNK_VERTICES;  j++)
+    {
+        for (i = 0;  i < CHUNK_VERTICES;  i++)
+        {
+            grid[(j * CHUNK_VERTICES + i) * 2 + 0] = (GLfloat) i;
+            grid[(j * CHUNK_VERTICES + i) * 2 + 1] = (GLfloat) j;
+        }
+    }
+
+    // Two triangles per quad, both sharing the (i,j)-(i+1,j+1) diagonal
+    indices = calloc(16 * CHUNK_QUADS * CHUNK_QUADS * 6, sizeof(GLushort));
+    for (edges = 0;  edges < 16;  edges++)
+    {
+        index_offset[edges] = count * sizeof(GLushort);
+
+        for (j = 0;  j < CHUNK_QUADS;  j++)
+        {
+            for (i = 0;  i < CHUNK_QUADS;  i++)
+            {
+                const int v[4] =
+                {
+                    stitch_vertex(i, j, edges),
+                    stitch_vertex(i + 1, j, edges),
+                    stitch_vertex(i, j + 1, edges),
+                    stitch_vertex(i + 1, j + 1, edges)
+                };
+                const int triangles[2][3] = { { v[0], v[3], v[1] }, { v[0], v[2], v[3] } };
+
+                for (k = 0;  k < 2;  k++)
+                {
+                    const int* t = triangles[k];
+
+                    // Skip triangles collapsed by stitching
+                    if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0])
+                        continue;
+
+                    indices[count++] = (GLushort) t[0];
+                    indices[count++] = (GLushort) t[1];
+                    indices[count++] = (GLushort) t[2];
+                }
+            }
+        }
+
+        index_count[edges] = count - (GLsizei) (index_offset[edges] / sizeof(GLushort));
+    }
+
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+
+    glGenBuffers(1, &index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLushort), indices, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &grid_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, grid_buffer);
+    glBufferData(GL_ARRAY_BUFFER, CHUNK_TOTAL_VERTICES * 2 * sizeof(GLfloat), grid, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(glGetAttribLocation(program, "grid"));
+    glVertexAttribPointer(glGetAttribLocation(program, "grid"), 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    height_location = glGetAttribLocation(program, "height");
+    glEnableVertexAttribArray(height_location);
+
+    free(grid);
+    free(indices);
+}
+
+
+//========================================================================
+// OpenGL helper functions
+//========================================================================
+
+static GLuint make_shader(GLenum type, const char* text)
+{
+    GLuint shader;
+    GLint shader_ok;
+    GLsizei log_length;
+    char info_log[8192];
+
+    shader = glCreateShader(type);
+    glShaderSource(shader, 1, (const GLchar**) &text, NULL);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &shader_ok);
+    if (shader_ok != GL_TRUE)
+    {
+        glGetShaderInfoLog(shader, sizeof(info_log), &log_length, info_log);
+        fprintf(stderr, "ERROR: Failed to compile %s shader:\n%s\n",
+                (type == GL_FRAGMENT_SHADER) ? "fragment" : "vertex", info_log);
+        glDeleteShader(shader);
+        shader = 0;
+    }
+
+    return shader;
+}
+
+static GLuint make_shader_program(const char* vs_text, const char* fs_text)
+{
+    GLuint vertex_shader, fragment_shader, result;
+    GLint program_ok;
+    GLsizei log_length;
+    char info_log[8192];
+
+    vertex_shader = make_shader(GL_VERTEX_SHADER, vs_text);
+    fragment_shader = make_shader(GL_FRAGMENT_SHADER, fs_text);
+    if (!vertex_shader || !fragment_shader)
+        return 0;
+
+    result = glCreateProgram();
+    glAttachShader(result, vertex_shader);
+    glAttachShader(result, fragment_shader);
+    glLinkProgram(result);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    glGetProgramiv(result, GL_LINK_STATUS, &program_ok);
+    if (program_ok != GL_TRUE)
+    {
+        glGetProgramInfoLog(result, sizeof(info_log), &log_length, info_log);
+        fprintf(stderr, "ERROR: Failed to link shader program:\n%s\n", info_log);
+        glDeleteProgram(result);
+        result = 0;
+    }
+
+    return result;
+}
+
+
+//========================================================================
+// Rendering
+//========================================================================
+
+static void extract_planes(vec4 planes[6], mat4x4 m)
+{
+    int i, j;
+
+    for (i = 0;  i < 3;  i++)
+    {
+        for (j = 0;  j < 4;  j++)
+        {
+            planes[i * 2 + 0][j] = m[j][3] + m[j][i];
+            planes[i * 2 + 1][j] = m[j][3] - m[j][i];
+        }
+    }
+}
+
+// Draws the terrain and returns the number of chunks drawn
+static int draw_terrain(void)
+{
+    mat4x4 projection, view, mvp;
+    vec3 center, up = { 0.f, 1.f, 0.f };
+    vec4 planes[6];
+    int i, drawn = 0;
+
+    mat4x4_perspective(projection, VIEW_ANGLE,
+                       (float) window_width / (float) window_height,
+                       Z_NEAR, extent * 2.f);
+
+    center[0] = eye_position[0] + cosf(pitch) * cosf(yaw);
+    center[1] = eye_position[1] + sinf(pitch);
+    center[2] = eye_position[2] + cosf(pitch) * sinf(yaw);
+    mat4x4_look_at(view, eye_position, center, up);
+    mat4x4_mul(mvp, projection, view);
+
+    // Pixels per world unit of error at unit distance
+    lod_factor = window_height / (2.f * tanf(VIEW_ANGLE / 2.f));
+
+    extract_planes(planes, mvp);
+    reset_nodes();
+    select_nodes(planes, max_level, 0, 0);
+    restrict_nodes(planes);
+
+    glUniformMatrix4fv(uloc_mvp, 1, GL_FALSE, (const GLfloat*) mvp);
+    glUniform3fv(uloc_eye, 1, eye_position);
+    glUniform1f(uloc_extent, extent);
+
+    glBindBuffer(GL_ARRAY_BUFFER, height_buffer);
+
+    for (i = 0;  i < drawn_nodes.count;  i++)
+    {
+        const NodeRef ref = drawn_nodes.items[i];
+        const Node* node = nodes + node_index(ref.level, ref.x, ref.z);
+        const float size = (CHUNK_QUADS << ref.level) * cell_spacing;
+        const int slot = acquire_slot(ref.level, ref.x, ref.z);
+
+        glUniform2f(uloc_origin, ref.x * size, ref.z * size);
+        glUniform1f(uloc_scale, (1 << ref.level) * cell_spacing);
+        glVertexAttribPointer(height_location, 1, GL_FLOAT, GL_FALSE, 0,
+                              (void*) ((size_t) slot * CHUNK_TOTAL_VERTICES * sizeof(GLfloat)));
+        glDrawElements(GL_TRIANGLES, index_count[node->edges], GL_UNSIGNED_SHORT,
+                       (void*) index_offset[node->edges]);
+        drawn++;
+    }
+
+    return drawn;
+}
+
+static void move_camera(GLFWwindow* window)
+{
+    const float speed = MOVE_SPEED * cell_spacing * (1.f + fmaxf(eye_position[1], 0.f) / 64.f);
+    const float fx = cosf(yaw), fz = sinf(yaw);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    {
+        eye_position[0] += fx * speed;
+        eye_position[2] += fz * speed;
+    }
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    {
+        eye_position[0] -= fx * speed;
+        eye_position[2] -= fz * speed;
+    }
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    {
+        eye_position[0] += fz * speed;
+        eye_position[2] -= fx * speed;
+    }
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    {
+        eye_position[0] -= fz * speed;
+        eye_position[2] += fx * speed;
+    }
+    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+        eye_position[1] -= speed;
+    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+        eye_position[1] += speed;
+}
+
+
+//========================================================================
+// GLFW callback functions
+//========================================================================
+
+static void error_callback(int error, const char* description)
+{
+    fprintf(stderr, "Error: %s\n", description);
+}
+
+static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action != GLFW_PRESS)
+        return;
+
+    switch (key)
+    {
+        case GLFW_KEY_ESCAPE:
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+            break;
+        case GLFW_KEY_SPACE:
+            wireframe = !wireframe;
+            glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
+            break;
+        case GLFW_KEY_KP_ADD:
+        case GLFW_KEY_EQUAL:
+            pixel_error *= 2.f;
+            break;
+        case GLFW_KEY_KP_SUBTRACT:
+        case GLFW_KEY_MINUS:
+            pixel_error = fmaxf(pixel_error / 2.f, 0.25f);
+            break;
+    }
+}
+
+static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    if (button == GLFW_MOUSE_BUTTON_LEFT)
+        rotating = (action == GLFW_PRESS);
+}
+
+static void cursor_position_callback(GLFWwindow* window, double x, double y)
+{
+    if (rotating)
+    {
+        yaw += (float) (x - cursor_x) * 0.005f;
+        pitch -= (float) (y - cursor_y) * 0.005f;
+        pitch = fmaxf(fminf(pitch, 1.5f), -1.5f);
+    }
+
+    cursor_x = x;
+    cursor_y = y;
+}
+
+static void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    window_width = width;
+    window_height = height > 0 ? height : 1;
+    glViewport(0, 0, width, height);
+}
+
+
+//========================================================================
+// main
+//========================================================================
+
+int main(int argc, char** argv)
+{
+    GLFWwindow* window;
+    int ch, generated_size = DEFAULT_GENERATED_SIZE;
+    double last_time;
+    int frames = 0;
+
+    while ((ch = getopt(argc, argv, "c:d:e:hs:v:")) != -1)
+    {
+        switch (ch)
+        {
+            case 'c':
+                cache_chunks = atoi(optarg);
+                break;
+            case 'd':
+                cell_spacing = (float) atof(optarg);
+                break;
+            case 'e':
+                pixel_error = (float) atof(optarg);
+                break;
+            case 'h':
+                usage();
+                exit(EXIT_SUCCESS);
+            case 's':
+                generated_size = atoi(optarg);
+                break;
+            case 'v':
+                height_scale = (float) atof(optarg);
+                break;
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (cache_chunks < 1 || cell_spacing <= 0.f || pixel_error <= 0.f || generated_size < 2)
+    {
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    if (optind < argc)
+    {
+        if (!open_heightfield(&heightfield, argv[optind]))
+            exit(EXIT_FAILURE);
+    }
+    else
+        generate_heightfield(&heightfield, generated_size);
+
+    // Convert the sample range to world units
+    if (height_scale <= 0.f)
+        height_scale = (heightfield.size - 1) * cell_spacing * 0.1f;
+    height_scale /= 65535.f;
+
+    create_quadtree();
+
+    eye_position[0] = extent * 0.1f;
+    eye_position[1] = 65535.f * height_scale * 0.75f;
+    eye_position[2] = extent * 0.1f;
+
+    glfwSetErrorCallback(error_callback);
+
+    if (!glfwInit())
+        exit(EXIT_FAILURE);
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+
+    window = glfwCreateWindow(800, 600, "GLFW OpenGL3 Terrain demo", NULL, NULL);
+    if (!window)
+    {
+        glfwTerminate();
+        exit(EXIT_FAILURE);
+    }
+
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetCursorPosCallback(window, cursor_position_callback);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    glfwMakeContextCurrent(window);
+    gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    glfwSwapInterval(1);
+
+    program = make_shader_program(vertex_shader_text, fragment_shader_text);
+    if (!program)
+    {
+        glfwTerminate();
+        exit(EXIT_FAILURE);
+    }
+
+    glUseProgram(program);
+    uloc_mvp = glGetUniformLocation(program, "mvp");
+    uloc_origin = glGetUniformLocation(program, "origin");
+    uloc_scale = glGetUniformLocation(program, "scale");
+    uloc_extent = glGetUniformLocation(program, "extent");
+    uloc_eye = glGetUniformLocation(program, "eye");
+
+    make_mesh();
+    create_cache();
+
+    glfwGetFramebufferSize(window, &window_width, &window_height);
+    framebuffer_size_callback(window, window_width, window_height);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.6f, 0.7f, 0.8f, 1.f);
+
+    last_time = glfwGetTime();
+
+    while (!glfwWindowShouldClose(window))
+    {
+        int drawn;
+
+        frame_count++;
+        move_camera(window);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawn = draw_terrain();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+
+        frames++;
+        if (glfwGetTime() - last_time >= 1.0)
+        {
+            char title[256];
+            snprintf(title, sizeof(title),
+                     "GLFW OpenGL3 Terrain demo - %i fps, %i chunks, %i uploads/s, %.2f px",
+                     frames, drawn, uploads, pixel_error);
+            glfwSetWindowTitle(window, title);
+
+            last_time = glfwGetTime();
+            frames = 0;
+            uploads = 0;
+        }
+    }
+
+    glfwTerminate();
+
+    free(nodes);
+    free(slot_owner);
+    free(slot_frame);
+    free(touched_nodes.items);
+    free(drawn_nodes.items);
+    close_heightfield(&heightfield);
+
+    exit(EXIT_SUCCESS);
+}
@@ -15,15 +15,56 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
+#include <time.h>
+
+#if !defined(_WIN32)
+ #include <unistd.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define WAVE_USE_SSE
+#endif
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <tinycthread.h>
+#include <getopt.h>
 #include <linmath.h>
 
-// Maximum delta T to allow for differential calculations
-#define MAX_DELTA_T 0.01
+#define NK_IMPLEMENTATION
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_FONT_BAKING
+#define NK_INCLUDE_DEFAULT_FONT
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+#define NK_INCLUDE_STANDARD_VARARGS
+#include <nuklear.h>
+
+#define NK_GLFW_GL2_IMPLEMENTATION
+#include <nuklear_glfw_gl2.h>
+
+#define PROFILER_IMPLEMENTATION
+#include <profiler.h>
+
+#define SCHEDULER_IMPLEMENTATION
+#include <scheduler.h>
+
+// Fixed time step of the differential calculations
+#define TIME_STEP 0.01
+
+// Maximum frame time to catch up on, so a stall does not trigger an
+// ever-growing number of simulation steps
+#define MAX_FRAME_TIME 0.25
+
+// Maximum number of simulation threads, including the main thread
+#define MAX_THREADS 64
+
+// Smallest band of rows worth giving its own thread by default
+#define ROWS_PER_THREAD 64
 
 // Animation speed (10.0 looks good)
 #define ANIMATION_SPEED 10.0
@@ -34,22 +75,29 @@ GLfloat zoom = 2.f;
 double cursorX;
 double cursorY;
 
+// Profiler overlay, only set up when profiling
+struct nk_context* nk;
+int show_profiler = GLFW_FALSE;
+
 struct Vertex
 {
     GLfloat x, y, z;
     GLfloat r, g, b;
 };
 
-#define GRIDW 50
-#define GRIDH 50
-#define VERTEXNUM (GRIDW*GRIDH)
+// Default and maximum grid dimensions
+#define DEFAULT_GRID_SIZE 50
+#define MAX_GRID_SIZE 2048
+
+// Width in cells of the column strips the solver sweeps through, chosen so
+// the rows touched by one strip stay in the L1 cache
+#define TILE_W 512
 
-#define QUADW (GRIDW - 1)
-#define QUADH (GRIDH - 1)
-#define QUADNUM (QUADW*QUADH)
+int gridw = DEFAULT_GRID_SIZE;
+int gridh = DEFAULT_GRID_SIZE;
 
-GLuint quad[4 * QUADNUM];
-struct Vertex vertex[VERTEXNUM];
+GLuint quad_buffer;
+struct Vertex* vertex;
 
 /* The grid will look like this:
  *
@@ -69,16 +117,19 @@ struct Vertex vertex[VERTEXNUM];
 void init_vertices(void)
 {
     int x, y, p;
+    GLuint* quad;
+
+    vertex = calloc((size_t) gridw * gridh, sizeof(struct Vertex));
 
     // Place the vertices in a grid
-    for (y = 0;  y < GRIDH;  y++)
+    for (y = 0;  y < gridh;  y++)
     {
-        for (x = 0;  x < GRIDW;  x++)
+        for (x = 0;  x < gridw;  x++)
         {
-            p = y * GRIDW + x;
+            p = y * gridw + x;
 
-            vertex[p].x = (GLfloat) (x - GRIDW / 2) / (GLfloat) (GRIDW / 2);
-            vertex[p].y = (GLfloat) (y - GRIDH / 2) / (GLfloat) (GRIDH / 2);
+            vertex[p].x = (GLfloat) (x - gridw / 2) / (GLfloat) (gridw / 2);
+            vertex[p].y = (GLfloat) (y - gridh / 2) / (GLfloat) (gridh / 2);
             vertex[p].z = 0;
 
             if ((x % 4 < 2) ^ (y % 4 < 2))
@@ -86,29 +137,59 @@ void init_vertices(void)
             else
                 vertex[p].r = 1.0;
 
-            vertex[p].g = (GLfloat) y / (GLfloat) GRIDH;
-            vertex[p].b = 1.f - ((GLfloat) x / (GLfloat) GRIDW + (GLfloat) y / (GLfloat) GRIDH) / 2.f;
+            vertex[p].g = (GLfloat) y / (GLfloat) gridh;
+            vertex[p].b = 1.f - ((GLfloat) x / (GLfloat) gridw + (GLfloat) y / (GLfloat) gridh) / 2.f;
         }
     }
 
-    for (y = 0;  y < QUADH;  y++)
+    quad = calloc(4 * (size_t) (gridw - 1) * (gridh - 1), sizeof(GLuint));
+
+    for (y = 0;  y < gridh - 1;  y++)
     {
-        for (x = 0;  x < QUADW;  x++)
+        for (x = 0;  x < gridw - 1;  x++)
         {
-            p = 4 * (y * QUADW + x);
+            p = 4 * (y * (gridw - 1) + x);
 
-            quad[p + 0] = y       * GRIDW + x;     // Some point
-            quad[p + 1] = y       * GRIDW + x + 1; // Neighbor at the right side
-            quad[p + 2] = (y + 1) * GRIDW + x + 1; // Upper right neighbor
-            quad[p + 3] = (y + 1) * GRIDW + x;     // Upper neighbor
+            quad[p + 0] = y       * gridw + x;     // Some point
+            quad[p + 1] = y       * gridw + x + 1; // Neighbor at the right side
+            quad[p + 2] = (y + 1) * gridw + x + 1; // Upper right neighbor
+            quad[p + 3] = (y + 1) * gridw + x;     // Upper neighbor
         }
     }
+
+    // The topology never changes, so keep the indices on the GPU
+    glGenBuffers(1, &quad_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 4 * (GLsizeiptr) (gridw - 1) * (gridh - 1) * sizeof(GLuint),
+                 quad, GL_STATIC_DRAW);
+
+    free(quad);
 }
 
-double dt;
-double p[GRIDW][GRIDH];
-double vx[GRIDW][GRIDH], vy[GRIDW][GRIDH];
-double ax[GRIDW][GRIDH], ay[GRIDW][GRIDH];
+/* The simulation state is stored row-major with one ghost column to the right
+ * and one ghost row below the grid, both mirroring the opposite edge.  The
+ * first row and column are never updated, so the ghost cells only need to be
+ * filled when the grid is reset.
+ */
+float* p;
+float* vx;
+float* vy;
+int stride;
+
+//========================================================================
+// Allocate simulation state
+//========================================================================
+
+void init_state(void)
+{
+    // Round rows up to a whole number of SIMD vectors, ghost column included
+    stride = (gridw + 1 + 3) & ~3;
+
+    p  = calloc((size_t) stride * (gridh + 1), sizeof(float));
+    vx = calloc((size_t) stride * (gridh + 1), sizeof(float));
+    vy = calloc((size_t) stride * (gridh + 1), sizeof(float));
+}
 
 //========================================================================
 // Initialize grid
@@ -119,25 +200,31 @@ void init_grid(void)
     int x, y;
     double dx, dy, d;
 
-    for (y = 0; y < GRIDH;  y++)
+    for (y = 0; y < gridh;  y++)
     {
-        for (x = 0; x < GRIDW;  x++)
+        for (x = 0; x < gridw;  x++)
         {
-            dx = (double) (x - GRIDW / 2);
-            dy = (double) (y - GRIDH / 2);
+            dx = (double) (x - gridw / 2);
+            dy = (double) (y - gridh / 2);
             d = sqrt(dx * dx + dy * dy);
-            if (d < 0.1 * (double) (GRIDW / 2))
+            if (d < 0.1 * (double) (gridw / 2))
             {
                 d = d * 10.0;
-                p[x][y] = -cos(d * (M_PI / (double)(GRIDW * 4))) * 100.0;
+                p[y * stride + x] = (float) (-cos(d * (M_PI / (double)(gridw * 4))) * 100.0);
             }
             else
-                p[x][y] = 0.0;
+                p[y * stride + x] = 0.f;
 
-            vx[x][y] = 0.0;
-            vy[x][y] = 0.0;
+            vx[y * stride + x] = 0.f;
+            vy[y * stride + x] = 0.f;
         }
     }
+
+    // Fill the ghost cells with the wrapped-around first column and row
+    for (y = 0;  y < gridh;  y++)
+        p[y * stride + gridw] = p[y * stride];
+    for (x = 0;  x <= gridw;  x++)
+        p[gridh * stride + x] = p[x];
 }
 
 
@@ -147,6 +234,8 @@ void init_grid(void)
 
 void draw_scene(GLFWwindow* window)
 {
+    int zone;
+
     // Clear the color and depth buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -160,9 +249,18 @@ void draw_scene(GLFWwindow* window)
     glRotatef(beta, 1.0, 0.0, 0.0);
     glRotatef(alpha, 0.0, 0.0, 1.0);
 
-    glDrawElements(GL_QUADS, 4 * QUADNUM, GL_UNSIGNED_INT, quad);
+    // The profiler overlay uses its own vertex arrays
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(struct Vertex), vertex);
+    glColorPointer(3, GL_FLOAT, sizeof(struct Vertex), &vertex[0].r); // Pointer to the first color
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_buffer);
+
+    zone = profiler_begin_gpu("Grid");
+    glDrawElements(GL_QUADS, 4 * (gridw - 1) * (gridh - 1), GL_UNSIGNED_INT, NULL);
+    profiler_end_gpu(zone);
 
-    glfwSwapBuffers(window);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 
@@ -178,11 +276,6 @@ void init_opengl(void)
     // Switch on the z-buffer
     glEnable(GL_DEPTH_TEST);
 
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_COLOR_ARRAY);
-    glVertexPointer(3, GL_FLOAT, sizeof(struct Vertex), vertex);
-    glColorPointer(3, GL_FLOAT, sizeof(struct Vertex), &vertex[0].r); // Pointer to the first color
-
     glPointSize(2.0);
 
     // Background color is black
@@ -199,60 +292,403 @@ void adjust_grid(void)
     int pos;
     int x, y;
 
-    for (y = 0; y < GRIDH;  y++)
+    for (y = 0; y < gridh;  y++)
     {
-        for (x = 0;  x < GRIDW;  x++)
+        for (x = 0;  x < gridw;  x++)
         {
-            pos = y * GRIDW + x;
-            vertex[pos].z = (float) (p[x][y] * (1.0 / 50.0));
+            pos = y * gridw + x;
+            vertex[pos].z = p[y * stride + x] * (1.f / 50.f);
         }
     }
 }
 
 
+//========================================================================
+// Update the velocities of one row of a strip from the old pressure
+//========================================================================
+
+static void update_velocity_row(int y, int x0, int x1, float time_step)
+{
+    const float* row = p + y * stride;
+    const float* below = row + stride;
+    float* vxr = vx + y * stride;
+    float* vyr = vy + y * stride;
+    int x = x0;
+
+#if defined(WAVE_USE_SSE)
+    const __m128 t = _mm_set1_ps(time_step);
+
+    for (;  x + 4 <= x1;  x += 4)
+    {
+        const __m128 c = _mm_loadu_ps(row + x);
+        const __m128 ax = _mm_sub_ps(c, _mm_loadu_ps(row + x + 1));
+        const __m128 ay = _mm_sub_ps(c, _mm_loadu_ps(below + x));
+
+        _mm_storeu_ps(vxr + x, _mm_add_ps(_mm_loadu_ps(vxr + x), _mm_mul_ps(ax, t)));
+        _mm_storeu_ps(vyr + x, _mm_add_ps(_mm_loadu_ps(vyr + x), _mm_mul_ps(ay, t)));
+    }
+#endif
+
+    for (;  x < x1;  x++)
+    {
+        vxr[x] += (row[x] - row[x + 1]) * time_step;
+        vyr[x] += (row[x] - below[x]) * time_step;
+    }
+}
+
+
+//========================================================================
+// Update the pressure of one row of a strip from the new velocities
+//========================================================================
+
+static void update_pressure_row(int y, int x0, int x1, float time_step)
+{
+    float* row = p + y * stride;
+    const float* vxr = vx + y * stride;
+    const float* vyr = vy + y * stride;
+    const float* vya = vyr - stride;
+    int x = x0;
+
+#if defined(WAVE_USE_SSE)
+    const __m128 t = _mm_set1_ps(time_step);
+
+    for (;  x + 4 <= x1;  x += 4)
+    {
+        const __m128 dvx = _mm_sub_ps(_mm_loadu_ps(vxr + x - 1), _mm_loadu_ps(vxr + x));
+        const __m128 dvy = _mm_sub_ps(_mm_loadu_ps(vya + x), _mm_loadu_ps(vyr + x));
+
+        _mm_storeu_ps(row + x, _mm_add_ps(_mm_loadu_ps(row + x),
+                                          _mm_mul_ps(_mm_add_ps(dvx, dvy), t)));
+    }
+#endif
+
+    for (;  x < x1;  x++)
+        row[x] += (vxr[x - 1] - vxr[x] + vya[x] - vyr[x]) * time_step;
+}
+
+
+//========================================================================
+// Copy the new pressure of one row of a strip into the vertex heights
+//========================================================================
+
+static void update_vertex_row(int y, int x0, int x1)
+{
+    struct Vertex* v = vertex + y * gridw;
+    const float* row = p + y * stride;
+    int x;
+
+    for (x = x0;  x < x1;  x++)
+        v[x].z = row[x] * (1.f / 50.f);
+}
+
+
 //========================================================================
 // Calculate wave propagation
 //========================================================================
 
-void calc_grid(void)
+/* Each cell needs the old pressure of its right and lower neighbors for its
+ * velocity, and the new velocity of its left and upper neighbors for its
+ * pressure.  Sweeping each column strip top to bottom, first updating the
+ * velocities of a row and then its pressure, satisfies both in a single pass.
+ * The first row and column keep their pressure, as before.
+ *
+ * When the grid is split into row bands, the pressure of the first row of a
+ * band needs the velocities of the last row of the band above.  That row is
+ * skipped by calc_band and updated by calc_band_edge once every band is done.
+ */
+static void calc_band(int y0, int y1, float time_step, int update_vertices)
 {
-    int x, y, x2, y2;
-    double time_step = dt * ANIMATION_SPEED;
+    int x0, x1, y;
 
-    // Compute accelerations
-    for (x = 0;  x < GRIDW;  x++)
+    for (x0 = 0;  x0 < gridw;  x0 += TILE_W)
     {
-        x2 = (x + 1) % GRIDW;
-        for(y = 0; y < GRIDH; y++)
-            ax[x][y] = p[x][y] - p[x2][y];
+        x1 = x0 + TILE_W < gridw ? x0 + TILE_W : gridw;
+
+        update_velocity_row(y0, x0, x1, time_step);
+
+        for (y = y0 + 1;  y < y1;  y++)
+        {
+            update_velocity_row(y, x0, x1, time_step);
+            update_pressure_row(y, x0 > 0 ? x0 : 1, x1, time_step);
+
+            if (update_vertices)
+                update_vertex_row(y, x0 > 0 ? x0 : 1, x1);
+        }
     }
+}
 
-    for (y = 0;  y < GRIDH;  y++)
+static void calc_band_edge(int y0, float time_step, int update_vertices)
+{
+    if (y0 == 0)
+        return;
+
+    update_pressure_row(y0, 1, gridw, time_step);
+
+    if (update_vertices)
+        update_vertex_row(y0, 1, gridw);
+}
+
+
+//========================================================================
+// Simulation threads
+//========================================================================
+
+typedef struct
+{
+    mtx_t lock;
+    cnd_t cond;
+    int count;
+    int waiting;
+    int generation;
+} Barrier;
+
+struct {
+    thrd_t    threads[MAX_THREADS];
+    int       count;          // Number of bands, including the main thread
+    Barrier   barrier;        // Synchronizes the bands between phases
+    mtx_t     lock;           // Protects the batch description below
+    cnd_t     start;          // Condition: a new batch was posted
+    cnd_t     done;           // Condition: a worker finished its batch
+    int       generation;     // Batch counter
+    int       finished;       // Workers done with the current batch
+    int       steps;          // Number of steps in the batch
+    float     time_step;      // Scaled time step
+    int       update_vertices;
+    int       quit;
+} workers;
+
+static void barrier_wait(Barrier* barrier)
+{
+    int generation;
+
+    mtx_lock(&barrier->lock);
+
+    generation = barrier->generation;
+    if (++barrier->waiting == barrier->count)
     {
-        y2 = (y + 1) % GRIDH;
-        for(x = 0; x < GRIDW; x++)
-            ay[x][y] = p[x][y] - p[x][y2];
+        barrier->waiting = 0;
+        barrier->generation++;
+        cnd_broadcast(&barrier->cond);
+    }
+    else
+    {
+        while (generation == barrier->generation)
+            cnd_wait(&barrier->cond, &barrier->lock);
+    }
+
+    mtx_unlock(&barrier->lock);
+}
+
+static void run_band(int index, int steps, float time_step, int update_vertices)
+{
+    const int y0 = gridh * index / workers.count;
+    const int y1 = gridh * (index + 1) / workers.count;
+    int i;
+
+    for (i = 0;  i < steps;  i++)
+    {
+        const int last = update_vertices && i == steps - 1;
+
+        calc_band(y0, y1, time_step, last);
+
+        if (workers.count > 1)
+        {
+            barrier_wait(&workers.barrier);
+            calc_band_edge(y0, time_step, last);
+            barrier_wait(&workers.barrier);
+        }
     }
+}
+
+static int worker_main(void* arg)
+{
+    const int index = (int) (intptr_t) arg;
+    int generation = 0;
 
-    // Compute speeds
-    for (x = 0;  x < GRIDW;  x++)
+    for (;;)
     {
-        for (y = 0;  y < GRIDH;  y++)
+        int steps, update_vertices;
+        float time_step;
+
+        mtx_lock(&workers.lock);
+
+        while (!workers.quit && workers.generation == generation)
+            cnd_wait(&workers.start, &workers.lock);
+
+        if (workers.quit)
         {
-            vx[x][y] = vx[x][y] + ax[x][y] * time_step;
-            vy[x][y] = vy[x][y] + ay[x][y] * time_step;
+            mtx_unlock(&workers.lock);
+            break;
         }
+
+        generation = workers.generation;
+        steps = workers.steps;
+        time_step = workers.time_step;
+        update_vertices = workers.update_vertices;
+
+        mtx_unlock(&workers.lock);
+
+        run_band(index, steps, time_step, update_vertices);
+
+        mtx_lock(&workers.lock);
+        workers.finished++;
+        cnd_signal(&workers.done);
+        mtx_unlock(&workers.lock);
+    }
+
+    return 0;
+}
+
+static void start_workers(int count)
+{
+    int i;
+
+    workers.count = count;
+    workers.generation = 0;
+    workers.quit = GLFW_FALSE;
+
+    mtx_init(&workers.lock, mtx_plain);
+    cnd_init(&workers.start);
+    cnd_init(&workers.done);
+
+    mtx_init(&workers.barrier.lock, mtx_plain);
+    cnd_init(&workers.barrier.cond);
+    workers.barrier.count = count;
+    workers.barrier.waiting = 0;
+    workers.barrier.generation = 0;
+
+    // The main thread runs the first band itself
+    for (i = 1;  i < count;  i++)
+        thrd_create(&workers.threads[i], worker_main, (void*) (intptr_t) i);
+}
+
+static void stop_workers(void)
+{
+    int i;
+
+    mtx_lock(&workers.lock);
+    workers.quit = GLFW_TRUE;
+    cnd_broadcast(&workers.start);
+    mtx_unlock(&workers.lock);
+
+    for (i = 1;  i < workers.count;  i++)
+        thrd_join(workers.threads[i], NULL);
+
+    cnd_destroy(&workers.barrier.cond);
+    mtx_destroy(&workers.barrier.lock);
+    cnd_destroy(&workers.done);
+    cnd_destroy(&workers.start);
+    mtx_destroy(&workers.lock);
+}
+
+//========================================================================
+// Advance the simulation by the specified number of fixed time steps
+//========================================================================
+
+void calc_grid(int steps, int update_vertices)
+{
+    const float time_step = (float) (TIME_STEP * ANIMATION_SPEED);
+
+    if (workers.count > 1)
+    {
+        mtx_lock(&workers.lock);
+        workers.steps = steps;
+        workers.time_step = time_step;
+        workers.update_vertices = update_vertices;
+        workers.finished = 0;
+        workers.generation++;
+        cnd_broadcast(&workers.start);
+        mtx_unlock(&workers.lock);
     }
 
-    // Compute pressure
-    for (x = 1;  x < GRIDW;  x++)
+    run_band(0, steps, time_step, update_vertices);
+
+    if (workers.count > 1)
     {
-        x2 = x - 1;
-        for (y = 1;  y < GRIDH;  y++)
+        mtx_lock(&workers.lock);
+        while (workers.finished < workers.count - 1)
+            cnd_wait(&workers.done, &workers.lock);
+        mtx_unlock(&workers.lock);
+    }
+}
+
+//========================================================================
+// Return the number of online processors
+//========================================================================
+
+static int count_processors(void)
+{
+    int count = 1;
+
+#if defined(_WIN32)
+    const char* value = getenv("NUMBER_OF_PROCESSORS");
+    if (value)
+        count = atoi(value);
+#elif defined(_SC_NPROCESSORS_ONLN)
+    count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    if (count < 1)
+        count = 1;
+    if (count > MAX_THREADS)
+        count = MAX_THREADS;
+
+    return count;
+}
+
+//========================================================================
+// Measure simulation throughput for an increasing number of threads
+//========================================================================
+
+static double get_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(TIME_UTC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void run_benchmark(int max_threads)
+{
+    int count, next;
+    double base_rate = 0.0;
+
+    printf("Simulating a %ix%i grid\n", gridw, gridh);
+    printf("%8s %16s %8s\n", "threads", "cells/s", "speedup");
+
+    for (count = 1;  count <= max_threads;  count = next)
+    {
+        double start, elapsed;
+        long steps = 0;
+
+        start_workers(count);
+        init_grid();
+
+        // Warm up the caches and threads
+        calc_grid(10, GLFW_FALSE);
+
+        start = get_seconds();
+        do
+        {
+            calc_grid(10, GLFW_FALSE);
+            steps += 10;
+            elapsed = get_seconds() - start;
+        }
+        while (elapsed < 1.0);
+
+        stop_workers();
+
         {
-            y2 = y - 1;
-            p[x][y] = p[x][y] + (vx[x2][y] - vx[x][y] + vy[x][y2] - vy[x][y]) * time_step;
+            const double rate = (double) gridw * gridh * steps / elapsed;
+            if (count == 1)
+                base_rate = rate;
+
+            printf("%8i %16.0f %7.2fx\n", count, rate, rate / base_rate);
         }
+
+        // Include the full machine even when it is not a power of two
+        next = count * 2;
+        if (count < max_threads && next > max_threads)
+            next = max_threads;
     }
 }
 
@@ -283,6 +719,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
             break;
         case GLFW_KEY_SPACE:
             init_grid();
+            adjust_grid();
             break;
         case GLFW_KEY_LEFT:
             alpha += 5;
@@ -304,6 +741,10 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         case GLFW_KEY_PAGE_DOWN:
             zoom += 0.25f;
             break;
+        case GLFW_KEY_P:
+            if (nk)
+                show_profiler = !show_profiler;
+            break;
         default:
             break;
     }
@@ -321,6 +762,10 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 
     if (action == GLFW_PRESS)
     {
+        // Leave clicks on the profiler overlay to nuklear
+        if (show_profiler && nk_window_is_any_hovered(nk))
+            return;
+
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
         glfwGetCursorPos(window, &cursorX, &cursorY);
     }
@@ -383,6 +828,26 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 }
 
 
+//========================================================================
+// Print usage information
+//========================================================================
+
+static void usage(void)
+{
+    printf("Usage: wave [-bhp] [-o FILE] [-r RATE] [-s SIZE] [-t THREADS]\n");
+    printf("Options:\n");
+    printf(" -b, --bench    Report simulated cells per second for 1 to THREADS threads\n");
+    printf(" -h, --help     Display this help\n");
+    printf(" -o, --trace    Write a Chrome trace of the last frames to FILE on exit\n");
+    printf(" -p, --profile  Show the profiler overlay (toggle with P when profiling)\n");
+    printf(" -r, --rate     Limit the frame rate to RATE frames per second\n");
+    printf(" -s, --size     Grid size in cells per side, from 2 to %i (default %i)\n",
+           MAX_GRID_SIZE, DEFAULT_GRID_SIZE);
+    printf(" -t, --threads  Number of simulation threads (default one per %i rows,\n"
+           "                up to the number of processors)\n", ROWS_PER_THREAD);
+}
+
+
 //========================================================================
 // main
 //========================================================================
@@ -390,8 +855,95 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 int main(int argc, char* argv[])
 {
     GLFWwindow* window;
-    double t, dt_total, t_old;
-    int width, height;
+    double t, t_old, accumulator = 0.0;
+    int ch, width, height, steps, zone;
+    int bench = GLFW_FALSE, size = 0, threads = 0;
+    double rate = 0.0;
+    const char* trace_path = NULL;
+    Scheduler scheduler;
+
+    enum { BENCH, HELP, PROFILE, RATE, SIZE, THREADS, TRACE };
+    const struct option options[] =
+    {
+        { "bench",   0, NULL, BENCH },
+        { "help",    0, NULL, HELP },
+        { "profile", 0, NULL, PROFILE },
+        { "rate",    1, NULL, RATE },
+        { "size",    1, NULL, SIZE },
+        { "threads", 1, NULL, THREADS },
+        { "trace",   1, NULL, TRACE },
+        { NULL, 0, NULL, 0 }
+    };
+
+    while ((ch = getopt_long(argc, argv, "bho:pr:s:t:", options, NULL)) != -1)
+    {
+        switch (ch)
+        {
+            case 'b':
+            case BENCH:
+                bench = GLFW_TRUE;
+                break;
+            case 'h':
+            case HELP:
+                usage();
+                exit(EXIT_SUCCESS);
+            case 'o':
+            case TRACE:
+                trace_path = optarg;
+                break;
+            case 'p':
+            case PROFILE:
+                show_profiler = GLFW_TRUE;
+                break;
+            case 'r':
+            case RATE:
+                rate = atof(optarg);
+                break;
+            case 's':
+            case SIZE:
+                size = atoi(optarg);
+                break;
+            case 't':
+            case THREADS:
+                threads = atoi(optarg);
+                break;
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (size)
+        gridw = gridh = size;
+    else if (bench)
+        gridw = gridh = 1024;
+
+    if (gridw < 2 || gridw > MAX_GRID_SIZE || threads < 0 || threads > MAX_THREADS ||
+        rate < 0.0)
+    {
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    if (!threads)
+    {
+        threads = bench ? count_processors() : gridh / ROWS_PER_THREAD;
+        if (threads > count_processors())
+            threads = count_processors();
+        if (threads < 1)
+            threads = 1;
+    }
+
+    // Every band needs at least two rows
+    if (threads > gridh / 2)
+        threads = gridh / 2;
+
+    if (bench)
+    {
+        init_state();
+        run_benchmark(threads);
+        exit(EXIT_SUCCESS);
+    }
 
     glfwSetErrorCallback(error_callback);
 
@@ -413,49 +965,87 @@ int main(int argc, char* argv[])
 
     glfwMakeContextCurrent(window);
     gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
-    glfwSwapInterval(1);
+
+    // Wait for vertical sync unless the frame is already late
+    scheduler_init(&scheduler, rate > 0.0 ? 1.0 / rate : 0.0, GLFW_TRUE);
 
     glfwGetFramebufferSize(window, &width, &height);
     framebuffer_size_callback(window, width, height);
 
-    // Initialize OpenGL
-    init_opengl();
-
     // Initialize simulation
     init_vertices();
+    init_state();
     init_grid();
     adjust_grid();
+    start_workers(threads);
+
+    // Initialize OpenGL
+    init_opengl();
+
+    if (show_profiler || trace_path)
+    {
+        profiler_init();
+        nk = profiler_overlay_init(window);
+    }
 
     // Initialize timer
-    t_old = glfwGetTime() - 0.01;
+    t_old = glfwGetTime();
 
     while (!glfwWindowShouldClose(window))
     {
+        profiler_begin_frame();
+
         t = glfwGetTime();
-        dt_total = t - t_old;
+        accumulator += t - t_old;
         t_old = t;
 
-        // Safety - iterate if dt_total is too large
-        while (dt_total > 0.f)
-        {
-            // Select iteration time step
-            dt = dt_total > MAX_DELTA_T ? MAX_DELTA_T : dt_total;
-            dt_total -= dt;
+        // Catch up with the real time in fixed steps, independent of the
+        // frame rate, carrying the remainder over to the next frame
+        if (accumulator > MAX_FRAME_TIME)
+            accumulator = MAX_FRAME_TIME;
 
-            // Calculate wave propagation
-            calc_grid();
-        }
+        steps = (int) (accumulator / TIME_STEP);
+        accumulator -= steps * TIME_STEP;
 
-        // Compute height of each vertex
-        adjust_grid();
+        // Calculate wave propagation, updating the vertex heights on the
+        // final step
+        zone = profiler_begin("Simulation");
+        if (steps > 0)
+            calc_grid(steps, GLFW_TRUE);
+        profiler_end(zone);
 
         // Draw wave grid to OpenGL display
+        zone = profiler_begin("Draw");
         draw_scene(window);
+        if (show_profiler)
+            profiler_overlay_draw(window);
+        profiler_end(zone);
 
+        zone = profiler_begin("Swap");
+        scheduler_swap_buffers(&scheduler, window);
+        profiler_end(zone);
+
+        zone = profiler_begin("Events");
         glfwPollEvents();
+        profiler_end(zone);
+
+        profiler_end_frame();
     }
 
+    if (trace_path && !profiler_write_trace(trace_path))
+        fprintf(stderr, "Failed to write trace to %s\n", trace_path);
+
+    profiler_terminate();
+    profiler_overlay_terminate();
+
+    stop_workers();
     glfwTerminate();
+
+    free(vertex);
+    free(p);
+    free(vx);
+    free(vy);
+
     exit(EXIT_SUCCESS);
 }
 
@@ -1066,6 +1066,21 @@ extern "C" {
 #define GLFW_COCOA_MENUBAR          0x00051002
 /*! @} */
 
+/*! @defgroup event_types Event types
+ *  @brief Types of events recorded by the event queue.
+ *
+ *  See [event queue](@ref event_queue) for how these are used.
+ *
+ *  @ingroup input
+ *  @{ */
+#define GLFW_EVENT_KEY              0x00060001
+#define GLFW_EVENT_CHAR             0x00060002
+#define GLFW_EVENT_MOUSE_BUTTON     0x00060003
+#define GLFW_EVENT_CURSOR_POS       0x00060004
+#define GLFW_EVENT_CURSOR_ENTER     0x00060005
+#define GLFW_EVENT_SCROLL           0x00060006
+/*! @} */
+
 #define GLFW_DONT_CARE              -1
 
 
@@ -1606,6 +1621,58 @@ typedef struct GLFWgamepadstate
     float axes[6];
 } GLFWgamepadstate;
 
+/*! @brief Queued input event.
+ *
+ *  This describes an input event recorded by the event queue of a window.
+ *  Only the members used by its type are set and the rest are zero.
+ *
+ *  @sa @ref event_queue
+ *  @sa @ref glfwDrainEventQueue
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup input
+ */
+typedef struct GLFWevent
+{
+    /*! The [type](@ref event_types) of the event.
+     */
+    int type;
+    /*! The value of the [raw timer](@ref glfwGetTimerValue) when the event was
+     *  received.
+     */
+    uint64_t time;
+    /*! The [key](@ref keys) of a key event.
+     */
+    int key;
+    /*! The platform-specific scancode of a key event.
+     */
+    int scancode;
+    /*! The [mouse button](@ref buttons) of a mouse button event.
+     */
+    int button;
+    /*! `GLFW_PRESS`, `GLFW_RELEASE` or `GLFW_REPEAT` for key and mouse button
+     *  events.  For cursor enter events, `GLFW_TRUE` if the cursor entered the
+     *  client area and `GLFW_FALSE` if it left it.
+     */
+    int action;
+    /*! The [modifier keys](@ref mods) of key, character and mouse button
+     *  events.
+     */
+    int mods;
+    /*! The Unicode code point of a character event.
+     */
+    unsigned int codepoint;
+    /*! The cursor position of a cursor position event or the offset of
+     *  a scroll event.
+     */
+    double x;
+    /*! The cursor position of a cursor position event or the offset of
+     *  a scroll event.
+     */
+    double y;
+} GLFWevent;
+
 
 /*************************************************************************
  * GLFW API functions
@@ -4481,6 +4548,66 @@ GLFWAPI GLFWscrollfun glfwSetScrollCallback(GLFWwindow* window, GLFWscrollfun cb
  */
 GLFWAPI GLFWdropfun glfwSetDropCallback(GLFWwindow* window, GLFWdropfun cbfun);
 
+/*! @brief Sets the size of the event queue for the specified window.
+ *
+ *  This function enables, resizes or disables the event queue of the specified
+ *  window.  While enabled, the queue records key, character, mouse button,
+ *  cursor position, cursor enter and scroll events with the value of the raw
+ *  timer when they were received.  Callbacks are still called as usual.
+ *
+ *  When the queue is full, the oldest event is discarded to make room.
+ *  Consecutive cursor position events are merged into the most recent one,
+ *  so a queue of a few hundred events is enough even for high-rate mice.
+ *  Changing the size discards any events already in the queue.
+ *
+ *  @param[in] window The window whose event queue to set up.
+ *  @param[in] size The maximum number of events in the queue, or zero to
+ *  disable the queue.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED, @ref
+ *  GLFW_INVALID_VALUE and @ref GLFW_OUT_OF_MEMORY.
+ *
+ *  @thread_safety This function must only be called from the main thread.
+ *
+ *  @sa @ref event_queue
+ *  @sa @ref glfwDrainEventQueue
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup input
+ */
+GLFWAPI void glfwSetEventQueueSize(GLFWwindow* window, int size);
+
+/*! @brief Removes all events from the event queue of the specified window.
+ *
+ *  This function returns the events recorded by the event queue of the
+ *  specified window since the last call, oldest first, and empties the queue.
+ *
+ *  @param[in] window The window whose event queue to drain.
+ *  @param[out] count Where to store the number of events in the returned
+ *  array.  This is set to zero if the queue is empty or disabled, or if an
+ *  [error](@ref error_handling) occurred.
+ *  @return An array of events, or `NULL` if the queue is empty or disabled,
+ *  or if an [error](@ref error_handling) occurred.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED.
+ *
+ *  @pointer_lifetime The returned array is allocated and freed by GLFW.  You
+ *  should not free it yourself.  It is valid until the next call to this
+ *  function, an event processing function or @ref glfwSetEventQueueSize for
+ *  the same window, or until the window is destroyed.
+ *
+ *  @thread_safety This function must only be called from the main thread.
+ *
+ *  @sa @ref event_queue
+ *  @sa @ref glfwSetEventQueueSize
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup input
+ */
+GLFWAPI const GLFWevent* glfwDrainEventQueue(GLFWwindow* window, int* count);
+
 /*! @brief Returns whether the specified joystick is present.
  *
  *  This function returns whether the specified joystick is present.
@@ -4505,6 +4632,31 @@ GLFWAPI GLFWdropfun glfwSetDropCallback(GLFWwindow* window, GLFWdropfun cbfun);
  */
 GLFWAPI int glfwJoystickPresent(int jid);
 
+/*! @brief Polls the state of all connected joysticks at once.
+ *
+ *  This function updates the axes, buttons and hats of all connected joysticks
+ *  from the input devices.  Until the next call to this function or to an
+ *  event processing function, the joystick query functions return this state
+ *  instead of polling the devices again, so a frame that queries the same
+ *  joysticks many times only polls each device once.
+ *
+ *  Calling this function once per frame, after processing events, is optional.
+ *  If it has not been called since events were last processed, every joystick
+ *  query polls its device as before.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED and @ref
+ *  GLFW_PLATFORM_ERROR.
+ *
+ *  @thread_safety This function must only be called from the main thread.
+ *
+ *  @sa @ref joystick_poll
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup input
+ */
+GLFWAPI void glfwPollJoysticks(void);
+
 /*! @brief Returns the values of all axes of the specified joystick.
  *
  *  This function returns the values of all axes of the specified joystick.
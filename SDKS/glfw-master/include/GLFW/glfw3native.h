@@ -63,6 +63,7 @@ extern "C" {
  *  * `GLFW_EXPOSE_NATIVE_X11`
  *  * `GLFW_EXPOSE_NATIVE_WAYLAND`
  *  * `GLFW_EXPOSE_NATIVE_MIR`
+ *  * `GLFW_EXPOSE_NATIVE_NULL`
  *
  *  The available context API macros are:
  *  * `GLFW_EXPOSE_NATIVE_WGL`
@@ -564,6 +565,117 @@ GLFWAPI int glfwGetOSMesaDepthBuffer(GLFWwindow* window, int* width, int* height
 GLFWAPI OSMesaContext glfwGetOSMesaContext(GLFWwindow* window);
 #endif
 
+#if defined(GLFW_EXPOSE_NATIVE_NULL)
+/*! @brief Injects a synthetic key event into the specified window.
+ *
+ *  This function queues a key event for the specified window.  It is delivered
+ *  as if it came from a keyboard by the next call to @ref glfwPollEvents,
+ *  @ref glfwWaitEvents or @ref glfwWaitEventsTimeout, which it also wakes up.
+ *
+ *  @param[in] window The window to receive the event.
+ *  @param[in] key The [key](@ref keys), or `GLFW_KEY_UNKNOWN`.
+ *  @param[in] scancode The scancode to report with the key.
+ *  @param[in] action `GLFW_PRESS`, `GLFW_RELEASE` or `GLFW_REPEAT`.
+ *  @param[in] mods Bit field describing which [modifier keys](@ref mods) were
+ *  held down.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED and @ref
+ *  GLFW_INVALID_ENUM.
+ *
+ *  @thread_safety This function may be called from any thread, but the window
+ *  must not be destroyed while it is executing.
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup native
+ */
+GLFWAPI void glfwInjectNullKey(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+/*! @brief Injects a synthetic Unicode character event into the specified
+ *  window.
+ *
+ *  @param[in] window The window to receive the event.
+ *  @param[in] codepoint The Unicode code point of the character.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED.
+ *
+ *  @thread_safety This function may be called from any thread, but the window
+ *  must not be destroyed while it is executing.
+ *
+ *  @sa @ref glfwInjectNullKey
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup native
+ */
+GLFWAPI void glfwInjectNullChar(GLFWwindow* window, unsigned int codepoint);
+
+/*! @brief Injects a synthetic mouse button event into the specified window.
+ *
+ *  @param[in] window The window to receive the event.
+ *  @param[in] button The [mouse button](@ref buttons).
+ *  @param[in] action `GLFW_PRESS` or `GLFW_RELEASE`.
+ *  @param[in] mods Bit field describing which [modifier keys](@ref mods) were
+ *  held down.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED and @ref
+ *  GLFW_INVALID_ENUM.
+ *
+ *  @thread_safety This function may be called from any thread, but the window
+ *  must not be destroyed while it is executing.
+ *
+ *  @sa @ref glfwInjectNullKey
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup native
+ */
+GLFWAPI void glfwInjectNullMouseButton(GLFWwindow* window, int button, int action, int mods);
+
+/*! @brief Injects a synthetic cursor motion event into the specified window.
+ *
+ *  The cursor enter and leave events are generated as the injected position
+ *  moves in and out of the content area of the window.
+ *
+ *  @param[in] window The window to receive the event.
+ *  @param[in] xpos The new cursor x-coordinate, relative to the left edge of
+ *  the content area.
+ *  @param[in] ypos The new cursor y-coordinate, relative to the top edge of the
+ *  content area.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED.
+ *
+ *  @thread_safety This function may be called from any thread, but the window
+ *  must not be destroyed while it is executing.
+ *
+ *  @sa @ref glfwInjectNullKey
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup native
+ */
+GLFWAPI void glfwInjectNullCursorPos(GLFWwindow* window, double xpos, double ypos);
+
+/*! @brief Injects a synthetic scroll event into the specified window.
+ *
+ *  @param[in] window The window to receive the event.
+ *  @param[in] xoffset The scroll offset along the x-axis.
+ *  @param[in] yoffset The scroll offset along the y-axis.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED.
+ *
+ *  @thread_safety This function may be called from any thread, but the window
+ *  must not be destroyed while it is executing.
+ *
+ *  @sa @ref glfwInjectNullKey
+ *
+ *  @since Added in version 3.3.
+ *
+ *  @ingroup native
+ */
+GLFWAPI void glfwInjectNullScroll(GLFWwindow* window, double xoffset, double yoffset);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
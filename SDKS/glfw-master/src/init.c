@@ -26,7 +26,6 @@
 //========================================================================
 
 #include "internal.h"
-#include "mappings.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -86,6 +85,7 @@ static void terminate(void)
     free(_glfw.mappings);
     _glfw.mappings = NULL;
     _glfw.mappingCount = 0;
+    _glfw.mappingBuckets = 0;
 
     _glfwTerminateVulkan();
     _glfwPlatformTerminate();
@@ -224,19 +224,6 @@ GLFWAPI int glfwInit(void)
 
     glfwDefaultWindowHints();
 
-    {
-        int i;
-
-        for (i = 0;  _glfwDefaultMappings[i];  i++)
-        {
-            if (!glfwUpdateGamepadMappings(_glfwDefaultMappings[i]))
-            {
-                terminate();
-                return GLFW_FALSE;
-            }
-        }
-    }
-
     return GLFW_TRUE;
 }
 
@@ -26,6 +26,7 @@
 //========================================================================
 
 #include "internal.h"
+#include "mappings.h"
 
 #include <assert.h>
 #include <float.h>
@@ -41,73 +42,6 @@
 #define _GLFW_JOYSTICK_BUTTON   2
 #define _GLFW_JOYSTICK_HATBIT   3
 
-// Finds a mapping based on joystick GUID
-//
-static _GLFWmapping* findMapping(const char* guid)
-{
-    int i;
-
-    for (i = 0;  i < _glfw.mappingCount;  i++)
-    {
-        if (strcmp(_glfw.mappings[i].guid, guid) == 0)
-            return _glfw.mappings + i;
-    }
-
-    return NULL;
-}
-
-// Checks whether a gamepad mapping element is present in the hardware
-//
-static GLFWbool isValidElementForJoystick(const _GLFWmapelement* e,
-                                          const _GLFWjoystick* js)
-{
-    if (e->type == _GLFW_JOYSTICK_HATBIT && (e->index >> 4) >= js->hatCount)
-        return GLFW_FALSE;
-    else if (e->type == _GLFW_JOYSTICK_BUTTON && e->index >= js->buttonCount)
-        return GLFW_FALSE;
-    else if (e->type == _GLFW_JOYSTICK_AXIS && e->index >= js->axisCount)
-        return GLFW_FALSE;
-
-    return GLFW_TRUE;
-}
-
-// Finds a mapping based on joystick GUID and verifies element indices
-//
-static _GLFWmapping* findValidMapping(const _GLFWjoystick* js)
-{
-    _GLFWmapping* mapping = findMapping(js->guid);
-    if (mapping)
-    {
-        int i;
-
-        for (i = 0;  i <= GLFW_GAMEPAD_BUTTON_LAST;  i++)
-        {
-            if (!isValidElementForJoystick(mapping->buttons + i, js))
-            {
-                _glfwInputError(GLFW_INVALID_VALUE,
-                                "Invalid button in gamepad mapping %s (%s)",
-                                mapping->guid,
-                                mapping->name);
-                return NULL;
-            }
-        }
-
-        for (i = 0;  i <= GLFW_GAMEPAD_AXIS_LAST;  i++)
-        {
-            if (!isValidElementForJoystick(mapping->axes + i, js))
-            {
-                _glfwInputError(GLFW_INVALID_VALUE,
-                                "Invalid axis in gamepad mapping %s (%s)",
-                                mapping->guid,
-                                mapping->name);
-                return NULL;
-            }
-        }
-    }
-
-    return mapping;
-}
-
 // Parses an SDL_GameControllerDB line and adds it to the mapping list
 //
 static GLFWbool parseMapping(_GLFWmapping* mapping, const char* string)
@@ -250,6 +184,277 @@ static GLFWbool parseMapping(_GLFWmapping* mapping, const char* string)
 }
 
 
+// Returns the hash of a joystick GUID
+// This must match hash_guid in GenerateMappings.cmake
+//
+static uint32_t hashGUID(const char* guid)
+{
+    int i;
+    uint32_t hash = 2166136261u;
+
+    for (i = 0;  i < 32;  i++)
+    {
+        const char c = guid[i];
+        uint32_t value;
+
+        if (c >= '0' && c <= '9')
+            value = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            value = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            value = c - 'A' + 10;
+        else
+            value = (unsigned char) c;
+
+        hash = (hash ^ value) * 16777619u;
+    }
+
+    return hash;
+}
+
+// Returns the bucket holding the mapping with the specified GUID, or the empty
+// bucket where it would be inserted
+//
+static _GLFWmapping* findMappingBucket(const char* guid)
+{
+    const uint32_t mask = (uint32_t) _glfw.mappingBuckets - 1;
+    uint32_t i = hashGUID(guid) & mask;
+
+    while (_glfw.mappings[i].guid[0] && strcmp(_glfw.mappings[i].guid, guid) != 0)
+        i = (i + 1) & mask;
+
+    return _glfw.mappings + i;
+}
+
+// Grows the mapping table to hold at least the specified number of mappings
+// while keeping it at most half full
+//
+static GLFWbool reserveMappings(int count)
+{
+    int i, jid, bucketCount;
+    char guids[GLFW_JOYSTICK_LAST + 1][33];
+    _GLFWmapping* previous = _glfw.mappings;
+    const int previousCount = _glfw.mappingBuckets;
+
+    if (count * 2 <= _glfw.mappingBuckets)
+        return GLFW_TRUE;
+
+    bucketCount = _glfw.mappingBuckets ? _glfw.mappingBuckets : 64;
+    while (bucketCount < count * 2)
+        bucketCount *= 2;
+
+    _glfw.mappings = calloc(bucketCount, sizeof(_GLFWmapping));
+    if (!_glfw.mappings)
+    {
+        _glfw.mappings = previous;
+        _glfwInputError(GLFW_OUT_OF_MEMORY, NULL);
+        return GLFW_FALSE;
+    }
+
+    // Joysticks keep pointers into the table, so find their mappings again
+    // once it has been rehashed
+    for (jid = 0;  jid <= GLFW_JOYSTICK_LAST;  jid++)
+    {
+        const _GLFWjoystick* js = _glfw.joysticks + jid;
+        if (js->present && js->mapping)
+            strcpy(guids[jid], js->mapping->guid);
+        else
+            guids[jid][0] = '\0';
+    }
+
+    _glfw.mappingBuckets = bucketCount;
+
+    for (i = 0;  i < previousCount;  i++)
+    {
+        if (previous[i].guid[0])
+            *findMappingBucket(previous[i].guid) = previous[i];
+    }
+
+    for (jid = 0;  jid <= GLFW_JOYSTICK_LAST;  jid++)
+    {
+        if (guids[jid][0])
+            _glfw.joysticks[jid].mapping = findMappingBucket(guids[jid]);
+    }
+
+    free(previous);
+    return GLFW_TRUE;
+}
+
+// Adds a mapping or replaces the one with the same GUID
+//
+static _GLFWmapping* insertMapping(const _GLFWmapping* mapping)
+{
+    _GLFWmapping* bucket;
+
+    if (!reserveMappings(_glfw.mappingCount + 1))
+        return NULL;
+
+    bucket = findMappingBucket(mapping->guid);
+    if (!bucket->guid[0])
+        _glfw.mappingCount++;
+
+    *bucket = *mapping;
+    return bucket;
+}
+
+// Parses the default mapping for the specified GUID and adds it to the
+// mapping table, using the generated GUID index of the default mappings
+//
+static _GLFWmapping* loadDefaultMapping(const char* guid)
+{
+    const uint32_t mask = _GLFW_DEFAULT_MAPPING_BUCKETS - 1;
+    uint32_t i;
+    int found = -1;
+    _GLFWmapping mapping;
+
+    for (i = hashGUID(guid) & mask;  _glfwDefaultMappingIndex[i];  i = (i + 1) & mask)
+    {
+        const int index = _glfwDefaultMappingIndex[i] - 1;
+        const char* string = _glfwDefaultMappings[index];
+        char translated[33];
+        int j;
+
+        // Later mappings replace earlier ones, as when they are added in order
+        if (index <= found)
+            continue;
+
+        for (j = 0;  j < 32 && string[j] != ',';  j++)
+        {
+            if (string[j] >= 'A' && string[j] <= 'F')
+                translated[j] = string[j] + 'a' - 'A';
+            else
+                translated[j] = string[j];
+        }
+
+        if (j < 32)
+            continue;
+
+        translated[32] = '\0';
+        _glfwPlatformUpdateGamepadGUID(translated);
+        if (strcmp(translated, guid) != 0)
+            continue;
+
+        {
+            _GLFWmapping candidate = {{0}};
+            if (parseMapping(&candidate, string))
+            {
+                mapping = candidate;
+                found = index;
+            }
+        }
+    }
+
+    if (found == -1)
+        return NULL;
+
+    return insertMapping(&mapping);
+}
+
+// Finds a mapping based on joystick GUID
+//
+static _GLFWmapping* findMapping(const char* guid)
+{
+    if (_glfw.mappingBuckets)
+    {
+        _GLFWmapping* mapping = findMappingBucket(guid);
+        if (mapping->guid[0])
+            return mapping;
+    }
+
+    return loadDefaultMapping(guid);
+}
+
+// Checks whether a gamepad mapping element is present in the hardware
+//
+static GLFWbool isValidElementForJoystick(const _GLFWmapelement* e,
+                                          const _GLFWjoystick* js)
+{
+    if (e->type == _GLFW_JOYSTICK_HATBIT && (e->index >> 4) >= js->hatCount)
+        return GLFW_FALSE;
+    else if (e->type == _GLFW_JOYSTICK_BUTTON && e->index >= js->buttonCount)
+        return GLFW_FALSE;
+    else if (e->type == _GLFW_JOYSTICK_AXIS && e->index >= js->axisCount)
+        return GLFW_FALSE;
+
+    return GLFW_TRUE;
+}
+
+// Finds a mapping based on joystick GUID and verifies element indices
+//
+static _GLFWmapping* findValidMapping(const _GLFWjoystick* js)
+{
+    _GLFWmapping* mapping = findMapping(js->guid);
+    if (mapping)
+    {
+        int i;
+
+        for (i = 0;  i <= GLFW_GAMEPAD_BUTTON_LAST;  i++)
+        {
+            if (!isValidElementForJoystick(mapping->buttons + i, js))
+            {
+                _glfwInputError(GLFW_INVALID_VALUE,
+                                "Invalid button in gamepad mapping %s (%s)",
+                                mapping->guid,
+                                mapping->name);
+                return NULL;
+            }
+        }
+
+        for (i = 0;  i <= GLFW_GAMEPAD_AXIS_LAST;  i++)
+        {
+            if (!isValidElementForJoystick(mapping->axes + i, js))
+            {
+                _glfwInputError(GLFW_INVALID_VALUE,
+                                "Invalid axis in gamepad mapping %s (%s)",
+                                mapping->guid,
+                                mapping->name);
+                return NULL;
+            }
+        }
+    }
+
+    return mapping;
+}
+
+
+// Appends an event of the specified type to the event queue of a window,
+// discarding the oldest event if the queue is full
+// Returns NULL if the window has no event queue
+//
+static GLFWevent* queueEvent(_GLFWwindow* window, int type)
+{
+    GLFWevent* event;
+
+    if (!window->queue.size)
+        return NULL;
+
+    if (window->queue.count == window->queue.size)
+    {
+        window->queue.head = (window->queue.head + 1) % window->queue.size;
+        window->queue.count--;
+    }
+
+    event = window->queue.events +
+        (window->queue.head + window->queue.count) % window->queue.size;
+    window->queue.count++;
+
+    memset(event, 0, sizeof(GLFWevent));
+    event->type = type;
+    event->time = _glfwPlatformGetTimerValue();
+    return event;
+}
+
+// Polls the joystick unless all joysticks have been polled by
+// glfwPollJoysticks since events were last processed
+//
+static int pollJoystick(_GLFWjoystick* js, int mode)
+{
+    if (_glfw.joysticksPolled)
+        return js->present;
+
+    return _glfwPlatformPollJoystick(js, mode);
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////                         GLFW event API                       //////
 //////////////////////////////////////////////////////////////////////////
@@ -280,6 +485,15 @@ void _glfwInputKey(_GLFWwindow* window, int key, int scancode, int action, int m
     if (!window->lockKeyMods)
         mods &= ~(GLFW_MOD_CAPS_LOCK | GLFW_MOD_NUM_LOCK);
 
+    if (window->queue.size)
+    {
+        GLFWevent* event = queueEvent(window, GLFW_EVENT_KEY);
+        event->key = key;
+        event->scancode = scancode;
+        event->action = action;
+        event->mods = mods;
+    }
+
     if (window->callbacks.key)
         window->callbacks.key((GLFWwindow*) window, key, scancode, action, mods);
 }
@@ -295,6 +509,13 @@ void _glfwInputChar(_GLFWwindow* window, unsigned int codepoint, int mods, GLFWb
     if (!window->lockKeyMods)
         mods &= ~(GLFW_MOD_CAPS_LOCK | GLFW_MOD_NUM_LOCK);
 
+    if (window->queue.size)
+    {
+        GLFWevent* event = queueEvent(window, GLFW_EVENT_CHAR);
+        event->codepoint = codepoint;
+        event->mods = mods;
+    }
+
     if (window->callbacks.charmods)
         window->callbacks.charmods((GLFWwindow*) window, codepoint, mods);
 
@@ -309,6 +530,13 @@ void _glfwInputChar(_GLFWwindow* window, unsigned int codepoint, int mods, GLFWb
 //
 void _glfwInputScroll(_GLFWwindow* window, double xoffset, double yoffset)
 {
+    if (window->queue.size)
+    {
+        GLFWevent* event = queueEvent(window, GLFW_EVENT_SCROLL);
+        event->x = xoffset;
+        event->y = yoffset;
+    }
+
     if (window->callbacks.scroll)
         window->callbacks.scroll((GLFWwindow*) window, xoffset, yoffset);
 }
@@ -328,6 +556,14 @@ void _glfwInputMouseClick(_GLFWwindow* window, int button, int action, int mods)
     else
         window->mouseButtons[button] = (char) action;
 
+    if (window->queue.size)
+    {
+        GLFWevent* event = queueEvent(window, GLFW_EVENT_MOUSE_BUTTON);
+        event->button = button;
+        event->action = action;
+        event->mods = mods;
+    }
+
     if (window->callbacks.mouseButton)
         window->callbacks.mouseButton((GLFWwindow*) window, button, action, mods);
 }
@@ -343,6 +579,30 @@ void _glfwInputCursorPos(_GLFWwindow* window, double xpos, double ypos)
     window->virtualCursorPosX = xpos;
     window->virtualCursorPosY = ypos;
 
+    if (window->queue.size)
+    {
+        GLFWevent* event = NULL;
+
+        // Merge with the most recent event if it is also cursor motion, as
+        // only the latest position matters
+        if (window->queue.count)
+        {
+            const int last = (window->queue.head + window->queue.count - 1) %
+                             window->queue.size;
+            if (window->queue.events[last].type == GLFW_EVENT_CURSOR_POS)
+            {
+                event = window->queue.events + last;
+                event->time = _glfwPlatformGetTimerValue();
+            }
+        }
+
+        if (!event)
+            event = queueEvent(window, GLFW_EVENT_CURSOR_POS);
+
+        event->x = xpos;
+        event->y = ypos;
+    }
+
     if (window->callbacks.cursorPos)
         window->callbacks.cursorPos((GLFWwindow*) window, xpos, ypos);
 }
@@ -351,6 +611,12 @@ void _glfwInputCursorPos(_GLFWwindow* window, double xpos, double ypos)
 //
 void _glfwInputCursorEnter(_GLFWwindow* window, GLFWbool entered)
 {
+    if (window->queue.size)
+    {
+        GLFWevent* event = queueEvent(window, GLFW_EVENT_CURSOR_ENTER);
+        event->action = entered;
+    }
+
     if (window->callbacks.cursorEnter)
         window->callbacks.cursorEnter((GLFWwindow*) window, entered);
 }
@@ -872,6 +1138,82 @@ GLFWAPI GLFWdropfun glfwSetDropCallback(GLFWwindow* handle, GLFWdropfun cbfun)
     return cbfun;
 }
 
+GLFWAPI void glfwSetEventQueueSize(GLFWwindow* handle, int size)
+{
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    assert(window != NULL);
+
+    _GLFW_REQUIRE_INIT();
+
+    if (size < 0)
+    {
+        _glfwInputError(GLFW_INVALID_VALUE, "Invalid event queue size %i", size);
+        return;
+    }
+
+    free(window->queue.events);
+    free(window->queue.drained);
+    memset(&window->queue, 0, sizeof(window->queue));
+
+    if (!size)
+        return;
+
+    window->queue.events = calloc(size, sizeof(GLFWevent));
+    window->queue.drained = calloc(size, sizeof(GLFWevent));
+    if (!window->queue.events || !window->queue.drained)
+    {
+        free(window->queue.events);
+        free(window->queue.drained);
+        memset(&window->queue, 0, sizeof(window->queue));
+
+        _glfwInputError(GLFW_OUT_OF_MEMORY, NULL);
+        return;
+    }
+
+    window->queue.size = size;
+}
+
+GLFWAPI const GLFWevent* glfwDrainEventQueue(GLFWwindow* handle, int* count)
+{
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    const GLFWevent* events;
+    int first;
+
+    assert(window != NULL);
+    assert(count != NULL);
+
+    *count = 0;
+
+    _GLFW_REQUIRE_INIT_OR_RETURN(NULL);
+
+    if (!window->queue.count)
+        return NULL;
+
+    // Events that wrap around the end of the ring are copied so they can be
+    // returned as a single array
+    first = window->queue.size - window->queue.head;
+    if (window->queue.count <= first)
+        events = window->queue.events + window->queue.head;
+    else
+    {
+        memcpy(window->queue.drained,
+               window->queue.events + window->queue.head,
+               first * sizeof(GLFWevent));
+        memcpy(window->queue.drained + first,
+               window->queue.events,
+               (window->queue.count - first) * sizeof(GLFWevent));
+        events = window->queue.drained;
+    }
+
+    *count = window->queue.count;
+
+    window->queue.head = (window->queue.head + window->queue.count) %
+                         window->queue.size;
+    window->queue.count = 0;
+
+    return events;
+}
+
 GLFWAPI int glfwJoystickPresent(int jid)
 {
     _GLFWjoystick* js;
@@ -891,7 +1233,23 @@ GLFWAPI int glfwJoystickPresent(int jid)
     if (!js->present)
         return GLFW_FALSE;
 
-    return _glfwPlatformPollJoystick(js, _GLFW_POLL_PRESENCE);
+    return pollJoystick(js, _GLFW_POLL_PRESENCE);
+}
+
+GLFWAPI void glfwPollJoysticks(void)
+{
+    int jid;
+
+    _GLFW_REQUIRE_INIT();
+
+    for (jid = 0;  jid <= GLFW_JOYSTICK_LAST;  jid++)
+    {
+        _GLFWjoystick* js = _glfw.joysticks + jid;
+        if (js->present)
+            _glfwPlatformPollJoystick(js, _GLFW_POLL_ALL);
+    }
+
+    _glfw.joysticksPolled = GLFW_TRUE;
 }
 
 GLFWAPI const float* glfwGetJoystickAxes(int jid, int* count)
@@ -916,7 +1274,7 @@ GLFWAPI const float* glfwGetJoystickAxes(int jid, int* count)
     if (!js->present)
         return NULL;
 
-    if (!_glfwPlatformPollJoystick(js, _GLFW_POLL_AXES))
+    if (!pollJoystick(js, _GLFW_POLL_AXES))
         return NULL;
 
     *count = js->axisCount;
@@ -945,7 +1303,7 @@ GLFWAPI const unsigned char* glfwGetJoystickButtons(int jid, int* count)
     if (!js->present)
         return NULL;
 
-    if (!_glfwPlatformPollJoystick(js, _GLFW_POLL_BUTTONS))
+    if (!pollJoystick(js, _GLFW_POLL_BUTTONS))
         return NULL;
 
     if (_glfw.hints.init.hatButtons)
@@ -978,7 +1336,7 @@ GLFWAPI const unsigned char* glfwGetJoystickHats(int jid, int* count)
     if (!js->present)
         return NULL;
 
-    if (!_glfwPlatformPollJoystick(js, _GLFW_POLL_BUTTONS))
+    if (!pollJoystick(js, _GLFW_POLL_BUTTONS))
         return NULL;
 
     *count = js->hatCount;
@@ -1004,7 +1362,7 @@ GLFWAPI const char* glfwGetJoystickName(int jid)
     if (!js->present)
         return NULL;
 
-    if (!_glfwPlatformPollJoystick(js, _GLFW_POLL_PRESENCE))
+    if (!pollJoystick(js, _GLFW_POLL_PRESENCE))
         return NULL;
 
     return js->name;
@@ -1029,7 +1387,7 @@ GLFWAPI const char* glfwGetJoystickGUID(int jid)
     if (!js->present)
         return NULL;
 
-    if (!_glfwPlatformPollJoystick(js, _GLFW_POLL_PRESENCE))
+    if (!pollJoystick(js, _GLFW_POLL_PRESENCE))
         return NULL;
 
     return js->guid;
@@ -1083,6 +1441,29 @@ GLFWAPI int glfwUpdateGamepadMappings(const char* string)
 
     _GLFW_REQUIRE_INIT_OR_RETURN(GLFW_FALSE);
 
+    // Grow the mapping table once for the whole database
+    {
+        int count = 0;
+
+        while (*c)
+        {
+            if ((*c >= '0' && *c <= '9') ||
+                (*c >= 'a' && *c <= 'f') ||
+                (*c >= 'A' && *c <= 'F'))
+            {
+                count++;
+            }
+
+            c += strcspn(c, "\r\n");
+            c += strspn(c, "\r\n");
+        }
+
+        if (!reserveMappings(_glfw.mappingCount + count))
+            return GLFW_FALSE;
+
+        c = string;
+    }
+
     while (*c)
     {
         if ((*c >= '0' && *c <= '9') ||
@@ -1100,19 +1481,7 @@ GLFWAPI int glfwUpdateGamepadMappings(const char* string)
                 line[length] = '\0';
 
                 if (parseMapping(&mapping, line))
-                {
-                    _GLFWmapping* previous = findMapping(mapping.guid);
-                    if (previous)
-                        *previous = mapping;
-                    else
-                    {
-                        _glfw.mappingCount++;
-                        _glfw.mappings =
-                            realloc(_glfw.mappings,
-                                    sizeof(_GLFWmapping) * _glfw.mappingCount);
-                        _glfw.mappings[_glfw.mappingCount - 1] = mapping;
-                    }
-                }
+                    insertMapping(&mapping);
             }
 
             c += length;
@@ -1153,7 +1522,7 @@ GLFWAPI int glfwJoystickIsGamepad(int jid)
     if (!js->present)
         return GLFW_FALSE;
 
-    if (!_glfwPlatformPollJoystick(js, _GLFW_POLL_PRESENCE))
+    if (!pollJoystick(js, _GLFW_POLL_PRESENCE))
         return GLFW_FALSE;
 
     return js->mapping != NULL;
@@ -1178,7 +1547,7 @@ GLFWAPI const char* glfwGetGamepadName(int jid)
     if (!js->present)
         return NULL;
 
-    if (!_glfwPlatformPollJoystick(js, _GLFW_POLL_PRESENCE))
+    if (!pollJoystick(js, _GLFW_POLL_PRESENCE))
         return NULL;
 
     if (!js->mapping)
@@ -1210,7 +1579,7 @@ GLFWAPI int glfwGetGamepadState(int jid, GLFWgamepadstate* state)
     if (!js->present)
         return GLFW_FALSE;
 
-    if (!_glfwPlatformPollJoystick(js, _GLFW_POLL_ALL))
+    if (!pollJoystick(js, _GLFW_POLL_ALL))
         return GLFW_FALSE;
 
     if (!js->mapping)
@@ -394,6 +394,16 @@ struct _GLFWwindow
     // Virtual cursor position when cursor is disabled
     double              virtualCursorPosX, virtualCursorPosY;
 
+    // Ring buffer of input events, enabled by glfwSetEventQueueSize
+    struct {
+        GLFWevent*      events;
+        // Contiguous copy returned when the queued events wrap around
+        GLFWevent*      drained;
+        int             size;
+        int             head;
+        int             count;
+    } queue;
+
     _GLFWcontext        context;
 
     struct {
@@ -532,8 +542,10 @@ struct _GLFWlibrary
     int                 monitorCount;
 
     _GLFWjoystick       joysticks[GLFW_JOYSTICK_LAST + 1];
+    GLFWbool            joysticksPolled;
     _GLFWmapping*       mappings;
     int                 mappingCount;
+    int                 mappingBuckets;
 
     _GLFWtls            errorSlot;
     _GLFWtls            contextSlot;
@@ -390,39 +390,54 @@ void _glfwDetectJoystickConnectionLinux(void)
 
 int _glfwPlatformPollJoystick(_GLFWjoystick* js, int mode)
 {
-    // Read all queued events (non-blocking)
+    // Read all queued events in batches (non-blocking)
     for (;;)
     {
-        struct input_event e;
+        ssize_t i, count;
+        struct input_event events[64];
 
-        errno = 0;
-        if (read(js->linjs.fd, &e, sizeof(e)) < 0)
+        const ssize_t size = read(js->linjs.fd, events, sizeof(events));
+        if (size < 0)
         {
             // Reset the joystick slot if the device was disconnected
             if (errno == ENODEV)
                 closeJoystick(js);
+            else if (errno == EINTR)
+                continue;
 
             break;
         }
 
-        if (e.type == EV_SYN)
+        count = size / sizeof(events[0]);
+
+        for (i = 0;  i < count;  i++)
         {
-            if (e.code == SYN_DROPPED)
-                _glfw.linjs.dropped = GLFW_TRUE;
-            else if (e.code == SYN_REPORT)
+            const struct input_event* e = events + i;
+
+            if (e->type == EV_SYN)
             {
-                _glfw.linjs.dropped = GLFW_FALSE;
-                pollAbsState(js);
+                if (e->code == SYN_DROPPED)
+                    js->linjs.dropped = GLFW_TRUE;
+                else if (e->code == SYN_REPORT && js->linjs.dropped)
+                {
+                    // Events were lost, so resynchronize with the device
+                    js->linjs.dropped = GLFW_FALSE;
+                    pollAbsState(js);
+                }
             }
-        }
 
-        if (_glfw.linjs.dropped)
-            continue;
+            if (js->linjs.dropped)
+                continue;
 
-        if (e.type == EV_KEY)
-            handleKeyEvent(js, e.code, e.value);
-        else if (e.type == EV_ABS)
-            handleAbsEvent(js, e.code, e.value);
+            if (e->type == EV_KEY)
+                handleKeyEvent(js, e->code, e->value);
+            else if (e->type == EV_ABS)
+                handleAbsEvent(js, e->code, e->value);
+        }
+
+        // A short read means the queue has been drained
+        if (count < (ssize_t) (sizeof(events) / sizeof(events[0])))
+            break;
     }
 
     return js->present;
@@ -43,6 +43,7 @@ typedef struct _GLFWjoystickLinux
     int                     absMap[ABS_CNT];
     struct input_absinfo    absInfo[ABS_CNT];
     int                     hats[4][2];
+    GLFWbool                dropped;
 } _GLFWjoystickLinux;
 
 // Linux-specific joystick API data
@@ -52,7 +53,6 @@ typedef struct _GLFWlibraryLinux
     int                     inotify;
     int                     watch;
     regex_t                 regex;
-    GLFWbool                dropped;
 } _GLFWlibraryLinux;
 
 
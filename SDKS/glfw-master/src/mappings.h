@@ -25,7 +25,8 @@
 //========================================================================
 // As mappings.h.in, this file is used by CMake to produce the mappings.h
 // header file.  If you are adding a GLFW specific gamepad mapping, this is
-// where to put it.
+// where to put it.  The GUID index below is generated from all mappings, so
+// mappings.h must be re-generated after any change here.
 //========================================================================
 // As mappings.h, this provides all pre-defined gamepad mappings, including
 // all available in SDL_GameControllerDB.  Do not edit this file.  Any gamepad
@@ -476,3 +477,75 @@ const char* _glfwDefaultMappings[] =
 NULL
 };
 
+// Open addressing hash index of _glfwDefaultMappings keyed by GUID.  Each
+// bucket holds the one-based index of a mapping, or zero if it is empty.
+#define _GLFW_DEFAULT_MAPPING_BUCKETS 1024
+
+const unsigned short _glfwDefaultMappingIndex[_GLFW_DEFAULT_MAPPING_BUCKETS] =
+{
+    0, 0, 0, 0, 313, 0, 288, 0, 0, 0, 0, 0, 0, 160, 197, 0,
+    0, 0, 0, 106, 0, 0, 114, 96, 337, 388, 0, 286, 0, 0, 0, 0,
+    296, 395, 359, 0, 0, 0, 363, 0, 0, 333, 0, 0, 0, 216, 0, 0,
+    0, 71, 3, 173, 0, 0, 0, 0, 0, 0, 0, 0, 265, 0, 0, 259,
+    307, 287, 30, 0, 0, 303, 0, 0, 99, 0, 45, 161, 280, 0, 0, 0,
+    42, 328, 332, 0, 0, 393, 43, 0, 0, 0, 0, 0, 0, 23, 381, 0,
+    220, 0, 375, 0, 225, 0, 36, 0, 0, 5, 0, 0, 291, 0, 0, 0,
+    0, 382, 366, 0, 0, 0, 0, 18, 389, 0, 0, 0, 0, 0, 0, 122,
+    235, 0, 0, 0, 0, 0, 0, 0, 0, 325, 326, 0, 314, 334, 335, 0,
+    0, 401, 0, 266, 0, 270, 0, 0, 0, 32, 0, 0, 77, 134, 245, 319,
+    0, 345, 0, 0, 0, 0, 127, 0, 348, 0, 0, 404, 0, 0, 0, 365,
+    0, 65, 123, 145, 0, 0, 147, 0, 0, 0, 0, 284, 0, 281, 228, 0,
+    0, 384, 0, 0, 0, 163, 329, 167, 203, 305, 140, 0, 184, 0, 144, 0,
+    0, 0, 0, 0, 0, 0, 322, 0, 0, 0, 273, 231, 0, 0, 109, 0,
+    257, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 327, 0, 0,
+    0, 157, 0, 211, 0, 0, 0, 0, 0, 7, 200, 336, 0, 0, 44, 0,
+    0, 0, 162, 0, 73, 204, 274, 0, 61, 0, 0, 92, 0, 0, 240, 126,
+    0, 0, 0, 0, 68, 0, 0, 0, 0, 0, 0, 0, 0, 58, 102, 0,
+    0, 0, 25, 148, 214, 306, 330, 110, 356, 0, 0, 244, 0, 62, 38, 63,
+    158, 151, 0, 368, 0, 300, 0, 100, 283, 0, 0, 0, 0, 0, 304, 371,
+    6, 81, 402, 0, 279, 84, 344, 0, 0, 0, 350, 0, 0, 0, 142, 0,
+    0, 261, 0, 247, 94, 349, 57, 213, 276, 19, 26, 0, 0, 118, 0, 129,
+    0, 169, 0, 121, 346, 354, 227, 66, 0, 239, 241, 0, 0, 249, 34, 75,
+    133, 153, 377, 0, 0, 0, 361, 0, 0, 341, 0, 412, 17, 50, 165, 360,
+    47, 221, 0, 0, 0, 0, 0, 0, 0, 0, 0, 139, 0, 8, 0, 0,
+    0, 28, 0, 0, 0, 0, 105, 0, 0, 67, 0, 339, 0, 0, 53, 347,
+    120, 308, 0, 0, 0, 324, 0, 0, 0, 379, 394, 253, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 236, 0, 0, 0, 0, 0, 323,
+    310, 0, 11, 175, 0, 0, 0, 0, 406, 46, 0, 181, 0, 0, 243, 293,
+    76, 190, 210, 292, 301, 0, 171, 398, 0, 0, 0, 0, 0, 69, 24, 408,
+    285, 233, 0, 0, 0, 0, 51, 108, 166, 187, 407, 0, 0, 0, 0, 56,
+    9, 0, 0, 132, 410, 0, 0, 376, 186, 0, 0, 0, 0, 113, 0, 409,
+    0, 0, 0, 0, 0, 40, 155, 215, 90, 193, 0, 0, 0, 0, 39, 0,
+    0, 0, 82, 12, 205, 311, 385, 131, 202, 156, 278, 411, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 104, 224, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 60, 206, 0, 0, 0, 0, 0, 159, 217, 294, 0, 0, 222, 0,
+    0, 0, 353, 0, 0, 0, 309, 14, 0, 2, 116, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 124, 37, 136, 55, 380, 403, 0, 0, 0, 0, 0,
+    342, 0, 0, 180, 0, 0, 251, 183, 299, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 232, 275, 0, 0, 0, 0, 41, 0, 0, 289, 0, 0,
+    0, 112, 21, 0, 0, 0, 0, 0, 0, 0, 302, 0, 0, 0, 0, 174,
+    88, 194, 0, 22, 89, 182, 207, 87, 0, 0, 0, 0, 0, 150, 238, 0,
+    0, 86, 0, 0, 0, 0, 248, 0, 0, 372, 378, 386, 0, 234, 338, 85,
+    179, 0, 0, 237, 0, 130, 201, 373, 0, 35, 64, 154, 16, 391, 0, 0,
+    0, 362, 400, 95, 195, 383, 405, 0, 0, 0, 107, 0, 0, 0, 0, 0,
+    374, 0, 0, 258, 0, 0, 0, 0, 0, 0, 0, 0, 80, 0, 98, 358,
+    246, 0, 230, 48, 199, 97, 268, 357, 340, 0, 191, 0, 178, 146, 0, 392,
+    0, 0, 0, 0, 226, 390, 152, 117, 0, 137, 0, 0, 0, 0, 0, 0,
+    318, 0, 196, 0, 0, 0, 0, 260, 399, 290, 0, 0, 0, 0, 0, 219,
+    0, 54, 0, 0, 0, 0, 0, 0, 0, 223, 277, 0, 0, 0, 320, 0,
+    343, 0, 0, 115, 254, 387, 0, 0, 0, 0, 0, 0, 397, 0, 0, 0,
+    128, 52, 168, 74, 176, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    29, 0, 0, 0, 0, 0, 0, 256, 0, 0, 0, 396, 83, 0, 170, 0,
+    0, 316, 0, 369, 0, 10, 272, 317, 370, 0, 0, 0, 91, 138, 0, 0,
+    27, 0, 367, 0, 352, 185, 0, 0, 0, 189, 0, 0, 4, 143, 264, 255,
+    295, 0, 0, 218, 33, 364, 0, 212, 282, 312, 0, 0, 93, 70, 172, 0,
+    0, 0, 78, 177, 119, 0, 0, 0, 0, 321, 0, 0, 0, 0, 0, 188,
+    0, 250, 125, 72, 0, 0, 0, 0, 263, 49, 351, 0, 0, 0, 262, 0,
+    0, 0, 149, 0, 0, 0, 111, 0, 0, 0, 252, 298, 0, 164, 267, 0,
+    0, 0, 103, 0, 0, 135, 198, 0, 0, 59, 0, 0, 0, 0, 0, 13,
+    31, 208, 0, 0, 0, 0, 79, 229, 242, 269, 297, 0, 101, 192, 0, 0,
+    0, 0, 355, 271, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 209, 315,
+    0, 331, 0, 0, 0, 141, 0, 0, 15, 0, 0, 0, 0, 0, 20, 0,
+};
+
@@ -27,6 +27,8 @@
 
 #include "internal.h"
 
+#include <stdlib.h>
+
 
 //////////////////////////////////////////////////////////////////////////
 //////                       GLFW platform API                      //////
@@ -34,12 +36,27 @@
 
 int _glfwPlatformInit(void)
 {
+    if (pthread_mutex_init(&_glfw.null.eventLock, NULL) != 0 ||
+        pthread_cond_init(&_glfw.null.eventCond, NULL) != 0)
+    {
+        _glfwInputError(GLFW_PLATFORM_ERROR,
+                        "Null: Failed to create event queue lock");
+        return GLFW_FALSE;
+    }
+
     _glfwInitTimerPOSIX();
+    _glfwPollMonitorsNull();
     return GLFW_TRUE;
 }
 
 void _glfwPlatformTerminate(void)
 {
+    free(_glfw.null.clipboardString);
+    free(_glfw.null.events);
+
+    pthread_cond_destroy(&_glfw.null.eventCond);
+    pthread_mutex_destroy(&_glfw.null.eventLock);
+
     _glfwTerminateOSMesa();
 }
 
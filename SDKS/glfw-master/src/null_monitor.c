@@ -27,6 +27,42 @@
 
 #include "internal.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+
+// The only video mode of the virtual monitor
+//
+static GLFWvidmode getVideoMode(void)
+{
+    GLFWvidmode mode;
+    mode.width = _GLFW_NULL_SCREEN_WIDTH;
+    mode.height = _GLFW_NULL_SCREEN_HEIGHT;
+    mode.redBits = 8;
+    mode.greenBits = 8;
+    mode.blueBits = 8;
+    mode.refreshRate = _GLFW_NULL_REFRESH_RATE;
+    return mode;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+//////                       GLFW internal API                      //////
+//////////////////////////////////////////////////////////////////////////
+
+// Creates the single virtual monitor, as if at 96 dpi
+//
+void _glfwPollMonitorsNull(void)
+{
+    const float dpi = 96.f;
+    _GLFWmonitor* monitor =
+        _glfwAllocMonitor("Null Virtual Monitor",
+                          (int) (_GLFW_NULL_SCREEN_WIDTH * 25.4f / dpi),
+                          (int) (_GLFW_NULL_SCREEN_HEIGHT * 25.4f / dpi));
+
+    _glfwInputMonitor(monitor, GLFW_CONNECTED, _GLFW_INSERT_FIRST);
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 //////                       GLFW platform API                      //////
@@ -34,10 +70,15 @@
 
 void _glfwPlatformFreeMonitor(_GLFWmonitor* monitor)
 {
+    _glfwFreeGammaArrays(&monitor->null.ramp);
 }
 
 void _glfwPlatformGetMonitorPos(_GLFWmonitor* monitor, int* xpos, int* ypos)
 {
+    if (xpos)
+        *xpos = 0;
+    if (ypos)
+        *ypos = 0;
 }
 
 void _glfwPlatformGetMonitorContentScale(_GLFWmonitor* monitor,
@@ -51,18 +92,53 @@ void _glfwPlatformGetMonitorContentScale(_GLFWmonitor* monitor,
 
 GLFWvidmode* _glfwPlatformGetVideoModes(_GLFWmonitor* monitor, int* found)
 {
-    return NULL;
+    GLFWvidmode* mode = calloc(1, sizeof(GLFWvidmode));
+    *mode = getVideoMode();
+    *found = 1;
+    return mode;
 }
 
 void _glfwPlatformGetVideoMode(_GLFWmonitor* monitor, GLFWvidmode* mode)
 {
+    *mode = getVideoMode();
 }
 
 void _glfwPlatformGetGammaRamp(_GLFWmonitor* monitor, GLFWgammaramp* ramp)
 {
+    if (!monitor->null.ramp.size)
+    {
+        unsigned int i;
+
+        _glfwAllocGammaArrays(&monitor->null.ramp, 256);
+
+        // Start out with the identity ramp of an uncalibrated display
+        for (i = 0;  i < monitor->null.ramp.size;  i++)
+        {
+            const unsigned short value =
+                (unsigned short) (i * 65535 / (monitor->null.ramp.size - 1));
+
+            monitor->null.ramp.red[i]   = value;
+            monitor->null.ramp.green[i] = value;
+            monitor->null.ramp.blue[i]  = value;
+        }
+    }
+
+    _glfwAllocGammaArrays(ramp, monitor->null.ramp.size);
+    memcpy(ramp->red,   monitor->null.ramp.red,   sizeof(short) * ramp->size);
+    memcpy(ramp->green, monitor->null.ramp.green, sizeof(short) * ramp->size);
+    memcpy(ramp->blue,  monitor->null.ramp.blue,  sizeof(short) * ramp->size);
 }
 
 void _glfwPlatformSetGammaRamp(_GLFWmonitor* monitor, const GLFWgammaramp* ramp)
 {
+    if (monitor->null.ramp.size != ramp->size)
+    {
+        _glfwFreeGammaArrays(&monitor->null.ramp);
+        _glfwAllocGammaArrays(&monitor->null.ramp, ramp->size);
+    }
+
+    memcpy(monitor->null.ramp.red,   ramp->red,   sizeof(short) * ramp->size);
+    memcpy(monitor->null.ramp.green, ramp->green, sizeof(short) * ramp->size);
+    memcpy(monitor->null.ramp.blue,  ramp->blue,  sizeof(short) * ramp->size);
 }
 
@@ -26,13 +26,14 @@
 //========================================================================
 
 #include <dlfcn.h>
+#include <pthread.h>
 
 #define _GLFW_PLATFORM_WINDOW_STATE _GLFWwindowNull null
+#define _GLFW_PLATFORM_MONITOR_STATE _GLFWmonitorNull null
+#define _GLFW_PLATFORM_LIBRARY_WINDOW_STATE _GLFWlibraryNull null
 
 #define _GLFW_PLATFORM_CONTEXT_STATE
-#define _GLFW_PLATFORM_MONITOR_STATE
 #define _GLFW_PLATFORM_CURSOR_STATE
-#define _GLFW_PLATFORM_LIBRARY_WINDOW_STATE
 #define _GLFW_PLATFORM_LIBRARY_CONTEXT_STATE
 #define _GLFW_EGL_CONTEXT_STATE
 #define _GLFW_EGL_LIBRARY_CONTEXT_STATE
@@ -52,11 +53,63 @@
  #define _glfw_dlsym(handle, name) dlsym(handle, name)
 #endif
 
+#define _GLFW_NULL_SCREEN_WIDTH  1920
+#define _GLFW_NULL_SCREEN_HEIGHT 1080
+#define _GLFW_NULL_REFRESH_RATE  60
+
 // Null-specific per-window data
 //
 typedef struct _GLFWwindowNull
 {
-    int width;
-    int height;
+    int             xpos;
+    int             ypos;
+    int             width;
+    int             height;
+    GLFWbool        visible;
+    GLFWbool        iconified;
+    GLFWbool        maximized;
+    GLFWbool        hovered;
+    float           opacity;
+    double          xcursor;
+    double          ycursor;
+    // Position and size to restore after maximization or full screen
+    int             restoreX, restoreY;
+    int             restoreWidth, restoreHeight;
 } _GLFWwindowNull;
 
+// Null-specific per-monitor data
+//
+typedef struct _GLFWmonitorNull
+{
+    GLFWgammaramp   ramp;
+} _GLFWmonitorNull;
+
+// Null-specific injected input event
+//
+typedef struct _GLFWeventNull
+{
+    _GLFWwindow*    window;
+    GLFWevent       event;
+} _GLFWeventNull;
+
+// Null-specific global data
+//
+typedef struct _GLFWlibraryNull
+{
+    char*           clipboardString;
+    _GLFWwindow*    focusedWindow;
+
+    // Injected events, which may be added from any thread
+    pthread_mutex_t eventLock;
+    pthread_cond_t  eventCond;
+    _GLFWeventNull* events;
+    int             eventCount;
+    int             eventCapacity;
+    GLFWbool        emptyEventPosted;
+    // Events taken from the queue by the event processing thread
+    _GLFWeventNull* dispatch;
+    int             dispatchCount;
+} _GLFWlibraryNull;
+
+void _glfwPollMonitorsNull(void);
+
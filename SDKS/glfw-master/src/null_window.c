@@ -27,16 +27,237 @@
 
 #include "internal.h"
 
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+
+// Applies the size limits and aspect ratio of the window to the given size
+//
+static void applySizeLimits(_GLFWwindow* window, int* width, int* height)
+{
+    if (window->numer != GLFW_DONT_CARE && window->denom != GLFW_DONT_CARE)
+    {
+        const float ratio = (float) window->numer / (float) window->denom;
+        *height = (int) (*width / ratio);
+    }
+
+    if (window->minwidth != GLFW_DONT_CARE && *width < window->minwidth)
+        *width = window->minwidth;
+    else if (window->maxwidth != GLFW_DONT_CARE && *width > window->maxwidth)
+        *width = window->maxwidth;
+
+    if (window->minheight != GLFW_DONT_CARE && *height < window->minheight)
+        *height = window->minheight;
+    else if (window->maxheight != GLFW_DONT_CARE && *height > window->maxheight)
+        *height = window->maxheight;
+}
+
+// Moves and resizes the window, reporting any changes to shared code
+//
+static void setWindowRect(_GLFWwindow* window,
+                          int xpos, int ypos,
+                          int width, int height)
+{
+    if (window->null.xpos != xpos || window->null.ypos != ypos)
+    {
+        window->null.xpos = xpos;
+        window->null.ypos = ypos;
+        _glfwInputWindowPos(window, xpos, ypos);
+    }
+
+    if (window->null.width != width || window->null.height != height)
+    {
+        window->null.width = width;
+        window->null.height = height;
+        _glfwInputWindowSize(window, width, height);
+        _glfwInputFramebufferSize(window, width, height);
+        _glfwInputWindowDamage(window);
+    }
+}
+
+// Makes the window cover its monitor
+//
+static void fitToMonitor(_GLFWwindow* window)
+{
+    int xpos, ypos;
+    GLFWvidmode mode;
+
+    _glfwPlatformGetMonitorPos(window->monitor, &xpos, &ypos);
+    _glfwPlatformGetVideoMode(window->monitor, &mode);
+    setWindowRect(window, xpos, ypos, mode.width, mode.height);
+}
+
+static void acquireMonitor(_GLFWwindow* window)
+{
+    _glfwInputMonitorWindow(window->monitor, window);
+}
+
+static void releaseMonitor(_GLFWwindow* window)
+{
+    if (window->monitor->window != window)
+        return;
+
+    _glfwInputMonitorWindow(window->monitor, NULL);
+}
 
 static int createNativeWindow(_GLFWwindow* window,
                               const _GLFWwndconfig* wndconfig)
 {
     window->null.width = wndconfig->width;
     window->null.height = wndconfig->height;
+    window->null.opacity = 1.f;
+
+    if (window->monitor)
+        fitToMonitor(window);
 
     return GLFW_TRUE;
 }
 
+// Adds an injected event to the queue and wakes up any waiting thread
+//
+static void postEvent(_GLFWwindow* window, const GLFWevent* event)
+{
+    pthread_mutex_lock(&_glfw.null.eventLock);
+
+    if (_glfw.null.eventCount == _glfw.null.eventCapacity)
+    {
+        const int capacity = _glfw.null.eventCapacity ?
+                             _glfw.null.eventCapacity * 2 : 64;
+        _GLFWeventNull* events = realloc(_glfw.null.events,
+                                         capacity * sizeof(_GLFWeventNull));
+        if (!events)
+        {
+            pthread_mutex_unlock(&_glfw.null.eventLock);
+            _glfwInputError(GLFW_OUT_OF_MEMORY, NULL);
+            return;
+        }
+
+        _glfw.null.events = events;
+        _glfw.null.eventCapacity = capacity;
+    }
+
+    _glfw.null.events[_glfw.null.eventCount].window = window;
+    _glfw.null.events[_glfw.null.eventCount].event = *event;
+    _glfw.null.eventCount++;
+
+    pthread_cond_signal(&_glfw.null.eventCond);
+    pthread_mutex_unlock(&_glfw.null.eventLock);
+}
+
+// Removes the queued and not yet dispatched events of the specified window
+//
+static void discardEvents(_GLFWwindow* window)
+{
+    int i, count = 0;
+
+    pthread_mutex_lock(&_glfw.null.eventLock);
+
+    for (i = 0;  i < _glfw.null.eventCount;  i++)
+    {
+        if (_glfw.null.events[i].window != window)
+            _glfw.null.events[count++] = _glfw.null.events[i];
+    }
+
+    _glfw.null.eventCount = count;
+
+    pthread_mutex_unlock(&_glfw.null.eventLock);
+
+    for (i = 0;  i < _glfw.null.dispatchCount;  i++)
+    {
+        if (_glfw.null.dispatch[i].window == window)
+            _glfw.null.dispatch[i].window = NULL;
+    }
+}
+
+// Passes an injected event to shared code as if it came from a real device
+//
+static void dispatchEvent(_GLFWwindow* window, const GLFWevent* event)
+{
+    switch (event->type)
+    {
+        case GLFW_EVENT_KEY:
+            _glfwInputKey(window, event->key, event->scancode,
+                          event->action, event->mods);
+            break;
+
+        case GLFW_EVENT_CHAR:
+            _glfwInputChar(window, event->codepoint, event->mods, GLFW_TRUE);
+            break;
+
+        case GLFW_EVENT_MOUSE_BUTTON:
+            _glfwInputMouseClick(window, event->button,
+                                 event->action, event->mods);
+            break;
+
+        case GLFW_EVENT_CURSOR_POS:
+        {
+            const GLFWbool inside = event->x >= 0.0 && event->y >= 0.0 &&
+                                    event->x < window->null.width &&
+                                    event->y < window->null.height;
+
+            if (window->cursorMode != GLFW_CURSOR_DISABLED &&
+                window->null.hovered != inside)
+            {
+                window->null.hovered = inside;
+                _glfwInputCursorEnter(window, inside);
+            }
+
+            window->null.xcursor = event->x;
+            window->null.ycursor = event->y;
+            _glfwInputCursorPos(window, event->x, event->y);
+            break;
+        }
+
+        case GLFW_EVENT_SCROLL:
+            _glfwInputScroll(window, event->x, event->y);
+            break;
+    }
+}
+
+// Waits until an event is injected or posted, or until the timeout expires
+//
+static void waitForEvent(double* timeout)
+{
+    struct timespec deadline;
+
+    if (timeout)
+    {
+        const long seconds = (long) *timeout;
+        const long nanoseconds = (long) ((*timeout - seconds) * 1e9);
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += seconds;
+        deadline.tv_nsec += nanoseconds;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&_glfw.null.eventLock);
+
+    while (!_glfw.null.eventCount && !_glfw.null.emptyEventPosted)
+    {
+        if (timeout)
+        {
+            if (pthread_cond_timedwait(&_glfw.null.eventCond,
+                                       &_glfw.null.eventLock,
+                                       &deadline) == ETIMEDOUT)
+            {
+                break;
+            }
+        }
+        else
+            pthread_cond_wait(&_glfw.null.eventCond, &_glfw.null.eventLock);
+    }
+
+    pthread_mutex_unlock(&_glfw.null.eventLock);
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 //////                       GLFW platform API                      //////
@@ -67,11 +288,28 @@ int _glfwPlatformCreateWindow(_GLFWwindow* window,
         }
     }
 
+    if (window->monitor)
+    {
+        _glfwPlatformShowWindow(window);
+        _glfwPlatformFocusWindow(window);
+        acquireMonitor(window);
+    }
+    else if (wndconfig->maximized)
+        _glfwPlatformMaximizeWindow(window);
+
     return GLFW_TRUE;
 }
 
 void _glfwPlatformDestroyWindow(_GLFWwindow* window)
 {
+    if (window->monitor)
+        releaseMonitor(window);
+
+    if (_glfw.null.focusedWindow == window)
+        _glfw.null.focusedWindow = NULL;
+
+    discardEvents(window);
+
     if (window->context.destroy)
         window->context.destroy(window);
 }
@@ -91,14 +329,43 @@ void _glfwPlatformSetWindowMonitor(_GLFWwindow* window,
                                    int width, int height,
                                    int refreshRate)
 {
+    if (window->monitor == monitor)
+    {
+        if (!monitor)
+            setWindowRect(window, xpos, ypos, width, height);
+
+        return;
+    }
+
+    if (window->monitor)
+        releaseMonitor(window);
+
+    _glfwInputWindowMonitor(window, monitor);
+
+    if (window->monitor)
+    {
+        window->null.visible = GLFW_TRUE;
+        acquireMonitor(window);
+        fitToMonitor(window);
+    }
+    else
+        setWindowRect(window, xpos, ypos, width, height);
 }
 
 void _glfwPlatformGetWindowPos(_GLFWwindow* window, int* xpos, int* ypos)
 {
+    if (xpos)
+        *xpos = window->null.xpos;
+    if (ypos)
+        *ypos = window->null.ypos;
 }
 
 void _glfwPlatformSetWindowPos(_GLFWwindow* window, int xpos, int ypos)
 {
+    if (window->monitor)
+        return;
+
+    setWindowRect(window, xpos, ypos, window->null.width, window->null.height);
 }
 
 void _glfwPlatformGetWindowSize(_GLFWwindow* window, int* width, int* height)
@@ -111,18 +378,30 @@ void _glfwPlatformGetWindowSize(_GLFWwindow* window, int* width, int* height)
 
 void _glfwPlatformSetWindowSize(_GLFWwindow* window, int width, int height)
 {
-    window->null.width = width;
-    window->null.height = height;
+    // The virtual monitor has only one video mode
+    if (window->monitor)
+        return;
+
+    applySizeLimits(window, &width, &height);
+    setWindowRect(window, window->null.xpos, window->null.ypos, width, height);
 }
 
 void _glfwPlatformSetWindowSizeLimits(_GLFWwindow* window,
                                       int minwidth, int minheight,
                                       int maxwidth, int maxheight)
 {
+    int width = window->null.width;
+    int height = window->null.height;
+    applySizeLimits(window, &width, &height);
+    setWindowRect(window, window->null.xpos, window->null.ypos, width, height);
 }
 
 void _glfwPlatformSetWindowAspectRatio(_GLFWwindow* window, int n, int d)
 {
+    int width = window->null.width;
+    int height = window->null.height;
+    applySizeLimits(window, &width, &height);
+    setWindowRect(window, window->null.xpos, window->null.ypos, width, height);
 }
 
 void _glfwPlatformGetFramebufferSize(_GLFWwindow* window, int* width, int* height)
@@ -137,6 +416,14 @@ void _glfwPlatformGetWindowFrameSize(_GLFWwindow* window,
                                      int* left, int* top,
                                      int* right, int* bottom)
 {
+    if (left)
+        *left = 0;
+    if (top)
+        *top = 0;
+    if (right)
+        *right = 0;
+    if (bottom)
+        *bottom = 0;
 }
 
 void _glfwPlatformGetWindowContentScale(_GLFWwindow* window,
@@ -150,24 +437,66 @@ void _glfwPlatformGetWindowContentScale(_GLFWwindow* window,
 
 void _glfwPlatformIconifyWindow(_GLFWwindow* window)
 {
+    if (window->null.iconified)
+        return;
+
+    if (_glfw.null.focusedWindow == window)
+    {
+        _glfw.null.focusedWindow = NULL;
+        _glfwInputWindowFocus(window, GLFW_FALSE);
+    }
+
+    window->null.iconified = GLFW_TRUE;
+    _glfwInputWindowIconify(window, GLFW_TRUE);
+
+    if (window->monitor)
+        releaseMonitor(window);
 }
 
 void _glfwPlatformRestoreWindow(_GLFWwindow* window)
 {
+    if (window->null.iconified)
+    {
+        window->null.iconified = GLFW_FALSE;
+        _glfwInputWindowIconify(window, GLFW_FALSE);
+
+        if (window->monitor)
+            acquireMonitor(window);
+    }
+    else if (window->null.maximized)
+    {
+        window->null.maximized = GLFW_FALSE;
+        setWindowRect(window,
+                      window->null.restoreX, window->null.restoreY,
+                      window->null.restoreWidth, window->null.restoreHeight);
+        _glfwInputWindowMaximize(window, GLFW_FALSE);
+    }
 }
 
 void _glfwPlatformMaximizeWindow(_GLFWwindow* window)
 {
+    if (window->monitor || window->null.maximized)
+        return;
+
+    window->null.restoreX = window->null.xpos;
+    window->null.restoreY = window->null.ypos;
+    window->null.restoreWidth = window->null.width;
+    window->null.restoreHeight = window->null.height;
+
+    window->null.maximized = GLFW_TRUE;
+    setWindowRect(window, 0, 0,
+                  _GLFW_NULL_SCREEN_WIDTH, _GLFW_NULL_SCREEN_HEIGHT);
+    _glfwInputWindowMaximize(window, GLFW_TRUE);
 }
 
 int _glfwPlatformWindowMaximized(_GLFWwindow* window)
 {
-    return GLFW_FALSE;
+    return window->null.maximized;
 }
 
 int _glfwPlatformWindowHovered(_GLFWwindow* window)
 {
-    return GLFW_FALSE;
+    return window->null.hovered;
 }
 
 int _glfwPlatformFramebufferTransparent(_GLFWwindow* window)
@@ -189,15 +518,17 @@ void _glfwPlatformSetWindowFloating(_GLFWwindow* window, GLFWbool enabled)
 
 float _glfwPlatformGetWindowOpacity(_GLFWwindow* window)
 {
-    return 1.f;
+    return window->null.opacity;
 }
 
 void _glfwPlatformSetWindowOpacity(_GLFWwindow* window, float opacity)
 {
+    window->null.opacity = opacity;
 }
 
 void _glfwPlatformShowWindow(_GLFWwindow* window)
 {
+    window->null.visible = GLFW_TRUE;
 }
 
 
@@ -207,53 +538,125 @@ void _glfwPlatformRequestWindowAttention(_GLFWwindow* window)
 
 void _glfwPlatformUnhideWindow(_GLFWwindow* window)
 {
+    window->null.visible = GLFW_TRUE;
 }
 
 void _glfwPlatformHideWindow(_GLFWwindow* window)
 {
+    if (_glfw.null.focusedWindow == window)
+    {
+        _glfw.null.focusedWindow = NULL;
+        _glfwInputWindowFocus(window, GLFW_FALSE);
+    }
+
+    window->null.visible = GLFW_FALSE;
 }
 
 void _glfwPlatformFocusWindow(_GLFWwindow* window)
 {
+    _GLFWwindow* previous = _glfw.null.focusedWindow;
+
+    if (previous == window || !window->null.visible)
+        return;
+
+    _glfw.null.focusedWindow = window;
+
+    if (previous)
+    {
+        _glfwInputWindowFocus(previous, GLFW_FALSE);
+        if (previous->monitor && previous->autoIconify)
+            _glfwPlatformIconifyWindow(previous);
+    }
+
+    _glfwInputWindowFocus(window, GLFW_TRUE);
 }
 
 int _glfwPlatformWindowFocused(_GLFWwindow* window)
 {
-    return GLFW_FALSE;
+    return _glfw.null.focusedWindow == window;
 }
 
 int _glfwPlatformWindowIconified(_GLFWwindow* window)
 {
-    return GLFW_FALSE;
+    return window->null.iconified;
 }
 
 int _glfwPlatformWindowVisible(_GLFWwindow* window)
 {
-    return GLFW_FALSE;
+    return window->null.visible;
 }
 
 void _glfwPlatformPollEvents(void)
 {
+    int i, capacity;
+
+    // Take the whole queue so that threads injecting events are only blocked
+    // for as long as it takes to swap the buffers
+    pthread_mutex_lock(&_glfw.null.eventLock);
+    _glfw.null.dispatch = _glfw.null.events;
+    _glfw.null.dispatchCount = _glfw.null.eventCount;
+    capacity = _glfw.null.eventCapacity;
+    _glfw.null.events = NULL;
+    _glfw.null.eventCount = 0;
+    _glfw.null.eventCapacity = 0;
+    _glfw.null.emptyEventPosted = GLFW_FALSE;
+    pthread_mutex_unlock(&_glfw.null.eventLock);
+
+    for (i = 0;  i < _glfw.null.dispatchCount;  i++)
+    {
+        _GLFWwindow* window = _glfw.null.dispatch[i].window;
+        if (window)
+            dispatchEvent(window, &_glfw.null.dispatch[i].event);
+    }
+
+    // Hand the buffer back for reuse unless new events arrived meanwhile
+    pthread_mutex_lock(&_glfw.null.eventLock);
+    if (!_glfw.null.events)
+    {
+        _glfw.null.events = _glfw.null.dispatch;
+        _glfw.null.eventCapacity = capacity;
+    }
+    else
+        free(_glfw.null.dispatch);
+    pthread_mutex_unlock(&_glfw.null.eventLock);
+
+    _glfw.null.dispatch = NULL;
+    _glfw.null.dispatchCount = 0;
 }
 
 void _glfwPlatformWaitEvents(void)
 {
+    waitForEvent(NULL);
+    _glfwPlatformPollEvents();
 }
 
 void _glfwPlatformWaitEventsTimeout(double timeout)
 {
+    waitForEvent(&timeout);
+    _glfwPlatformPollEvents();
 }
 
 void _glfwPlatformPostEmptyEvent(void)
 {
+    pthread_mutex_lock(&_glfw.null.eventLock);
+    _glfw.null.emptyEventPosted = GLFW_TRUE;
+    pthread_cond_signal(&_glfw.null.eventCond);
+    pthread_mutex_unlock(&_glfw.null.eventLock);
 }
 
 void _glfwPlatformGetCursorPos(_GLFWwindow* window, double* xpos, double* ypos)
 {
+    if (xpos)
+        *xpos = window->null.xcursor;
+    if (ypos)
+        *ypos = window->null.ycursor;
 }
 
 void _glfwPlatformSetCursorPos(_GLFWwindow* window, double x, double y)
 {
+    // Like a warp on other platforms this does not generate a cursor event
+    window->null.xcursor = x;
+    window->null.ycursor = y;
 }
 
 void _glfwPlatformSetCursorMode(_GLFWwindow* window, int mode)
@@ -282,11 +685,14 @@ void _glfwPlatformSetCursor(_GLFWwindow* window, _GLFWcursor* cursor)
 
 void _glfwPlatformSetClipboardString(const char* string)
 {
+    char* copy = _glfw_strdup(string);
+    free(_glfw.null.clipboardString);
+    _glfw.null.clipboardString = copy;
 }
 
 const char* _glfwPlatformGetClipboardString(void)
 {
-    return NULL;
+    return _glfw.null.clipboardString;
 }
 
 const char* _glfwPlatformGetScancodeName(int scancode)
@@ -319,3 +725,111 @@ VkResult _glfwPlatformCreateWindowSurface(VkInstance instance,
     return VK_ERROR_INITIALIZATION_FAILED;
 }
 
+
+//////////////////////////////////////////////////////////////////////////
+//////                        GLFW native API                       //////
+//////////////////////////////////////////////////////////////////////////
+
+GLFWAPI void glfwInjectNullKey(GLFWwindow* handle, int key, int scancode,
+                               int action, int mods)
+{
+    GLFWevent event;
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    assert(window != NULL);
+
+    _GLFW_REQUIRE_INIT();
+
+    if (key != GLFW_KEY_UNKNOWN && (key < GLFW_KEY_SPACE || key > GLFW_KEY_LAST))
+    {
+        _glfwInputError(GLFW_INVALID_ENUM, "Invalid key %i", key);
+        return;
+    }
+
+    if (action != GLFW_PRESS && action != GLFW_RELEASE && action != GLFW_REPEAT)
+    {
+        _glfwInputError(GLFW_INVALID_ENUM, "Invalid key action %i", action);
+        return;
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.type = GLFW_EVENT_KEY;
+    event.key = key;
+    event.scancode = scancode;
+    event.action = action;
+    event.mods = mods;
+    postEvent(window, &event);
+}
+
+GLFWAPI void glfwInjectNullChar(GLFWwindow* handle, unsigned int codepoint)
+{
+    GLFWevent event;
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    assert(window != NULL);
+
+    _GLFW_REQUIRE_INIT();
+
+    memset(&event, 0, sizeof(event));
+    event.type = GLFW_EVENT_CHAR;
+    event.codepoint = codepoint;
+    postEvent(window, &event);
+}
+
+GLFWAPI void glfwInjectNullMouseButton(GLFWwindow* handle, int button,
+                                       int action, int mods)
+{
+    GLFWevent event;
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    assert(window != NULL);
+
+    _GLFW_REQUIRE_INIT();
+
+    if (button < GLFW_MOUSE_BUTTON_1 || button > GLFW_MOUSE_BUTTON_LAST)
+    {
+        _glfwInputError(GLFW_INVALID_ENUM, "Invalid mouse button %i", button);
+        return;
+    }
+
+    if (action != GLFW_PRESS && action != GLFW_RELEASE)
+    {
+        _glfwInputError(GLFW_INVALID_ENUM, "Invalid mouse button action %i", action);
+        return;
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.type = GLFW_EVENT_MOUSE_BUTTON;
+    event.button = button;
+    event.action = action;
+    event.mods = mods;
+    postEvent(window, &event);
+}
+
+GLFWAPI void glfwInjectNullCursorPos(GLFWwindow* handle, double xpos, double ypos)
+{
+    GLFWevent event;
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    assert(window != NULL);
+
+    _GLFW_REQUIRE_INIT();
+
+    memset(&event, 0, sizeof(event));
+    event.type = GLFW_EVENT_CURSOR_POS;
+    event.x = xpos;
+    event.y = ypos;
+    postEvent(window, &event);
+}
+
+GLFWAPI void glfwInjectNullScroll(GLFWwindow* handle, double xoffset, double yoffset)
+{
+    GLFWevent event;
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    assert(window != NULL);
+
+    _GLFW_REQUIRE_INIT();
+
+    memset(&event, 0, sizeof(event));
+    event.type = GLFW_EVENT_SCROLL;
+    event.x = xoffset;
+    event.y = yoffset;
+    postEvent(window, &event);
+}
+
@@ -461,6 +461,9 @@ GLFWAPI void glfwDestroyWindow(GLFWwindow* handle)
 
     _glfwPlatformDestroyWindow(window);
 
+    free(window->queue.events);
+    free(window->queue.drained);
+
     // Unlink window from global linked list
     {
         _GLFWwindow** prev = &_glfw.windowListHead;
@@ -1072,6 +1075,7 @@ GLFWAPI GLFWwindowcontentscalefun glfwSetWindowContentScaleCallback(GLFWwindow*
 GLFWAPI void glfwPollEvents(void)
 {
     _GLFW_REQUIRE_INIT();
+    _glfw.joysticksPolled = GLFW_FALSE;
     _glfwPlatformPollEvents();
 }
 
@@ -1079,6 +1083,8 @@ GLFWAPI void glfwWaitEvents(void)
 {
     _GLFW_REQUIRE_INIT();
 
+    _glfw.joysticksPolled = GLFW_FALSE;
+
     if (!_glfw.windowListHead)
         return;
 
@@ -1098,6 +1104,7 @@ GLFWAPI void glfwWaitEventsTimeout(double timeout)
         return;
     }
 
+    _glfw.joysticksPolled = GLFW_FALSE;
     _glfwPlatformWaitEventsTimeout(timeout);
 }
 
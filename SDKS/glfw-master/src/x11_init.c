@@ -34,6 +34,12 @@
 #include <limits.h>
 #include <stdio.h>
 #include <locale.h>
+#include <errno.h>
+
+#if defined(__linux__)
+ #include <sys/epoll.h>
+ #include <sys/eventfd.h>
+#endif
 
 
 // Translate an X11 key code to a GLFW key code.
@@ -845,6 +851,69 @@ static int errorHandler(Display *display, XErrorEvent* event)
 }
 
 
+#if defined(__linux__)
+
+// Adds a descriptor to the set waited on for events
+//
+static GLFWbool addEventSource(int fd)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+
+    if (epoll_ctl(_glfw.x11.epoll, EPOLL_CTL_ADD, fd, &event) == -1)
+    {
+        _glfwInputError(GLFW_PLATFORM_ERROR,
+                        "X11: Failed to watch descriptor for events: %s",
+                        strerror(errno));
+        return GLFW_FALSE;
+    }
+
+    return GLFW_TRUE;
+}
+
+// Creates the epoll set and the eventfd used by glfwWaitEvents and
+// glfwPostEmptyEvent
+//
+static GLFWbool createEventSources(void)
+{
+    _glfw.x11.epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (_glfw.x11.epoll == -1)
+    {
+        _glfwInputError(GLFW_PLATFORM_ERROR,
+                        "X11: Failed to create epoll set: %s",
+                        strerror(errno));
+        return GLFW_FALSE;
+    }
+
+    _glfw.x11.emptyEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_glfw.x11.emptyEventFd == -1)
+    {
+        _glfwInputError(GLFW_PLATFORM_ERROR,
+                        "X11: Failed to create eventfd: %s",
+                        strerror(errno));
+        return GLFW_FALSE;
+    }
+
+    if (!addEventSource(ConnectionNumber(_glfw.x11.display)) ||
+        !addEventSource(_glfw.x11.emptyEventFd))
+    {
+        return GLFW_FALSE;
+    }
+
+    if (_glfw.linjs.inotify > 0)
+    {
+        if (!addEventSource(_glfw.linjs.inotify))
+            return GLFW_FALSE;
+    }
+
+    return GLFW_TRUE;
+}
+
+#endif // __linux__
+
+
 //////////////////////////////////////////////////////////////////////////
 //////                       GLFW internal API                      //////
 //////////////////////////////////////////////////////////////////////////
@@ -981,6 +1050,8 @@ int _glfwPlatformInit(void)
 #if defined(__linux__)
     if (!_glfwInitJoysticksLinux())
         return GLFW_FALSE;
+    if (!createEventSources())
+        return GLFW_FALSE;
 #endif
 
     _glfwInitTimerPOSIX();
@@ -1018,6 +1089,13 @@ void _glfwPlatformTerminate(void)
         _glfw.x11.im = NULL;
     }
 
+#if defined(__linux__)
+    if (_glfw.x11.emptyEventFd > 0)
+        close(_glfw.x11.emptyEventFd);
+    if (_glfw.x11.epoll > 0)
+        close(_glfw.x11.epoll);
+#endif
+
     if (_glfw.x11.display)
     {
         XCloseDisplay(_glfw.x11.display);
@@ -237,6 +237,12 @@ typedef struct _GLFWlibraryX11
     double          restoreCursorPosX, restoreCursorPosY;
     // The window whose disabled cursor mode is active
     _GLFWwindow*    disabledCursorWindow;
+#if defined(__linux__)
+    // Descriptors waited on by glfwWaitEvents
+    int             epoll;
+    // Event descriptor signaled by glfwPostEmptyEvent
+    int             emptyEventFd;
+#endif
 
     // Window manager atoms
     Atom            WM_PROTOCOLS;
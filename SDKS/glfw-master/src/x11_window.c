@@ -30,7 +30,13 @@
 #include <X11/cursorfont.h>
 #include <X11/Xmd.h>
 
-#include <sys/select.h>
+#include <poll.h>
+#include <unistd.h>
+#include <math.h>
+
+#if defined(__linux__)
+ #include <sys/epoll.h>
+#endif
 
 #include <string.h>
 #include <stdio.h>
@@ -51,37 +57,37 @@
 #define _GLFW_XDND_VERSION 5
 
 
-// Wait for data to arrive using select
+// Converts a timeout to whole milliseconds for poll and epoll_wait, clamped to
+// what an int can hold as longer waits are completed by the callers' loops
+//
+static int timeoutToMilliseconds(double timeout)
+{
+    const double milliseconds = ceil(timeout * 1000.0);
+
+    if (milliseconds >= (double) INT_MAX)
+        return INT_MAX;
+    if (milliseconds < 0.0)
+        return 0;
+
+    return (int) milliseconds;
+}
+
+// Wait for data to arrive on the X connection using poll
 // This avoids blocking other threads via the per-display Xlib lock that also
 // covers GLX functions
 //
 static GLFWbool waitForEvent(double* timeout)
 {
-    fd_set fds;
-    const int fd = ConnectionNumber(_glfw.x11.display);
-    int count = fd + 1;
+    struct pollfd fd = { ConnectionNumber(_glfw.x11.display), POLLIN };
 
-#if defined(__linux__)
-    if (_glfw.linjs.inotify > fd)
-        count = _glfw.linjs.inotify + 1;
-#endif
     for (;;)
     {
-        FD_ZERO(&fds);
-        FD_SET(fd, &fds);
-#if defined(__linux__)
-        if (_glfw.linjs.inotify > 0)
-            FD_SET(_glfw.linjs.inotify, &fds);
-#endif
-
         if (timeout)
         {
-            const long seconds = (long) *timeout;
-            const long microseconds = (long) ((*timeout - seconds) * 1e6);
-            struct timeval tv = { seconds, microseconds };
+            const int milliseconds = timeoutToMilliseconds(*timeout);
             const uint64_t base = _glfwPlatformGetTimerValue();
 
-            const int result = select(count, &fds, NULL, NULL, &tv);
+            const int result = poll(&fd, 1, milliseconds);
             const int error = errno;
 
             *timeout -= (_glfwPlatformGetTimerValue() - base) /
@@ -92,9 +98,64 @@ static GLFWbool waitForEvent(double* timeout)
             if ((result == -1 && error == EINTR) || *timeout <= 0.0)
                 return GLFW_FALSE;
         }
-        else if (select(count, &fds, NULL, NULL, NULL) != -1 || errno != EINTR)
+        else if (poll(&fd, 1, -1) != -1 || errno != EINTR)
+            return GLFW_TRUE;
+    }
+}
+
+// Wait for X events, empty events or joystick connection changes
+// On Linux this uses a persistent epoll set, so the cost of waiting does not
+// depend on how many descriptors are watched, and empty events posted from
+// other threads arrive via an eventfd without a round-trip to the X server
+//
+static GLFWbool waitForAnyEvent(double* timeout)
+{
+#if defined(__linux__)
+    struct epoll_event events[3];
+
+    for (;;)
+    {
+        int i, result, error, milliseconds = -1;
+        uint64_t base = 0;
+
+        if (timeout)
+        {
+            milliseconds = timeoutToMilliseconds(*timeout);
+            base = _glfwPlatformGetTimerValue();
+        }
+
+        result = epoll_wait(_glfw.x11.epoll, events,
+                            sizeof(events) / sizeof(events[0]),
+                            milliseconds);
+        error = errno;
+
+        for (i = 0;  i < result;  i++)
+        {
+            if (events[i].data.fd == _glfw.x11.emptyEventFd)
+            {
+                uint64_t count;
+                while (read(_glfw.x11.emptyEventFd, &count, sizeof(count)) == -1 &&
+                       errno == EINTR)
+                    ;
+            }
+        }
+
+        if (timeout)
+        {
+            *timeout -= (_glfwPlatformGetTimerValue() - base) /
+                (double) _glfwPlatformGetTimerFrequency();
+
+            if (result > 0)
+                return GLFW_TRUE;
+            if ((result == -1 && error == EINTR) || *timeout <= 0.0)
+                return GLFW_FALSE;
+        }
+        else if (result != -1 || error != EINTR)
             return GLFW_TRUE;
     }
+#else
+    return waitForEvent(timeout);
+#endif
 }
 
 // Waits until a VisibilityNotify event arrives for the specified window or the
@@ -2672,25 +2733,29 @@ void _glfwPlatformPollEvents(void)
 
 void _glfwPlatformWaitEvents(void)
 {
-    while (!XPending(_glfw.x11.display))
-        waitForEvent(NULL);
+    if (!XPending(_glfw.x11.display))
+        waitForAnyEvent(NULL);
 
     _glfwPlatformPollEvents();
 }
 
 void _glfwPlatformWaitEventsTimeout(double timeout)
 {
-    while (!XPending(_glfw.x11.display))
-    {
-        if (!waitForEvent(&timeout))
-            break;
-    }
+    if (!XPending(_glfw.x11.display))
+        waitForAnyEvent(&timeout);
 
     _glfwPlatformPollEvents();
 }
 
 void _glfwPlatformPostEmptyEvent(void)
 {
+#if defined(__linux__)
+    const uint64_t one = 1;
+
+    while (write(_glfw.x11.emptyEventFd, &one, sizeof(one)) == -1 &&
+           errno == EINTR)
+        ;
+#else
     XEvent event;
 
     memset(&event, 0, sizeof(event));
@@ -2701,6 +2766,7 @@ void _glfwPlatformPostEmptyEvent(void)
 
     XSendEvent(_glfw.x11.display, _glfw.x11.helperWindowHandle, False, 0, &event);
     XFlush(_glfw.x11.display);
+#endif
 }
 
 void _glfwPlatformGetCursorPos(_GLFWwindow* window, double* xpos, double* ypos)
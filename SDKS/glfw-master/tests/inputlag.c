@@ -26,8 +26,18 @@
 // This test renders a marker at the cursor position reported by GLFW to
 // check how much it lags behind the hardware mouse cursor
 //
+// In automated mode it instead moves the cursor along a scripted path,
+// timestamps each injected position and waits for the frame showing it to
+// complete, logging present intervals, swap interval jitter and input to
+// present latency so frame pacing changes can be compared between runs
+//
 //========================================================================
 
+#if defined(_MSC_VER)
+ // Make MS math.h define M_PI
+ #define _USE_MATH_DEFINES
+#endif
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -46,15 +56,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "getopt.h"
 
 void usage(void)
 {
-    printf("Usage: inputlag [-h] [-f]\n");
+    printf("Usage: inputlag [-h] [-f] [-a] [-n FRAMES] [-i INTERVAL] [-o FILE] [-g FILE]\n");
     printf("Options:\n");
+    printf("  -a run automated latency measurement and exit\n");
     printf("  -f create full screen window\n");
+    printf("  -g write latency and interval histograms as CSV to FILE\n");
     printf("  -h show this help\n");
+    printf("  -i use swap interval INTERVAL when vsync is enabled (default 1)\n");
+    printf("  -n measure FRAMES frames in automated mode (default 600)\n");
+    printf("  -o write per-frame timings as CSV to FILE\n");
 }
 
 struct nk_vec2 cursor_new, cursor_pos, cursor_vel;
@@ -83,10 +99,11 @@ void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos)
 }
 
 int enable_vsync = nk_true;
+int swap_interval = 1;
 
 void update_vsync()
 {
-    glfwSwapInterval(enable_vsync == nk_true ? 1 : 0);
+    glfwSwapInterval(enable_vsync == nk_true ? swap_interval : 0);
 }
 
 int swap_clear = nk_false;
@@ -123,6 +140,264 @@ void swap_buffers(GLFWwindow* window)
     }
 }
 
+#define MAX_PENDING 64
+#define HISTOGRAM_BINS 200
+#define HISTOGRAM_BIN_WIDTH 0.5 // milliseconds
+
+typedef struct
+{
+    float x, y;
+    uint64_t time;
+} Injection;
+
+struct
+{
+    int enabled;
+    unsigned long frame_limit;
+    FILE* csv;
+    double expected_interval;
+    Injection pending[MAX_PENDING];
+    int pending_count;
+    uint64_t last_present;
+    unsigned long frames, matched, superseded;
+    unsigned long latency_bins[HISTOGRAM_BINS + 1];
+    unsigned long interval_bins[HISTOGRAM_BINS + 1];
+    double latency_sum, latency_min, latency_max;
+    double interval_sum, interval_square_sum;
+    double jitter_max;
+} automation = { GLFW_FALSE, 600 };
+
+double ticks_to_ms(uint64_t ticks)
+{
+    return ticks * 1000.0 / (double) glfwGetTimerFrequency();
+}
+
+void add_to_histogram(unsigned long* bins, double value)
+{
+    int bin = (int) (value / HISTOGRAM_BIN_WIDTH);
+    if (bin < 0)
+        bin = 0;
+    if (bin > HISTOGRAM_BINS)
+        bin = HISTOGRAM_BINS;
+    bins[bin]++;
+}
+
+double histogram_percentile(const unsigned long* bins, double fraction)
+{
+    int bin;
+    unsigned long total = 0, sum = 0;
+
+    for (bin = 0;  bin <= HISTOGRAM_BINS;  bin++)
+        total += bins[bin];
+
+    for (bin = 0;  bin <= HISTOGRAM_BINS;  bin++)
+    {
+        sum += bins[bin];
+        if (sum > 0 && sum >= total * fraction)
+            break;
+    }
+
+    return (bin + 1) * HISTOGRAM_BIN_WIDTH;
+}
+
+// Moves the cursor to the next point of a circle around the window center
+// and remembers when it was done, so the frame showing it can be matched
+//
+void inject_input(GLFWwindow* window)
+{
+    int width, height;
+    const double angle = automation.frames * 2.0 * M_PI / 120.0;
+    Injection injection;
+
+    glfwGetWindowSize(window, &width, &height);
+
+    injection.x = (float) floor(width / 2.0 + cos(angle) * width / 4.0);
+    injection.y = (float) floor(height / 2.0 + sin(angle) * height / 4.0);
+
+    if (automation.pending_count == MAX_PENDING)
+    {
+        memmove(automation.pending, automation.pending + 1,
+                (MAX_PENDING - 1) * sizeof(Injection));
+        automation.pending_count--;
+        automation.superseded++;
+    }
+
+    injection.time = glfwGetTimerValue();
+    glfwSetCursorPos(window, injection.x, injection.y);
+    automation.pending[automation.pending_count++] = injection;
+}
+
+// Returns the time the cursor position used for drawing was received, which
+// is when its event was queued if there was one and otherwise now
+//
+uint64_t receive_time(GLFWwindow* window)
+{
+    int i, count;
+    uint64_t time = glfwGetTimerValue();
+    const GLFWevent* events = glfwDrainEventQueue(window, &count);
+
+    for (i = 0;  i < count;  i++)
+    {
+        if (events[i].type == GLFW_EVENT_CURSOR_POS &&
+            (float) events[i].x == cursor_pos.x &&
+            (float) events[i].y == cursor_pos.y)
+        {
+            time = events[i].time;
+        }
+    }
+
+    return time;
+}
+
+// Waits until the GPU has completed the frame just swapped, using a fence
+// where available, and returns when that happened
+//
+uint64_t wait_for_present(void)
+{
+    if (GLAD_GL_VERSION_3_2)
+    {
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(fence);
+    }
+    else
+        glFinish();
+
+    return glfwGetTimerValue();
+}
+
+void record_frame(uint64_t received, uint64_t presented)
+{
+    int i;
+    double interval = 0.0, jitter = 0.0, latency = 0.0, delivery = 0.0;
+    int has_interval = automation.last_present != 0;
+    int has_latency = GLFW_FALSE;
+
+    if (has_interval)
+    {
+        interval = ticks_to_ms(presented - automation.last_present);
+        if (automation.expected_interval > 0.0)
+            jitter = interval - automation.expected_interval;
+
+        automation.interval_sum += interval;
+        automation.interval_square_sum += interval * interval;
+        if (fabs(jitter) > automation.jitter_max)
+            automation.jitter_max = fabs(jitter);
+
+        add_to_histogram(automation.interval_bins, interval);
+    }
+
+    automation.last_present = presented;
+
+    for (i = automation.pending_count - 1;  i >= 0;  i--)
+    {
+        const Injection* injection = automation.pending + i;
+
+        if (injection->x == cursor_pos.x && injection->y == cursor_pos.y)
+        {
+            latency = ticks_to_ms(presented - injection->time);
+            if (received > injection->time)
+                delivery = ticks_to_ms(received - injection->time);
+
+            has_latency = GLFW_TRUE;
+            break;
+        }
+    }
+
+    if (has_latency)
+    {
+        // Positions injected before the matched one were never drawn
+        automation.superseded += i;
+        automation.pending_count -= i + 1;
+        memmove(automation.pending, automation.pending + i + 1,
+                automation.pending_count * sizeof(Injection));
+
+        if (!automation.matched || latency < automation.latency_min)
+            automation.latency_min = latency;
+        if (latency > automation.latency_max)
+            automation.latency_max = latency;
+
+        automation.latency_sum += latency;
+        automation.matched++;
+
+        add_to_histogram(automation.latency_bins, latency);
+    }
+
+    if (automation.csv)
+    {
+        fprintf(automation.csv, "%lu,%.3f,", automation.frames, ticks_to_ms(presented));
+
+        if (has_interval)
+            fprintf(automation.csv, "%.3f,%.3f,", interval, jitter);
+        else
+            fprintf(automation.csv, ",,");
+
+        if (has_latency)
+            fprintf(automation.csv, "%.3f,%.3f\n", delivery, latency);
+        else
+            fprintf(automation.csv, ",\n");
+    }
+
+    automation.frames++;
+}
+
+int write_histograms(const char* path)
+{
+    int bin;
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return GLFW_FALSE;
+
+    fprintf(file, "bin_ms,latency_frames,interval_frames\n");
+
+    for (bin = 0;  bin <= HISTOGRAM_BINS;  bin++)
+    {
+        fprintf(file, "%.1f,%lu,%lu\n",
+                bin * HISTOGRAM_BIN_WIDTH,
+                automation.latency_bins[bin],
+                automation.interval_bins[bin]);
+    }
+
+    fclose(file);
+    return GLFW_TRUE;
+}
+
+void print_summary(void)
+{
+    const unsigned long intervals = automation.frames - 1;
+
+    printf("%lu frames, %lu matched, %lu injected positions never shown\n",
+           automation.frames, automation.matched, automation.superseded);
+
+    if (intervals > 0)
+    {
+        const double mean = automation.interval_sum / intervals;
+        const double variance = automation.interval_square_sum / intervals - mean * mean;
+
+        printf("Present interval: mean %.3f ms, stddev %.3f ms",
+               mean, variance > 0.0 ? sqrt(variance) : 0.0);
+
+        if (automation.expected_interval > 0.0)
+        {
+            printf(", expected %.3f ms, max jitter %.3f ms",
+                   automation.expected_interval, automation.jitter_max);
+        }
+
+        printf("\n");
+    }
+
+    if (automation.matched > 0)
+    {
+        printf("Input to present latency: mean %.3f ms, min %.3f ms, max %.3f ms, "
+               "p50 < %.1f ms, p99 < %.1f ms\n",
+               automation.latency_sum / automation.matched,
+               automation.latency_min,
+               automation.latency_max,
+               histogram_percentile(automation.latency_bins, 0.5),
+               histogram_percentile(automation.latency_bins, 0.99));
+    }
+}
+
 void error_callback(int error, const char* description)
 {
     fprintf(stderr, "Error: %s\n", description);
@@ -152,6 +427,7 @@ int main(int argc, char** argv)
 {
     int ch, width, height;
     unsigned long frame_count = 0;
+    const char* histogram_path = NULL;
     double last_time, current_time;
     double frame_rate = 0;
     int fullscreen = GLFW_FALSE;
@@ -162,7 +438,7 @@ int main(int argc, char** argv)
 
     int show_forecasts = nk_true;
 
-    while ((ch = getopt(argc, argv, "fh")) != -1)
+    while ((ch = getopt(argc, argv, "afg:hi:n:o:")) != -1)
     {
         switch (ch)
         {
@@ -170,9 +446,42 @@ int main(int argc, char** argv)
                 usage();
                 exit(EXIT_SUCCESS);
 
+            case 'a':
+                automation.enabled = GLFW_TRUE;
+                break;
+
             case 'f':
                 fullscreen = GLFW_TRUE;
                 break;
+
+            case 'g':
+                histogram_path = optarg;
+                break;
+
+            case 'i':
+                swap_interval = atoi(optarg);
+                enable_vsync = swap_interval > 0;
+                break;
+
+            case 'n':
+                automation.frame_limit = strtoul(optarg, NULL, 10);
+                break;
+
+            case 'o':
+                automation.csv = fopen(optarg, "w");
+                if (!automation.csv)
+                {
+                    fprintf(stderr, "Failed to open %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+
+                fprintf(automation.csv, "frame,present_ms,interval_ms,jitter_ms,"
+                                        "delivery_ms,latency_ms\n");
+                break;
+
+            default:
+                usage();
+                exit(EXIT_FAILURE);
         }
     }
 
@@ -222,14 +531,38 @@ int main(int argc, char** argv)
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, cursor_pos_callback);
 
+    if (automation.enabled)
+    {
+        const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        if (monitor)
+            mode = glfwGetVideoMode(monitor);
+
+        if (enable_vsync && mode && mode->refreshRate > 0)
+            automation.expected_interval = swap_interval * 1000.0 / mode->refreshRate;
+
+        glfwSetEventQueueSize(window, 256);
+    }
+
     while (!glfwWindowShouldClose(window))
     {
         int width, height;
         struct nk_rect area;
+        uint64_t received = 0;
+
+        if (automation.enabled)
+        {
+            if (automation.frames == automation.frame_limit)
+                break;
+
+            inject_input(window);
+        }
 
         glfwPollEvents();
         sample_input(window);
 
+        if (automation.enabled)
+            received = receive_time(window);
+
         glfwGetWindowSize(window, &width, &height);
         area = nk_rect(0.f, 0.f, (float) width, (float) height);
 
@@ -290,6 +623,9 @@ int main(int argc, char** argv)
 
         swap_buffers(window);
 
+        if (automation.enabled)
+            record_frame(received, wait_for_present());
+
         frame_count++;
 
         current_time = glfwGetTime();
@@ -302,6 +638,19 @@ int main(int argc, char** argv)
     }
 
     glfwTerminate();
+
+    if (automation.enabled)
+        print_summary();
+
+    if (automation.csv)
+        fclose(automation.csv);
+
+    if (histogram_path && !write_histograms(histogram_path))
+    {
+        fprintf(stderr, "Failed to write %s\n", histogram_path);
+        exit(EXIT_FAILURE);
+    }
+
     exit(EXIT_SUCCESS);
 }
 
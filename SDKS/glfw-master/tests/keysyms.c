@@ -0,0 +1,237 @@
+//========================================================================
+// KeySym to Unicode lookup benchmark
+// Copyright (c) 2026 agent <agent@local>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would
+//    be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not
+//    be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source
+//    distribution.
+//
+//========================================================================
+//
+// This test checks that the page table lookup of _glfwKeySym2Unicode gives
+// the same results as a binary search of the KeySym to Unicode mapping table
+// and compares their speed on keysym sequences resembling text entry
+//
+//========================================================================
+
+#include "xkb_unicode.h"
+#include "keysyms.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "getopt.h"
+
+#define SEQUENCE_LENGTH 65536
+
+// Keys other than characters that are common while typing
+static const unsigned int editing_keysyms[] =
+{
+    0xff08, // BackSpace
+    0xff09, // Tab
+    0xff0d, // Return
+    0xff51, // Left
+    0xff53, // Right
+    0xffe1, // Shift_L
+    0xffe3, // Control_L
+};
+
+typedef struct
+{
+    const char* name;
+    // Ranges of keysyms of the typed script
+    unsigned int first, last;
+    // Percentage of keysyms taken from the script rather than ASCII
+    int script_percent;
+} Workload;
+
+static const Workload workloads[] =
+{
+    { "English",  0x0000, 0x0000,  0 },
+    { "Russian",  0x06c0, 0x06ff, 80 },
+    { "Greek",    0x07e1, 0x07f9, 80 },
+    { "Hebrew",   0x0ce0, 0x0cfa, 80 },
+    { "Arabic",   0x05c1, 0x05f2, 80 },
+    { "Thai",     0x0da1, 0x0df9, 80 },
+    { "Korean",   0x0ea1, 0x0efa, 80 },
+    { "Japanese", 0x04a1, 0x04df, 80 },
+};
+
+static void usage(void)
+{
+    printf("Usage: keysyms [-h] [-r ROUNDS]\n");
+    printf("Options:\n");
+    printf("  -h show this help\n");
+    printf("  -r repeat each sequence ROUNDS times (default 200)\n");
+}
+
+// The lookup used before the page tables, kept as the reference
+//
+static long search_keysym(unsigned int keysym)
+{
+    int min = 0;
+    int max = sizeof(keysymtab) / sizeof(struct codepair) - 1;
+    int mid;
+
+    if ((keysym >= 0x0020 && keysym <= 0x007e) ||
+        (keysym >= 0x00a0 && keysym <= 0x00ff))
+    {
+        return keysym;
+    }
+
+    if ((keysym & 0xff000000) == 0x01000000)
+        return keysym & 0x00ffffff;
+
+    while (max >= min)
+    {
+        mid = (min + max) / 2;
+        if (keysymtab[mid].keysym < keysym)
+            min = mid + 1;
+        else if (keysymtab[mid].keysym > keysym)
+            max = mid - 1;
+        else
+            return keysymtab[mid].ucs;
+    }
+
+    return -1;
+}
+
+static unsigned int random_value(unsigned int* state)
+{
+    *state = *state * 1103515245 + 12345;
+    return (*state >> 16) & 0x7fff;
+}
+
+// Fills the sequence with the keysyms of typing text in the specified script,
+// with words separated by spaces and the occasional editing key
+//
+static void generate_sequence(unsigned int* sequence, const Workload* workload)
+{
+    int i;
+    unsigned int state = 1;
+    const size_t editing_count = sizeof(editing_keysyms) / sizeof(editing_keysyms[0]);
+
+    for (i = 0;  i < SEQUENCE_LENGTH;  i++)
+    {
+        const unsigned int roll = random_value(&state) % 100;
+
+        if (roll < 15)
+            sequence[i] = ' ';
+        else if (roll < 20)
+            sequence[i] = editing_keysyms[random_value(&state) % editing_count];
+        else if ((int) roll < 20 + workload->script_percent * 80 / 100)
+        {
+            const unsigned int count = workload->last - workload->first + 1;
+            sequence[i] = workload->first + random_value(&state) % count;
+        }
+        else
+            sequence[i] = 'a' + random_value(&state) % 26;
+    }
+}
+
+static double time_lookups(long (*lookup)(unsigned int),
+                           const unsigned int* sequence,
+                           int rounds,
+                           long* checksum)
+{
+    int i, round;
+    long sum = 0;
+    const clock_t start = clock();
+
+    for (round = 0;  round < rounds;  round++)
+    {
+        for (i = 0;  i < SEQUENCE_LENGTH;  i++)
+            sum += lookup(sequence[i]);
+    }
+
+    *checksum = sum;
+    return (double) (clock() - start) / CLOCKS_PER_SEC * 1e9 /
+           ((double) rounds * SEQUENCE_LENGTH);
+}
+
+int main(int argc, char** argv)
+{
+    int ch, rounds = 200;
+    unsigned int keysym, mismatches = 0;
+    size_t i;
+    unsigned int* sequence;
+
+    while ((ch = getopt(argc, argv, "hr:")) != -1)
+    {
+        switch (ch)
+        {
+            case 'h':
+                usage();
+                exit(EXIT_SUCCESS);
+
+            case 'r':
+                rounds = atoi(optarg);
+                break;
+
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    for (keysym = 0;  keysym <= 0x1ffff;  keysym++)
+    {
+        if (_glfwKeySym2Unicode(keysym) != search_keysym(keysym))
+        {
+            fprintf(stderr, "Mismatch for keysym 0x%04x: %li instead of %li\n",
+                    keysym, _glfwKeySym2Unicode(keysym), search_keysym(keysym));
+            mismatches++;
+        }
+    }
+
+    if (mismatches)
+        exit(EXIT_FAILURE);
+
+    printf("Page table lookup matches binary search for all keysyms\n");
+
+    sequence = calloc(SEQUENCE_LENGTH, sizeof(unsigned int));
+
+    printf("%-10s %14s %14s %8s\n", "Workload", "Search (ns)", "Table (ns)", "Speedup");
+
+    for (i = 0;  i < sizeof(workloads) / sizeof(workloads[0]);  i++)
+    {
+        long search_sum, table_sum;
+        double search_time, table_time;
+
+        generate_sequence(sequence, workloads + i);
+
+        search_time = time_lookups(search_keysym, sequence, rounds, &search_sum);
+        table_time = time_lookups(_glfwKeySym2Unicode, sequence, rounds, &table_sum);
+
+        if (search_sum != table_sum)
+        {
+            fprintf(stderr, "Checksum mismatch for %s\n", workloads[i].name);
+            exit(EXIT_FAILURE);
+        }
+
+        printf("%-10s %14.2f %14.2f %7.2fx\n",
+               workloads[i].name, search_time, table_time,
+               table_time > 0.0 ? search_time / table_time : 0.0);
+    }
+
+    free(sequence);
+    exit(EXIT_SUCCESS);
+}
+
@@ -26,6 +26,10 @@
 // This test renders a high contrast, horizontally moving bar, allowing for
 // visual verification of whether the set swap interval is indeed obeyed
 //
+// It can also pace frames with the frame scheduler, with a simulated load to
+// make frames late, to check that adaptive swap interval only tears late
+// frames
+//
 //========================================================================
 
 #include <glad/glad.h>
@@ -37,6 +41,9 @@
 
 #include "linmath.h"
 
+#define SCHEDULER_IMPLEMENTATION
+#include "scheduler.h"
+
 static const struct
 {
     float x, y;
@@ -68,25 +75,63 @@ static int swap_tear;
 static int swap_interval;
 static double frame_rate;
 
+static Scheduler scheduler;
+// Fraction of the refresh rate to limit the frame rate to, or zero
+static int rate_divisor;
+// Milliseconds of busy work added to each frame
+static int load;
+static double late_rate;
+
 static void update_window_title(GLFWwindow* window)
 {
     char title[256];
+    char interval[64];
+    char limit[64] = "";
+
+    if (scheduler.adaptive)
+        snprintf(interval, sizeof(interval), "adaptive");
+    else
+    {
+        snprintf(interval, sizeof(interval), "interval %i%s",
+                 swap_interval,
+                 (swap_tear && swap_interval < 0) ? " (swap tear)" : "");
+    }
+
+    if (scheduler.period)
+    {
+        snprintf(limit, sizeof(limit), ", limit %0.1f Hz",
+                 (double) scheduler.frequency / scheduler.period);
+    }
 
-    snprintf(title, sizeof(title), "Tearing detector (interval %i%s, %0.1f Hz)",
-             swap_interval,
-             (swap_tear && swap_interval < 0) ? " (swap tear)" : "",
-             frame_rate);
+    snprintf(title, sizeof(title), "Tearing detector (%s%s, load %i ms, %0.1f Hz, %0.1f late/s)",
+             interval, limit, load, frame_rate, late_rate);
 
     glfwSetWindowTitle(window, title);
 }
 
 static void set_swap_interval(GLFWwindow* window, int interval)
 {
+    scheduler_set_adaptive(&scheduler, GLFW_FALSE);
     swap_interval = interval;
     glfwSwapInterval(swap_interval);
     update_window_title(window);
 }
 
+static void set_rate_divisor(GLFWwindow* window, int divisor)
+{
+    rate_divisor = divisor;
+
+    if (rate_divisor)
+    {
+        scheduler_set_frame_time(&scheduler, (double) rate_divisor *
+                                 scheduler.refresh_period / scheduler.frequency);
+    }
+    else
+        scheduler_set_frame_time(&scheduler, 0.0);
+
+    update_window_title(window);
+}
+
 static void error_callback(int error, const char* description)
 {
     fprintf(stderr, "Error: %s\n", description);
@@ -121,6 +166,34 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
             break;
         }
 
+        case GLFW_KEY_RIGHT:
+            load++;
+            update_window_title(window);
+            break;
+
+        case GLFW_KEY_LEFT:
+            if (load > 0)
+                load--;
+            update_window_title(window);
+            break;
+
+        case GLFW_KEY_A:
+        {
+            if (scheduler.adaptive)
+                set_swap_interval(window, swap_interval);
+            else
+            {
+                scheduler_set_adaptive(&scheduler, GLFW_TRUE);
+                update_window_title(window);
+            }
+            break;
+        }
+
+        case GLFW_KEY_L:
+            // Cycle between no limit, the refresh rate and half of it
+            set_rate_divisor(window, (rate_divisor + 1) % 3);
+            break;
+
         case GLFW_KEY_ESCAPE:
             glfwSetWindowShouldClose(window, 1);
             break;
@@ -176,6 +249,7 @@ int main(int argc, char** argv)
 
     glfwMakeContextCurrent(window);
     gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    scheduler_init(&scheduler, 0.0, GLFW_FALSE);
     set_swap_interval(window, 0);
 
     last_time = glfwGetTime();
@@ -228,7 +302,14 @@ int main(int argc, char** argv)
         glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*) mvp);
         glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
-        glfwSwapBuffers(window);
+        if (load)
+        {
+            const double end = glfwGetTime() + load / 1000.0;
+            while (glfwGetTime() < end)
+                ;
+        }
+
+        scheduler_swap_buffers(&scheduler, window);
         glfwPollEvents();
 
         frame_count++;
@@ -237,8 +318,10 @@ int main(int argc, char** argv)
         if (current_time - last_time > 1.0)
         {
             frame_rate = frame_count / (current_time - last_time);
+            late_rate = scheduler.late_count / (current_time - last_time);
             frame_count = 0;
             last_time = current_time;
+            scheduler_reset_stats(&scheduler);
             update_window_title(window);
         }
     }
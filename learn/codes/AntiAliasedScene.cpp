@@ -3,9 +3,15 @@
 
 /* Using the accumulation buffer for scene antialiasing. */
 
+/* Compared with a multisampled framebuffer object and with the same jitter
+pattern spread over several frames into a floating point framebuffer; see
+the menu, and press 'c' to print the frame time and error of each. */
+
+#include <GL/glew.h>
 #include <GL/glut.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 const GLdouble FRUSTDIM = 100.f;
 
@@ -124,74 +130,369 @@ computescale(GLfloat * sx, GLfloat * sy)
 	glGetIntegerv(GL_VIEWPORT, viewport);
 
 	*sx = 2 * FRUSTDIM / viewport[WID];
-	*sy = 2 * FRUSTDIM / viewport[WID];
+	*sy = 2 * FRUSTDIM / viewport[HT];
+}
+
+/* load the projection, moved by dx, dy pixels */
+void
+jitter(GLfloat dx, GLfloat dy)
+{
+	GLfloat invx, invy;
+
+	computescale(&invx, &invy);
+	dx *= invx;
+	dy *= invy;
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glFrustum(-FRUSTDIM + dx, FRUSTDIM + dx,
+		-FRUSTDIM + dy, FRUSTDIM + dy,
+		320., 640.);
+	glMatrixMode(GL_MODELVIEW);
 }
 
+/* jitter pattern of the accumulation path: a 5x5 grid, less than one
+pixel wide in each direction */
 enum {
-	NONE, AA
+	JITTER_MIN = -2, JITTER_MAX = 3, JITTER_COUNT = 25
+};
+const GLfloat JITTER_SCALE = .9f / 2;
+
+enum {
+	NONE, AA, MSAA, TEMPORAL
 };
 
 int rendermode = NONE;
 
+/*
+** Framebuffer object paths.
+**
+** MSAA renders the scene once into a multisampled framebuffer and resolves
+** it into the window with glBlitFramebuffer.
+**
+** TEMPORAL renders the scene once per displayed frame, jittered by the next
+** offset of the pattern the accumulation path uses, and blends it into a
+** floating point history buffer with weight 1/n, so that after 25 frames
+** the history holds the same average the accumulation buffer does in one.
+** The scene is static, so once the history is complete it is only copied
+** to the window; it starts over when the window changes size.
+*/
+int has_fbo, has_float;
+int fb_width, fb_height;	/* size the buffers below were made for */
+int msaa_samples;
+GLuint msaa_fbo, msaa_color, msaa_depth;
+GLuint scene_fbo, scene_tex, scene_depth;
+GLuint history_fbo, history_tex;
+int history_frames;
+
 void
-menu(int selection)
+delete_buffers(void)
 {
-	rendermode = selection;
-	glutPostRedisplay();
+	glDeleteFramebuffers(1, &msaa_fbo);
+	glDeleteRenderbuffers(1, &msaa_color);
+	glDeleteRenderbuffers(1, &msaa_depth);
+	glDeleteFramebuffers(1, &scene_fbo);
+	glDeleteTextures(1, &scene_tex);
+	glDeleteRenderbuffers(1, &scene_depth);
+	glDeleteFramebuffers(1, &history_fbo);
+	glDeleteTextures(1, &history_tex);
+	msaa_fbo = msaa_color = msaa_depth = 0;
+	scene_fbo = scene_tex = scene_depth = 0;
+	history_fbo = history_tex = 0;
+	fb_width = fb_height = 0;
 }
 
-/* Called when window needs to be redrawn */
+GLuint
+make_color_texture(GLenum format, int width, int height)
+{
+	GLuint tex;
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return tex;
+}
+
+GLuint
+make_renderbuffer(GLenum format, int samples, int width, int height)
+{
+	GLuint rb;
+
+	glGenRenderbuffers(1, &rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	return rb;
+}
+
+/* (re)create the buffers when the window size has changed */
 void
-redraw(void)
+make_buffers(void)
 {
-	int i, j;
-	int min, max;
-	int count;
-	GLfloat invx, invy;
-	GLfloat scale, dx, dy;
+	GLint viewport[4];
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (viewport[2] == fb_width && viewport[3] == fb_height)
+		return;
+
+	delete_buffers();
+	fb_width = viewport[2];
+	fb_height = viewport[3];
+	history_frames = 0;
+
+	glGenFramebuffers(1, &msaa_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, msaa_fbo);
+	msaa_color = make_renderbuffer(GL_RGBA8, msaa_samples, fb_width, fb_height);
+	msaa_depth = make_renderbuffer(GL_DEPTH_COMPONENT24, msaa_samples, fb_width, fb_height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+		GL_RENDERBUFFER, msaa_color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+		GL_RENDERBUFFER, msaa_depth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		printf("multisampled framebuffer is incomplete\n");
+
+	if (has_float) {
+		glGenFramebuffers(1, &scene_fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, scene_fbo);
+		scene_tex = make_color_texture(GL_RGBA8, fb_width, fb_height);
+		scene_depth = make_renderbuffer(GL_DEPTH_COMPONENT24, 0, fb_width, fb_height);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, scene_tex, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+			GL_RENDERBUFFER, scene_depth);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			printf("scene framebuffer is incomplete\n");
+
+		glGenFramebuffers(1, &history_fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, history_fbo);
+		history_tex = make_color_texture(GL_RGBA16F, fb_width, fb_height);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, history_tex, 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			printf("history framebuffer is incomplete\n");
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
 
-	switch (rendermode) {
+/* copy a framebuffer to the back buffer of the window */
+void
+resolve(GLuint fbo)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, fb_width, fb_height, 0, 0, fb_width, fb_height,
+		GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/* blend the scene texture into the history with the specified weight */
+void
+blend_history(GLfloat weight)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, history_fbo);
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_LIGHTING);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, scene_tex);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glEnable(GL_BLEND);
+	glBlendColor(0.f, 0.f, 0.f, weight);
+	glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glBegin(GL_QUADS);
+	glTexCoord2i(0, 0);
+	glVertex2i(-1, -1);
+	glTexCoord2i(1, 0);
+	glVertex2i(1, -1);
+	glTexCoord2i(1, 1);
+	glVertex2i(1, 1);
+	glTexCoord2i(0, 1);
+	glVertex2i(-1, 1);
+	glEnd();
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+
+	glPopAttrib();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/* render one jittered frame into the history, which then holds the average
+of all the frames so far */
+void
+accumulate(GLfloat dx, GLfloat dy)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, scene_fbo);
+	jitter(dx, dy);
+	render();
+	blend_history(1.f / (history_frames + 1));
+	history_frames++;
+}
+
+/* Draw one frame with the specified mode into the back buffer */
+void
+draw_frame(int mode)
+{
+	int i, j, k;
+
+	switch (mode) {
 	case NONE:
-		glMatrixMode(GL_PROJECTION);
-		glLoadIdentity();
-		glFrustum(-FRUSTDIM, FRUSTDIM, -FRUSTDIM, FRUSTDIM, 320., 640.);
-		glMatrixMode(GL_MODELVIEW);
+		jitter(0.f, 0.f);
 		render();
 		break;
 	case AA:
-		min = -2;
-		max = -min + 1;
-		count = -2 * min + 1;
-		count *= count;
-
-		/* uniform scaling, less than one pixel wide */
-		scale = -.9f / min;
-
-		computescale(&invx, &invy);
-
 		glClear(GL_ACCUM_BUFFER_BIT);
 
-		for (j = min; j < max; j++) {
-			for (i = min; i < max; i++) {
-				dx = invx * scale * i;
-				dy = invy * scale * j;
-				glMatrixMode(GL_PROJECTION);
-				glLoadIdentity();
-				glFrustum(-FRUSTDIM + dx,
-					FRUSTDIM + dy,
-					-FRUSTDIM + dx,
-					FRUSTDIM + dy,
-					320., 640.);
-				glMatrixMode(GL_MODELVIEW);
+		for (j = JITTER_MIN; j < JITTER_MAX; j++) {
+			for (i = JITTER_MIN; i < JITTER_MAX; i++) {
+				jitter(JITTER_SCALE * i, JITTER_SCALE * j);
 				render();
-				glAccum(GL_ACCUM, 1.f / count);
+				glAccum(GL_ACCUM, 1.f / JITTER_COUNT);
 			}
 		}
 		glAccum(GL_RETURN, 1.f);
 		break;
+	case MSAA:
+		make_buffers();
+		glBindFramebuffer(GL_FRAMEBUFFER, msaa_fbo);
+		jitter(0.f, 0.f);
+		render();
+		resolve(msaa_fbo);
+		break;
+	case TEMPORAL:
+		make_buffers();
+		if (history_frames < JITTER_COUNT) {
+			/* step through the grid by 7 so that the first few frames
+			are spread over it */
+			k = history_frames * 7 % JITTER_COUNT;
+			i = k % 5 + JITTER_MIN;
+			j = k / 5 + JITTER_MIN;
+			accumulate(JITTER_SCALE * i, JITTER_SCALE * j);
+		}
+		resolve(history_fbo);
+		break;
 	}
+}
 
+void
+menu(int selection)
+{
+	if ((selection == MSAA && !has_fbo) || (selection == TEMPORAL && !has_float)) {
+		printf("not supported by this OpenGL implementation\n");
+		return;
+	}
+	rendermode = selection;
+	history_frames = 0;
+	glutPostRedisplay();
+}
+
+/* Called when window needs to be redrawn */
+void
+redraw(void)
+{
+	draw_frame(rendermode);
 	glutSwapBuffers();
+
+	/* keep going until the history is complete */
+	if (rendermode == TEMPORAL && history_frames < JITTER_COUNT)
+		glutPostRedisplay();
+}
+
+void
+reshape(int w, int h)
+{
+	glViewport(0, 0, w, h);
+	history_frames = 0;
+}
+
+/*
+** Compare the frame time and quality of each mode.  The reference is the
+** scene averaged over 16x16 samples evenly spread over each pixel, made
+** with the history buffer; the error is the RMS difference from it, in
+** 8 bit steps.
+*/
+void
+compare(void)
+{
+	static const char *names[] = { "aliased", "accumulation", "multisample", "temporal" };
+	int mode, f, i, j, frames;
+	int size;
+	GLfloat *reference;
+	GLubyte *pixels;
+
+	if (!has_float) {
+		printf("comparison needs floating point framebuffers\n");
+		return;
+	}
+
+	make_buffers();
+	size = fb_width * fb_height * 3;
+	reference = (GLfloat *)malloc(size * sizeof(GLfloat));
+	pixels = (GLubyte *)malloc(size);
+
+	history_frames = 0;
+	for (j = 0; j < 16; j++)
+		for (i = 0; i < 16; i++)
+			accumulate((i + .5f) / 16 - .5f, (j + .5f) / 16 - .5f);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, history_fbo);
+	glReadPixels(0, 0, fb_width, fb_height, GL_RGB, GL_FLOAT, reference);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	printf("%-14s %12s %8s %10s\n", "mode", "ms/frame", "frames", "RMS error");
+	for (mode = NONE; mode <= TEMPORAL; mode++) {
+		double start, elapsed, error = 0.;
+		GLint accum_bits = 0;
+
+		glGetIntegerv(GL_ACCUM_RED_BITS, &accum_bits);
+		if ((mode == AA && !accum_bits) || (mode == MSAA && !has_fbo)) {
+			printf("%-14s %12s\n", names[mode], "unsupported");
+			continue;
+		}
+
+		/* temporal takes as many frames to complete as the accumulation
+		path renders in one */
+		frames = mode == TEMPORAL ? JITTER_COUNT : 10;
+		history_frames = 0;
+		draw_frame(mode);
+		if (mode == TEMPORAL)
+			history_frames = 0;
+
+		glFinish();
+		start = glutGet(GLUT_ELAPSED_TIME);
+		for (f = 0; f < frames; f++)
+			draw_frame(mode);
+		glFinish();
+		elapsed = glutGet(GLUT_ELAPSED_TIME) - start;
+
+		glReadPixels(0, 0, fb_width, fb_height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+		for (i = 0; i < size; i++) {
+			double d = pixels[i] - reference[i] * 255.;
+			error += d * d;
+		}
+
+		printf("%-14s %12.2f %8d %10.3f\n", names[mode],
+			elapsed / frames, mode == TEMPORAL ? JITTER_COUNT : 1,
+			sqrt(error / size));
+	}
+
+	free(reference);
+	free(pixels);
+	history_frames = 0;
+	glutPostRedisplay();
 }
 
 /* ARGSUSED1 */
@@ -200,6 +501,8 @@ key(unsigned char key, int x, int y)
 {
 	if (key == '\033')
 		exit(0);
+	if (key == 'c')
+		compare();
 }
 
 const int TEXDIM = 256;
@@ -221,11 +524,23 @@ main(int argc, char *argv[])
 	glutInitDisplayMode(GLUT_RGBA | GLUT_DEPTH | GLUT_ACCUM | GLUT_DOUBLE);
 	(void)glutCreateWindow("scene antialiasing");
 	glutDisplayFunc(redraw);
+	glutReshapeFunc(reshape);
 	glutKeyboardFunc(key);
 
+	glewInit();
+	has_fbo = GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object;
+	has_float = has_fbo && (GLEW_VERSION_3_0 || GLEW_ARB_texture_float);
+	if (has_fbo) {
+		glGetIntegerv(GL_MAX_SAMPLES, &msaa_samples);
+		if (msaa_samples > 8)
+			msaa_samples = 8;
+	}
+
 	glutCreateMenu(menu);
 	glutAddMenuEntry("Aliased View", NONE);
 	glutAddMenuEntry("AntiAliased", AA);
+	glutAddMenuEntry("Multisampled", MSAA);
+	glutAddMenuEntry("Temporal AntiAliased", TEMPORAL);
 	glutAttachMenu(GLUT_RIGHT_BUTTON);
 
 	/* draw a perspective scene */
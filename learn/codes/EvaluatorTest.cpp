@@ -12,6 +12,7 @@ I just added a bit more GLUT stuff to it. */
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <GL/glew.h>
 #include <GL/glut.h>
 
 #define VORDER 10
@@ -48,6 +49,9 @@ GLenum polygonFilled = GL_FALSE;
 GLenum lighting = GL_FALSE;
 GLenum mapPoint = GL_FALSE;
 GLenum mapType = EVAL;
+GLenum useEvaluators = GL_FALSE;
+GLenum useBuffers;
+int detail = 1;
 
 double point1[10 * 4] =
 {
@@ -120,6 +124,21 @@ float textureImage[4 * 2 * 4] =
 	1.0, 1.0, 1.0, 1.0,
 };
 
+/* Load the control points into the evaluator maps */
+static void
+LoadMaps(void)
+{
+	glMap1d(GL_MAP1_VERTEX_4, 0.0, 1.0, VDIM, VORDER, point1);
+	glMap1d(GL_MAP1_COLOR_4, 0.0, 1.0, CDIM, CORDER, cpoint1);
+
+	glMap2d(GL_MAP2_VERTEX_4, 0.0, 1.0, VMINOR_ORDER * VDIM, VMAJOR_ORDER, 0.0,
+		1.0, VDIM, VMINOR_ORDER, point2);
+	glMap2d(GL_MAP2_COLOR_4, 0.0, 1.0, CMINOR_ORDER * CDIM, CMAJOR_ORDER, 0.0,
+		1.0, CDIM, CMINOR_ORDER, cpoint2);
+	glMap2d(GL_MAP2_TEXTURE_COORD_2, 0.0, 1.0, TMINOR_ORDER * TDIM,
+		TMAJOR_ORDER, 0.0, 1.0, TDIM, TMINOR_ORDER, tpoint2);
+}
+
 static void
 Init(void)
 {
@@ -148,15 +167,8 @@ Init(void)
 
 	glEnable(GL_DEPTH_TEST);
 
-	glMap1d(GL_MAP1_VERTEX_4, 0.0, 1.0, VDIM, VORDER, point1);
-	glMap1d(GL_MAP1_COLOR_4, 0.0, 1.0, CDIM, CORDER, cpoint1);
-
-	glMap2d(GL_MAP2_VERTEX_4, 0.0, 1.0, VMINOR_ORDER * VDIM, VMAJOR_ORDER, 0.0,
-		1.0, VDIM, VMINOR_ORDER, point2);
-	glMap2d(GL_MAP2_COLOR_4, 0.0, 1.0, CMINOR_ORDER * CDIM, CMAJOR_ORDER, 0.0,
-		1.0, CDIM, CMINOR_ORDER, cpoint2);
-	glMap2d(GL_MAP2_TEXTURE_COORD_2, 0.0, 1.0, TMINOR_ORDER * TDIM,
-		TMAJOR_ORDER, 0.0, 1.0, TDIM, TMINOR_ORDER, tpoint2);
+	LoadMaps();
+	useBuffers = GLEW_VERSION_1_5;
 
 	glLightfv(GL_LIGHT0, GL_AMBIENT, ambient);
 	glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
@@ -240,6 +252,278 @@ DrawMapEval2(float du, float dv)
 	}
 }
 
+/* Baked meshes.  The curve and the patch are evaluated on the CPU into
+interleaved position, color, texture coordinate and normal vertices, the
+way the evaluators would, and kept in vertex buffers until the control
+points or the resolution change, instead of being evaluated again every
+frame. */
+
+#define MAX_ORDER 10
+
+#define STRIDE 13             /* x y z w, r g b a, s t, nx ny nz */
+#define COLOR_OFFSET 4
+#define TEXTURE_OFFSET 8
+#define NORMAL_OFFSET 10
+
+typedef struct {
+	int nu, nv;               /* grid size, nv is 0 for the curve */
+	GLenum dirty;
+	float *vertices;
+	GLuint *indices;
+	int vertexCount;
+	int quadIndexCount;       /* quads first, then lines */
+	int lineIndexCount;
+	GLuint vertexBuffer, indexBuffer;
+} Mesh;
+
+Mesh curve = { 0, 0, GL_TRUE }, patch = { 0, 0, GL_TRUE };
+
+/* Bernstein basis of the specified order at u, with its derivative */
+static void
+Bernstein(int order, double u, double *b, double *db)
+{
+	int i, k;
+
+	b[0] = 1.0;
+	db[0] = 0.0;
+	for (k = 1; k < order; k++) {
+		if (k == order - 1) {
+			db[0] = -k * b[0];
+			for (i = 1; i < k; i++) {
+				db[i] = k * (b[i - 1] - b[i]);
+			}
+			db[k] = k * b[k - 1];
+		}
+		b[k] = u * b[k - 1];
+		for (i = k - 1; i > 0; i--) {
+			b[i] = (1.0 - u) * b[i] + u * b[i - 1];
+		}
+		b[0] = (1.0 - u) * b[0];
+	}
+}
+
+static void
+EvalCurve(double u, float *out)
+{
+	double b[MAX_ORDER], db[MAX_ORDER];
+	GLint i, c;
+
+	memset(out, 0, STRIDE * sizeof(float));
+	Bernstein(VORDER, u, b, db);
+	for (i = 0; i < VORDER; i++) {
+		for (c = 0; c < VDIM; c++) {
+			out[c] += (float)(b[i] * point1[i * VDIM + c]);
+		}
+	}
+	Bernstein(CORDER, u, b, db);
+	for (i = 0; i < CORDER; i++) {
+		for (c = 0; c < CDIM; c++) {
+			out[COLOR_OFFSET + c] += (float)(b[i] * cpoint1[i * CDIM + c]);
+		}
+	}
+	out[NORMAL_OFFSET + 2] = 1.0;
+}
+
+/* Sum the control points of a map weighted by the basis in each direction */
+static void
+SumPatch(const double *points, int dim, int uorder, int vorder,
+	const double *bu, const double *bv, double *out)
+{
+	GLint i, j, c;
+
+	for (c = 0; c < dim; c++) {
+		out[c] = 0.0;
+	}
+	for (i = 0; i < uorder; i++) {
+		for (j = 0; j < vorder; j++) {
+			for (c = 0; c < dim; c++) {
+				out[c] += bu[i] * bv[j] * points[(i * vorder + j) * dim + c];
+			}
+		}
+	}
+}
+
+static void
+EvalPatch(double u, double v, float *out)
+{
+	double bu[MAX_ORDER], dbu[MAX_ORDER], bv[MAX_ORDER], dbv[MAX_ORDER];
+	double p[VDIM], pu[VDIM], pv[VDIM], du[3], dv[3], n[3], w, len;
+	double color[CDIM], texture[TDIM];
+	GLint c;
+
+	Bernstein(VMAJOR_ORDER, u, bu, dbu);
+	Bernstein(VMINOR_ORDER, v, bv, dbv);
+	SumPatch(point2, VDIM, VMAJOR_ORDER, VMINOR_ORDER, bu, bv, p);
+	SumPatch(point2, VDIM, VMAJOR_ORDER, VMINOR_ORDER, dbu, bv, pu);
+	SumPatch(point2, VDIM, VMAJOR_ORDER, VMINOR_ORDER, bu, dbv, pv);
+
+	/* the automatic normal is the cross product of the partial
+	derivatives of the projected position, normalized; it is left as is
+	where it vanishes, as at a collapsed edge */
+	w = p[3];
+	for (c = 0; c < 3; c++) {
+		du[c] = (pu[c] * w - p[c] * pu[3]) / (w * w);
+		dv[c] = (pv[c] * w - p[c] * pv[3]) / (w * w);
+	}
+
+	Bernstein(CMAJOR_ORDER, u, bu, dbu);
+	Bernstein(CMINOR_ORDER, v, bv, dbv);
+	SumPatch(cpoint2, CDIM, CMAJOR_ORDER, CMINOR_ORDER, bu, bv, color);
+
+	Bernstein(TMAJOR_ORDER, u, bu, dbu);
+	Bernstein(TMINOR_ORDER, v, bv, dbv);
+	SumPatch(tpoint2, TDIM, TMAJOR_ORDER, TMINOR_ORDER, bu, bv, texture);
+
+	for (c = 0; c < VDIM; c++) {
+		out[c] = (float)p[c];
+	}
+	for (c = 0; c < CDIM; c++) {
+		out[COLOR_OFFSET + c] = (float)color[c];
+	}
+	for (c = 0; c < TDIM; c++) {
+		out[TEXTURE_OFFSET + c] = (float)texture[c];
+	}
+	n[0] = du[1] * dv[2] - du[2] * dv[1];
+	n[1] = du[2] * dv[0] - du[0] * dv[2];
+	n[2] = du[0] * dv[1] - du[1] * dv[0];
+	len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	if (len == 0.)
+		len = 1.;
+	for (c = 0; c < 3; c++) {
+		out[NORMAL_OFFSET + c] = (float)(n[c] / len);
+	}
+}
+
+/* Evaluate a curve with nu segments or a patch with nu by nv quads, if it
+is not already */
+static void
+Bake(Mesh *mesh, int nu, int nv)
+{
+	GLint i, j, k, rows;
+	GLuint *q, *l;
+
+	if (!mesh->dirty && mesh->nu == nu && mesh->nv == nv) {
+		return;
+	}
+	mesh->nu = nu;
+	mesh->nv = nv;
+	mesh->dirty = GL_FALSE;
+
+	rows = nv + 1;
+	mesh->vertexCount = (nu + 1) * rows;
+	mesh->vertices = (float *)realloc(mesh->vertices,
+		mesh->vertexCount * STRIDE * sizeof(float));
+	for (j = 0; j < rows; j++) {
+		for (i = 0; i <= nu; i++) {
+			k = j * (nu + 1) + i;
+			if (nv) {
+				EvalPatch((double)i / nu, (double)j / nv, &mesh->vertices[k * STRIDE]);
+			}
+			else {
+				EvalCurve((double)i / nu, &mesh->vertices[k * STRIDE]);
+			}
+		}
+	}
+
+	/* quads wound as glEvalMesh2 winds its quad strips, and the grid lines
+	in both directions */
+	mesh->quadIndexCount = nu * nv * 4;
+	mesh->lineIndexCount = (nu * rows + (nu + 1) * nv) * 2;
+	mesh->indices = (GLuint *)realloc(mesh->indices,
+		(mesh->quadIndexCount + mesh->lineIndexCount + 1) * sizeof(GLuint));
+	q = mesh->indices;
+	l = mesh->indices + mesh->quadIndexCount;
+	for (j = 0; j < rows; j++) {
+		for (i = 0; i <= nu; i++) {
+			k = j * (nu + 1) + i;
+			if (i < nu && j < nv) {
+				*q++ = k;
+				*q++ = k + nu + 1;
+				*q++ = k + nu + 2;
+				*q++ = k + 1;
+			}
+			if (i < nu) {
+				*l++ = k;
+				*l++ = k + 1;
+			}
+			if (j < nv) {
+				*l++ = k;
+				*l++ = k + nu + 1;
+			}
+		}
+	}
+
+	if (useBuffers) {
+		if (!mesh->vertexBuffer) {
+			glGenBuffers(1, &mesh->vertexBuffer);
+			glGenBuffers(1, &mesh->indexBuffer);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, mesh->vertexCount * STRIDE * sizeof(float),
+			mesh->vertices, GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+			(mesh->quadIndexCount + mesh->lineIndexCount) * sizeof(GLuint),
+			mesh->indices, GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+}
+
+/* Draw a baked mesh as points, lines or filled quads, with the colors,
+texture coordinates and normals the evaluator path would generate */
+static void
+DrawMesh(Mesh *mesh, GLenum mode)
+{
+	const char *vertices = (const char *)mesh->vertices;
+	const char *indices = (const char *)mesh->indices;
+	GLsizei stride = STRIDE * sizeof(float);
+
+	if (useBuffers) {
+		vertices = NULL;
+		indices = NULL;
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+	}
+
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(4, GL_FLOAT, stride, vertices);
+	if (colorType) {
+		glEnableClientState(GL_COLOR_ARRAY);
+		glColorPointer(4, GL_FLOAT, stride, vertices + COLOR_OFFSET * sizeof(float));
+	}
+	if (mesh->nv && textureType) {
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, stride, vertices + TEXTURE_OFFSET * sizeof(float));
+	}
+	glNormal3f(0.0, 0.0, 1.0);
+	if (mesh->nv) {
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT, stride, vertices + NORMAL_OFFSET * sizeof(float));
+	}
+
+	if (mode == GL_POINT) {
+		glDrawArrays(GL_POINTS, 0, mesh->vertexCount);
+	}
+	else if (!mesh->nv) {
+		glDrawArrays(GL_LINE_STRIP, 0, mesh->vertexCount);
+	}
+	else if (mode == GL_FILL) {
+		glDrawElements(GL_QUADS, mesh->quadIndexCount, GL_UNSIGNED_INT, indices);
+	}
+	else {
+		glDrawElements(GL_LINES, mesh->lineIndexCount, GL_UNSIGNED_INT,
+			indices + mesh->quadIndexCount * sizeof(GLuint));
+	}
+
+	glPopClientAttrib();
+	if (useBuffers) {
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+}
+
 static void
 RenderEval(void)
 {
@@ -278,13 +562,28 @@ RenderEval(void)
 			glDisable(GL_MAP2_VERTEX_4);
 			glEnable(GL_MAP1_VERTEX_4);
 			DrawPoints1();
-			DrawMapEval1(0.1 / VORDER);
+			if (useEvaluators) {
+				DrawMapEval1(0.1 / VORDER / detail);
+			}
+			else {
+				glColor3f(1.0, 0.0, 0.0);
+				Bake(&curve, 10 * VORDER * detail, 0);
+				DrawMesh(&curve, GL_LINE);
+			}
 			break;
 		case TWO_D:
 			glDisable(GL_MAP1_VERTEX_4);
 			glEnable(GL_MAP2_VERTEX_4);
 			DrawPoints2();
-			DrawMapEval2(0.1 / VMAJOR_ORDER, 0.1 / VMINOR_ORDER);
+			if (useEvaluators) {
+				DrawMapEval2(0.1 / VMAJOR_ORDER / detail, 0.1 / VMINOR_ORDER / detail);
+			}
+			else {
+				/* quads, outlined by the polygon mode when not filled */
+				glColor3f(1.0, 0.0, 0.0);
+				Bake(&patch, 10 * VMAJOR_ORDER * detail, 10 * VMINOR_ORDER * detail);
+				DrawMesh(&patch, GL_FILL);
+			}
 			break;
 		}
 		break;
@@ -295,13 +594,16 @@ RenderEval(void)
 			glDisable(GL_MAP2_VERTEX_4);
 			glEnable(GL_MAP1_VERTEX_4);
 			glColor3f(0.0, 0.0, 1.0);
-			glMapGrid1d(40, 0.0, 1.0);
 			if (mapPoint) {
 				glPointSize(2);
-				glEvalMesh1(GL_POINT, 0, 40);
+			}
+			if (useEvaluators) {
+				glMapGrid1d(40 * detail, 0.0, 1.0);
+				glEvalMesh1(mapPoint ? GL_POINT : GL_LINE, 0, 40 * detail);
 			}
 			else {
-				glEvalMesh1(GL_LINE, 0, 40);
+				Bake(&curve, 40 * detail, 0);
+				DrawMesh(&curve, mapPoint ? GL_POINT : GL_LINE);
 			}
 			break;
 		case TWO_D:
@@ -309,16 +611,17 @@ RenderEval(void)
 			glDisable(GL_MAP1_VERTEX_4);
 			glEnable(GL_MAP2_VERTEX_4);
 			glColor3f(0.0, 0.0, 1.0);
-			glMapGrid2d(20, 0.0, 1.0, 20, 0.0, 1.0);
 			if (mapPoint) {
 				glPointSize(2);
-				glEvalMesh2(GL_POINT, 0, 20, 0, 20);
 			}
-			else if (polygonFilled) {
-				glEvalMesh2(GL_FILL, 0, 20, 0, 20);
+			if (useEvaluators) {
+				glMapGrid2d(20 * detail, 0.0, 1.0, 20 * detail, 0.0, 1.0);
+				glEvalMesh2(mapPoint ? GL_POINT : polygonFilled ? GL_FILL : GL_LINE,
+					0, 20 * detail, 0, 20 * detail);
 			}
 			else {
-				glEvalMesh2(GL_LINE, 0, 20, 0, 20);
+				Bake(&patch, 20 * detail, 20 * detail);
+				DrawMesh(&patch, mapPoint ? GL_POINT : polygonFilled ? GL_FILL : GL_LINE);
 			}
 			break;
 		}
@@ -338,6 +641,29 @@ Reshape(int width, int height)
 	glMatrixMode(GL_MODELVIEW);
 }
 
+/* Scale the control points of the current curve or patch vertically */
+static void
+Stretch(double scale)
+{
+	GLint i;
+
+	if (arrayType == ONE_D) {
+		for (i = 0; i < VORDER; i++) {
+			point1[i * VDIM + 1] *= scale;
+		}
+		curve.dirty = GL_TRUE;
+	}
+	else {
+		for (i = 0; i < VMAJOR_ORDER * VMINOR_ORDER; i++) {
+			point2[i * VDIM + 1] *= scale;
+		}
+		patch.dirty = GL_TRUE;
+	}
+	LoadMaps();
+}
+
+static void Benchmark(void);
+
 /* ARGSUSED1 */
 static void
 Key(unsigned char key, int x, int y)
@@ -396,6 +722,34 @@ Key(unsigned char key, int x, int y)
 		}
 		glutPostRedisplay();
 		break;
+	case 'e':
+		useEvaluators = !useEvaluators;
+		printf("%s\n", useEvaluators ? "evaluators" : "baked mesh");
+		glutPostRedisplay();
+		break;
+	case '+':
+		if (detail < 16) {
+			detail *= 2;
+		}
+		glutPostRedisplay();
+		break;
+	case '-':
+		if (detail > 1) {
+			detail /= 2;
+		}
+		glutPostRedisplay();
+		break;
+	case 'a':
+		Stretch(1.25);
+		glutPostRedisplay();
+		break;
+	case 'z':
+		Stretch(0.8);
+		glutPostRedisplay();
+		break;
+	case 'b':
+		Benchmark();
+		break;
 	case 27:             /* Escape key. */
 		exit(0);
 	}
@@ -457,6 +811,32 @@ Draw(void)
 	}
 }
 
+/* Compare the frame time of the baked meshes with the evaluators for the
+current view */
+static void
+Benchmark(void)
+{
+	static const char *names[] = { "baked mesh", "evaluators" };
+	GLenum saved = useEvaluators;
+	int path, frame, start, elapsed;
+
+	for (path = 0; path < 2; path++) {
+		useEvaluators = path ? GL_TRUE : GL_FALSE;
+		Draw();
+		glFinish();
+		start = glutGet(GLUT_ELAPSED_TIME);
+		for (frame = 0; frame < 100; frame++) {
+			Draw();
+		}
+		glFinish();
+		elapsed = glutGet(GLUT_ELAPSED_TIME) - start;
+		printf("%-12s detail %2d: %8.3f ms per frame\n", names[path], detail,
+			elapsed / 100.0);
+	}
+	useEvaluators = saved;
+	glutPostRedisplay();
+}
+
 static void
 Args(int argc, char **argv)
 {
@@ -487,6 +867,7 @@ main(int argc, char **argv)
 	glutInitDisplayMode(type);
 	glutInitWindowSize(300, 300);
 	glutCreateWindow("Evaluator Test");
+	glewInit();
 
 	glutCreateMenu(Menu);
 	glutAddMenuEntry("One dimensional", '1');
@@ -498,6 +879,12 @@ main(int argc, char **argv)
 	glutAddMenuEntry("Toggle color", '7');
 	glutAddMenuEntry("Toggle texture", '8');
 	glutAddMenuEntry("Toggle lighting", '9');
+	glutAddMenuEntry("Toggle evaluators", 'e');
+	glutAddMenuEntry("More detail", '+');
+	glutAddMenuEntry("Less detail", '-');
+	glutAddMenuEntry("Stretch", 'a');
+	glutAddMenuEntry("Squash", 'z');
+	glutAddMenuEntry("Benchmark", 'b');
 	glutAddMenuEntry("Quit", 27);
 	glutAttachMenu(GLUT_RIGHT_BUTTON);
 	glutAttachMenu(GLUT_LEFT_BUTTON);
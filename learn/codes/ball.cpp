@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <GL/glew.h>
 #include <GL/glut.h>
 
 /* Some <math.h> files do not define M_PI... */
@@ -45,6 +46,8 @@ int drawObj = 0, maxObj = 2;
 GLfloat lightRotX, lightRotY;
 GLfloat objectRotX, objectRotY;
 int curx, cury, width, height;
+int useFramebuffer = GL_TRUE;
+int specSize = 128;
 
 void
 drawSphere(int numMajor, int numMinor, float radius)
@@ -227,19 +230,211 @@ setLight(void)
 	glLightf(GL_LIGHT0, GL_QUADRATIC_ATTENUATION, light0Atten2);
 }
 
+/*
+** Render targets for the specular highlight texture.
+**
+** With framebuffer objects the highlight is drawn straight into the
+** texture.  Without them it is drawn into the back buffer, read back into
+** system memory and uploaded again, which is what this demo always used to
+** do; a target can also be asked to take that readback path on purpose,
+** through a framebuffer of its own, to compare the two.
+*/
+typedef struct {
+	int width, height;
+	int readback;		/* copy through system memory */
+	GLuint texture;
+	GLuint framebuffer;	/* zero draws into the back buffer */
+	GLuint colorbuffer;	/* readback through a framebuffer only */
+	GLuint depthbuffer;
+	GLubyte *pixels;	/* readback only */
+} RenderTarget;
+
+int hasFramebuffers = GL_FALSE;
+
+void
+deleteRenderTarget(RenderTarget *rt)
+{
+	if (rt->framebuffer) {
+		glDeleteFramebuffers(1, &rt->framebuffer);
+		glDeleteRenderbuffers(1, &rt->colorbuffer);
+		glDeleteRenderbuffers(1, &rt->depthbuffer);
+	}
+	glDeleteTextures(1, &rt->texture);
+	free(rt->pixels);
+	memset(rt, 0, sizeof(RenderTarget));
+}
+
+int
+initRenderTarget(RenderTarget *rt, int w, int h, int readback)
+{
+	GLint maxSize;
+
+	memset(rt, 0, sizeof(RenderTarget));
+	rt->width = w;
+	rt->height = h;
+	rt->readback = readback || !hasFramebuffers;
+
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	if (w > maxSize || h > maxSize) {
+		return GL_FALSE;
+	}
+	/* The back buffer is only as large as the window */
+	if (!hasFramebuffers && (w > width || h > height)) {
+		return GL_FALSE;
+	}
+
+	glGenTextures(1, &rt->texture);
+	glBindTexture(GL_TEXTURE_2D, rt->texture);
+	glTexParameteri(GL_TEXTURE_2D,
+		GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D,
+		GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (rt->readback) {
+		rt->pixels = (GLubyte *)malloc(w * h * 4 * sizeof(GLubyte));
+		if (rt->pixels == NULL) {
+			deleteRenderTarget(rt);
+			return GL_FALSE;
+		}
+	}
+
+	if (hasFramebuffers) {
+		glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+		if (w > maxSize || h > maxSize) {
+			deleteRenderTarget(rt);
+			return GL_FALSE;
+		}
+
+		glGenFramebuffers(1, &rt->framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, rt->framebuffer);
+
+		if (rt->readback) {
+			glGenRenderbuffers(1, &rt->colorbuffer);
+			glBindRenderbuffer(GL_RENDERBUFFER, rt->colorbuffer);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				GL_RENDERBUFFER, rt->colorbuffer);
+		}
+		else {
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				GL_TEXTURE_2D, rt->texture, 0);
+		}
+
+		glGenRenderbuffers(1, &rt->depthbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, rt->depthbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+			GL_RENDERBUFFER, rt->depthbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			deleteRenderTarget(rt);
+			return GL_FALSE;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+	return GL_TRUE;
+}
+
+void
+beginRenderTarget(RenderTarget *rt)
+{
+	if (rt->framebuffer) {
+		glBindFramebuffer(GL_FRAMEBUFFER, rt->framebuffer);
+	}
+	glViewport(0, 0, rt->width, rt->height);
+}
+
+void
+endRenderTarget(RenderTarget *rt)
+{
+	if (rt->readback) {
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, rt->width, rt->height,
+			GL_RGBA, GL_UNSIGNED_BYTE, rt->pixels);
+	}
+	if (rt->framebuffer) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, rt->texture);
+	if (rt->readback) {
+		if (hasFramebuffers) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rt->width, rt->height,
+				GL_RGBA, GL_UNSIGNED_BYTE, rt->pixels);
+		}
+		else {
+			gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA8, rt->width, rt->height,
+				GL_RGBA, GL_UNSIGNED_BYTE, rt->pixels);
+		}
+	}
+	if (hasFramebuffers) {
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 #define MAT_ALL				0
 #define MAT_NO_SPECULAR			1
 #define MAT_SPECULAR_ONLY		2
 #define MAT_SPECULAR_TEXTURE_ONLY	3
 #define MAT_GEN_SPECULAR_TEXTURE	4
 
+RenderTarget specTarget;
+
+void setMaterial(int mode);
+
+/* Draws the highlight of a sphere lit by the light source into the target */
 void
-setMaterial(int mode)
+renderSpecularTexture(RenderTarget *rt)
 {
-	static GLubyte *texPixels;
-	int texWidth = 128;
-	int texHeight = 128;
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+
+	beginRenderTarget(rt);
 
+	setMaterial(MAT_SPECULAR_ONLY);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(-1, 1, -1, 1, 1, 3);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glTranslatef(0, 0, -2);
+
+	glPushMatrix();
+	glRotatef(lightRotY, 0, 1, 0);
+	glRotatef(lightRotX, 1, 0, 0);
+	setLight();
+	glPopMatrix();
+
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_LIGHTING);
+
+	glClearColor(.25, .25, .25, .25);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	drawSphere(128, 128, 1.0);
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+
+	endRenderTarget(rt);
+
+	glPopAttrib();
+}
+
+void
+setMaterial(int mode)
+{
 	GLfloat matZero[4] =
 	{ 0.00, 0.00, 0.00, 1.00 };
 	GLfloat matOne[4] =
@@ -275,68 +470,20 @@ setMaterial(int mode)
 	}
 
 	if (mode == MAT_SPECULAR_TEXTURE_ONLY) {
-		if (texPixels == NULL) {
+		if (specTarget.texture == 0) {
 			return;
 		}
 		glMaterialfv(GL_FRONT, GL_SPECULAR, matOne);
 		glMaterialf(GL_FRONT, GL_SHININESS, 0);
 
-		glTexParameteri(GL_TEXTURE_2D,
-			GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D,
-			GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-		gluBuild2DMipmaps(GL_TEXTURE_2D, 4, texWidth, texHeight,
-			GL_RGBA, GL_UNSIGNED_BYTE, texPixels);
+		glBindTexture(GL_TEXTURE_2D, specTarget.texture);
 	}
 	if (mode == MAT_GEN_SPECULAR_TEXTURE) {
-		if (texPixels == NULL) {
-			texPixels = (GLubyte *)
-				malloc(texWidth * texHeight * 4 * sizeof(GLubyte));
-			if (texPixels == NULL) {
-				return;
-			}
+		if (specTarget.texture == 0 &&
+		    !initRenderTarget(&specTarget, specSize, specSize, !useFramebuffer)) {
+			return;
 		}
-		glPushAttrib(GL_ALL_ATTRIB_BITS);
-
-		glClearColor(0.0, 0.0, 0.0, 1.0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		setMaterial(MAT_SPECULAR_ONLY);
-
-		glMatrixMode(GL_PROJECTION);
-		glPushMatrix();
-		glLoadIdentity();
-		glOrtho(-1, 1, -1, 1, 1, 3);
-		glMatrixMode(GL_MODELVIEW);
-		glPushMatrix();
-		glLoadIdentity();
-		glTranslatef(0, 0, -2);
-
-		glPushMatrix();
-		glRotatef(lightRotY, 0, 1, 0);
-		glRotatef(lightRotX, 1, 0, 0);
-		setLight();
-		glPopMatrix();
-
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_LIGHTING);
-
-		glViewport(0, 0, 128, 128);
-		glClearColor(.25, .25, .25, .25);
-		glClear(GL_COLOR_BUFFER_BIT);
-		drawSphere(128, 128, 1.0);
-
-		glMatrixMode(GL_PROJECTION);
-		glPopMatrix();
-		glMatrixMode(GL_MODELVIEW);
-		glPopMatrix();
-
-		glReadPixels(0, 0, texWidth, texHeight,
-			GL_RGBA, GL_UNSIGNED_BYTE, texPixels);
-
-		glPopAttrib();
+		renderSpecularTexture(&specTarget);
 	}
 }
 
@@ -482,6 +629,7 @@ redraw(void)
 			}
 		}
 		glPopMatrix();
+		glBindTexture(GL_TEXTURE_2D, 0);
 	}
 	glDisable(GL_DEPTH_TEST);
 	glDisable(GL_LIGHTING);
@@ -500,6 +648,53 @@ checkErrors(void)
 	}
 }
 
+/*
+** Compares how fast the highlight texture can be regenerated by drawing
+** into it directly and by reading it back through system memory.
+*/
+void
+benchmark(void)
+{
+	int size, readback;
+
+	printf("%-11s %21s %21s\n", "size", "framebuffer", "readback");
+	for (size = 128; size <= 2048; size *= 2) {
+		printf("%4d x %-4d ", size, size);
+		for (readback = 0; readback <= 1; ++readback) {
+			RenderTarget rt;
+			int count = 0, start, elapsed;
+
+			if (!initRenderTarget(&rt, size, size, readback)) {
+				printf(" %21s", "unsupported");
+				continue;
+			}
+			if (rt.readback != readback) {
+				deleteRenderTarget(&rt);
+				printf(" %21s", "unsupported");
+				continue;
+			}
+
+			renderSpecularTexture(&rt);
+			glFinish();
+			start = glutGet(GLUT_ELAPSED_TIME);
+			do {
+				renderSpecularTexture(&rt);
+				++count;
+				elapsed = glutGet(GLUT_ELAPSED_TIME) - start;
+			} while (elapsed < 500);
+			glFinish();
+			elapsed = glutGet(GLUT_ELAPSED_TIME) - start;
+
+			printf(" %8.1f/s %7.2f ms",
+				count * 1000.0 / elapsed, (double)elapsed / count);
+			fflush(stdout);
+			deleteRenderTarget(&rt);
+		}
+		printf("\n");
+	}
+	checkErrors();
+}
+
 void
 usage(char *name)
 {
@@ -514,12 +709,15 @@ usage(char *name)
 void
 help(void)
 {
+	printf("'b'      - benchmark highlight texture updates\n");
+	printf("'f'      - toggle framebuffer/readback highlight texture\n");
 	printf("'h'      - help\n");
 	printf("'l'      - toggle lighting\n");
 	printf("'o'      - switch objects\n");
 	printf("'r'      - toggle resolution\n");
 	printf("'s'      - toggle two pass lighting\n");
 	printf("'t'      - toggle texturing\n");
+	printf("'+'/'-'  - change highlight texture size\n");
 	printf("left mouse     - move object\n");
 	printf("middle mouse   - move light\n");
 }
@@ -630,6 +828,28 @@ key(unsigned char key, int x, int y)
 	case 'r':
 		useHighRes = !useHighRes;
 		break;
+	case 'f':
+		useFramebuffer = !useFramebuffer;
+		deleteRenderTarget(&specTarget);
+		needsLightUpdate = GL_TRUE;
+		printf("highlight texture: %s\n",
+			useFramebuffer && hasFramebuffers ? "framebuffer" : "readback");
+		break;
+	case '+':
+	case '-':
+		if (key == '+' && specSize < 2048) {
+			specSize *= 2;
+		}
+		if (key == '-' && specSize > 32) {
+			specSize /= 2;
+		}
+		deleteRenderTarget(&specTarget);
+		needsLightUpdate = GL_TRUE;
+		printf("highlight texture: %d x %d\n", specSize, specSize);
+		break;
+	case 'b':
+		benchmark();
+		break;
 	case 'o':
 		++drawObj;
 		if (drawObj > maxObj)
@@ -662,6 +882,8 @@ main(int argc, char **argv)
 		exit(1);
 	}
 	win = glutCreateWindow("envphong");
+	glewInit();
+	hasFramebuffers = GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object;
 	glutDisplayFunc(display);
 	glutKeyboardFunc(key);
 	glutReshapeFunc(reshape);
@@ -672,6 +894,8 @@ main(int argc, char **argv)
 	glutAddMenuEntry("Toggle checker texture", 't');
 	glutAddMenuEntry("Toggle two-pass textured specular", 's');
 	glutAddMenuEntry("Toggle object resolution", 'r');
+	glutAddMenuEntry("Toggle framebuffer highlight texture", 'f');
+	glutAddMenuEntry("Benchmark highlight texture", 'b');
 	glutAddMenuEntry("Switch object", 'o');
 	glutAddMenuEntry("Print help", 'h');
 	glutAttachMenu(GLUT_RIGHT_BUTTON);
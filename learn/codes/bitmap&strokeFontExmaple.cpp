@@ -8,25 +8,22 @@ implied. This program is -not- in the public domain. */
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <GL/glew.h>
 #include <GL/glut.h>
+#define TEXT_ATLAS_IMPLEMENTATION
+#include "textAtlas.h"
 
 void
 bitmap_output(int x, int y, char *string, void *font)
 {
-	int len, i;
-
-	glRasterPos2f(x, y);
-	len = (int)strlen(string);
-	for (i = 0; i < len; i++) {
-		glutBitmapCharacter(font, string[i]);
-	}
+	text_draw(text_bitmap_font(font), x, y, string);
 }
 
 void
 stroke_output(GLfloat x, GLfloat y, char *format, ...)
 {
 	va_list args;
-	char buffer[200], *p;
+	char buffer[200];
 
 	va_start(args, format);
 	vsprintf_s(buffer, format, args);
@@ -34,8 +31,8 @@ stroke_output(GLfloat x, GLfloat y, char *format, ...)
 	glPushMatrix();
 	glTranslatef(x, y, 0);
 	glScalef(0.005, 0.005, 0.005);
-	for (p = buffer; *p; p++)
-		glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
+	/* the text is about 50 pixels high on the screen */
+	text_draw(text_stroke_font(GLUT_STROKE_ROMAN, 48, 6.0), 0, 0, buffer);
 	glPopMatrix();
 }
 
@@ -92,6 +89,7 @@ main(int argc, char **argv)
 	glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB);
 	glutInitWindowSize(465, 250);
 	glutCreateWindow("GLUT bitmap & stroke font example");
+	glewInit();
 	glClearColor(1.0, 1.0, 1.0, 1.0);
 	glColor3f(0, 0, 0);
 	glLineWidth(3.0);
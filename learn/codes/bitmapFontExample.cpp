@@ -6,7 +6,10 @@ and is provided without guarantee or warrantee expressed or
 implied. This program is -not- in the public domain. */
 
 #include <string.h>
+#include <GL/glew.h>
 #include <GL/glut.h>
+#define TEXT_ATLAS_IMPLEMENTATION
+#include "textAtlas.h"
 
 void *font = GLUT_BITMAP_TIMES_ROMAN_24;
 void *fonts[] =
@@ -64,13 +67,7 @@ tick(void)
 void
 output(int x, int y, char *string)
 {
-	int len, i;
-
-	glRasterPos2f(x, y);
-	len = (int)strlen(string);
-	for (i = 0; i < len; i++) {
-		glutBitmapCharacter(font, string[i]);
-	}
+	text_draw(text_bitmap_font(font), x, y, string);
 }
 
 void
@@ -107,6 +104,7 @@ main(int argc, char **argv)
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
 	glutInitWindowSize(500, 150);
 	glutCreateWindow("GLUT bitmap font example");
+	glewInit();
 	glClearColor(0.0, 0.0, 0.0, 1.0);
 	glutDisplayFunc(display);
 	glutReshapeFunc(reshape);
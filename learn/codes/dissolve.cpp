@@ -5,8 +5,10 @@
 
 /* Drag with left mouse button to dissolve to the 3D background,
 Drag with middle mouse button to dissolve to checkerboard, and
-use right button for menu to clear stencil. */
+use right button for menu to clear stencil.  Press 'c' to switch between
+compositing cached layers and redrawing them through the stencil. */
 
+#include <GL/glew.h>
 #include <GL/glut.h>
 #include <stdlib.h>
 #include <string.h>
@@ -54,13 +56,199 @@ GLint eraserpos[2] =
 
 GLubyte *eraserpix = 0;
 int erasersize = 0;
+
+/*
+** Layered compositing.
+**
+** Instead of redrawing all three layers through the stencil buffer every
+** frame, each layer is kept in a texture of its own and only drawn again
+** when it changes, which for the static layers means when the window changes
+** size.  The layer shown at each pixel is kept in a mask texture, with a copy
+** in memory; the eraser updates the copy under it and uploads only that
+** rectangle.  A fragment program then picks the layer from the mask.
+*/
+GLboolean compositing = GL_FALSE;
+GLuint program;
+GLuint masktex, erasertex;
+GLubyte *mask = 0;
+GLuint layertex[3], layerfbo[3], layerdepth;
+GLboolean layerdirty[3];
+int layerpixels[3];           /* how many pixels of the mask show each layer */
+GLboolean visibleWin = GL_FALSE;
+
+void updateIdle(void);
+
+static const char *compositesource =
+"uniform sampler2D mask, layer0, layer1, layer2;\n"
+"void main()\n"
+"{\n"
+"	float id = texture2D(mask, gl_TexCoord[0].st).r * 255.0;\n"
+"	if (id < 0.5)\n"
+"		gl_FragColor = texture2D(layer0, gl_TexCoord[0].st);\n"
+"	else if (id < 1.5)\n"
+"		gl_FragColor = texture2D(layer1, gl_TexCoord[0].st);\n"
+"	else\n"
+"		gl_FragColor = texture2D(layer2, gl_TexCoord[0].st);\n"
+"}\n";
+
+void
+makeProgram(void)
+{
+	GLuint shader;
+	GLint status;
+	char log[1024];
+
+	shader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(shader, 1, &compositesource, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status) {
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		printf("composite shader: %s\n", log);
+	}
+
+	program = glCreateProgram();
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+	glDeleteShader(shader);
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "mask"), 0);
+	glUniform1i(glGetUniformLocation(program, "layer0"), 1);
+	glUniform1i(glGetUniformLocation(program, "layer1"), 2);
+	glUniform1i(glGetUniformLocation(program, "layer2"), 3);
+	glUseProgram(0);
+}
+
+GLuint
+makeTexture(GLint format, int wid, int ht, GLenum type, const GLvoid * pixels)
+{
+	GLuint texture;
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, wid, ht, 0, type, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+/* show the top layer everywhere */
+void
+clearMask(void)
+{
+	(void)memset(mask, 2, winWidth * winHeight);
+	layerpixels[0] = layerpixels[1] = 0;
+	layerpixels[2] = winWidth * winHeight;
+	glBindTexture(GL_TEXTURE_2D, masktex);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, winWidth, winHeight,
+		GL_LUMINANCE, GL_UNSIGNED_BYTE, mask);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	updateIdle();
+}
+
+/* (re)create the layer textures and the mask for the window size */
+void
+makeLayers(void)
+{
+	int i;
+
+	glDeleteFramebuffers(3, layerfbo);
+	glDeleteTextures(3, layertex);
+	glDeleteRenderbuffers(1, &layerdepth);
+	glDeleteTextures(1, &masktex);
+
+	/* the layers are drawn one at a time, so they share a depth buffer */
+	glGenRenderbuffers(1, &layerdepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, layerdepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, winWidth, winHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(3, layerfbo);
+	for (i = 0; i < 3; i++) {
+		layertex[i] = makeTexture(GL_RGBA8, winWidth, winHeight, GL_RGBA, NULL);
+		glBindFramebuffer(GL_FRAMEBUFFER, layerfbo[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, layertex[i], 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+			GL_RENDERBUFFER, layerdepth);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			printf("layer %d framebuffer is incomplete\n", i);
+		layerdirty[i] = GL_TRUE;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	mask = (GLubyte *)realloc(mask, winWidth * winHeight);
+	masktex = makeTexture(GL_LUMINANCE8, winWidth, winHeight, GL_LUMINANCE, NULL);
+	clearMask();
+}
+
+/* Set the mask to the current layer where the eraser is solid, and upload
+the rectangle under the eraser */
+void
+erase(void)
+{
+	int ew = winWidth / 4, eh = winHeight / 6;
+	int x0 = eraserpos[X] - winWidth / 8, y0 = eraserpos[Y] - winHeight / 12;
+	int x1 = x0 + ew, y1 = y0 + eh;
+	int x, y;
+	GLubyte *m;
+
+	if (x0 < 0)
+		x0 = 0;
+	if (y0 < 0)
+		y0 = 0;
+	if (x1 > winWidth)
+		x1 = winWidth;
+	if (y1 > winHeight)
+		y1 = winHeight;
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	for (y = y0; y < y1; y++) {
+		for (x = x0; x < x1; x++) {
+			int e = (y - (eraserpos[Y] - winHeight / 12)) * ew +
+				x - (eraserpos[X] - winWidth / 8);
+
+			m = &mask[y * winWidth + x];
+			if (eraserpix[e * 4 + 3] && *m != layer) {
+				layerpixels[*m]--;
+				layerpixels[layer]++;
+				*m = (GLubyte)layer;
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, masktex);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, winWidth);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, x0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, y0);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, x1 - x0, y1 - y0,
+		GL_LUMINANCE, GL_UNSIGNED_BYTE, mask);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	updateIdle();
+}
+
 void
 makeEraser(void)
 {
 	int i, skip;
 
 	erasersize = 4 * winWidth / 4 * winHeight / 6;
-	eraserpix = (GLubyte *)realloc(eraserpix, erasersize * sizeof(GLubyte));
+	/* the holes below may run 3 bytes past the end */
+	eraserpix = (GLubyte *)realloc(eraserpix, (erasersize + 3) * sizeof(GLubyte));
 
 	/* make it white */
 	(void)memset(eraserpix, 255, erasersize * sizeof(GLubyte));
@@ -78,6 +266,11 @@ makeEraser(void)
 			skip--;
 	}
 
+	if (compositing) {
+		glDeleteTextures(1, &erasertex);
+		erasertex = makeTexture(GL_RGBA8, winWidth / 4, winHeight / 6,
+			GL_RGBA, eraserpix);
+	}
 }
 
 /* ARGSUSED2 */
@@ -91,6 +284,8 @@ mouse(int button, int state, int x, int y)
 			layer = 1;
 		else                /* GLUT_MIDDLE: GLUT_RIGHT is for menu */
 			layer = 0;
+		if (compositing)
+			erase();
 	}
 	else {              /* GLUT_UP */
 		eraser = GL_FALSE;
@@ -99,9 +294,10 @@ mouse(int button, int state, int x, int y)
 }
 
 enum {
-	CLEAR
+	CLEAR, COMPOSITE
 };                      /* menu choices */
 GLboolean clearstencil = GL_TRUE;
+GLboolean cancomposite = GL_FALSE;
 
 void
 menu(int choice)
@@ -109,6 +305,23 @@ menu(int choice)
 	switch (choice) {
 	case CLEAR:
 		clearstencil = GL_TRUE;
+		if (compositing)
+			clearMask();
+		break;
+	case COMPOSITE:
+		if (!cancomposite) {
+			printf("compositing needs OpenGL 3.0 or framebuffer objects and shaders\n");
+			break;
+		}
+		/* the stencil and the mask start again from the top layer */
+		compositing = !compositing;
+		clearstencil = GL_TRUE;
+		if (compositing) {
+			makeEraser();
+			makeLayers();
+		}
+		printf("%s\n", compositing ? "compositing cached layers" : "redrawing through the stencil");
+		updateIdle();
 		break;
 	}
 	glutPostRedisplay();
@@ -123,6 +336,8 @@ reshape(int wid, int ht)
 	winHeight = ht;
 	clearstencil = GL_TRUE;
 	makeEraser();
+	if (compositing)
+		makeLayers();
 	glutPostRedisplay();
 }
 
@@ -307,8 +522,9 @@ drawlayer0(void)
 }
 
 void
-redraw(void)
+redrawstencil(void)
 {
+	glEnable(GL_STENCIL_TEST);
 	if (glutLayerGet(GLUT_NORMAL_DAMAGED) ||
 		clearstencil == GL_TRUE) {
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -334,13 +550,142 @@ redraw(void)
 	glutSwapBuffers();
 }
 
+/* draw a layer into its texture */
+void
+renderLayer(int i)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, layerfbo[i]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	switch (i) {
+	case 0:
+		drawlayer0();
+		break;
+	case 1:
+		drawlayer1();
+		break;
+	case 2:
+		drawlayer2();
+		break;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	layerdirty[i] = GL_FALSE;
+}
+
+/* draw a textured rectangle in window coordinates */
+void
+drawquad(int x, int y, int wid, int ht)
+{
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	gluOrtho2D(0, winWidth, 0, winHeight);
+
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+
+	glBegin(GL_QUADS);
+	glTexCoord2i(0, 0);
+	glVertex2i(x, y);
+	glTexCoord2i(1, 0);
+	glVertex2i(x + wid, y);
+	glTexCoord2i(1, 1);
+	glVertex2i(x + wid, y + ht);
+	glTexCoord2i(0, 1);
+	glVertex2i(x, y + ht);
+	glEnd();
+}
+
+/* pick the layer of each pixel from the mask */
+void
+composite(void)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		glActiveTexture(GL_TEXTURE1 + i);
+		glBindTexture(GL_TEXTURE_2D, layertex[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, masktex);
+
+	glUseProgram(program);
+	drawquad(0, 0, winWidth, winHeight);
+	glUseProgram(0);
+
+	for (i = 3; i > 0; i--) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/* show the eraser the way draweraser does, from its texture */
+void
+drawerasertexture(void)
+{
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, erasertex);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glEnable(GL_ALPHA_TEST);
+	glAlphaFunc(GL_NOTEQUAL, 0);
+
+	drawquad(eraserpos[X] - winWidth / 8, eraserpos[Y] - winHeight / 12,
+		winWidth / 4, winHeight / 6);
+
+	glDisable(GL_ALPHA_TEST);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
+
+void
+redraw(void)
+{
+	int i;
+
+	if (!compositing) {
+		redrawstencil();
+		return;
+	}
+
+	/* layers not shown anywhere are left until they are */
+	glDisable(GL_STENCIL_TEST);
+	for (i = 2; i >= 0; i--) {
+		if (layerdirty[i] && layerpixels[i])
+			renderLayer(i);
+	}
+
+	composite();
+
+	if (eraser)
+		drawerasertexture();
+
+	glutSwapBuffers();
+}
+
 void
 idle(void)
 {
-	angle += 1.f;
+	angle = fmodf(angle + 1.f, 360.f);
+	layerdirty[0] = GL_TRUE;
 	glutPostRedisplay();
 }
 
+/* the rotating layer only animates while the window is visible and, when
+compositing, while some pixel shows it */
+void
+updateIdle(void)
+{
+	if (visibleWin && (!compositing || layerpixels[0] > 0))
+		glutIdleFunc(idle);
+	else
+		glutIdleFunc(NULL);
+}
+
 void
 passive(int x, int y)
 {
@@ -355,6 +700,8 @@ motion(int x, int y)
 
 	eraserpos[X] = x;
 	eraserpos[Y] = winHeight - y;
+	if (compositing && eraser)
+		erase();
 
 	glutPostRedisplay();
 }
@@ -366,16 +713,17 @@ key(unsigned char key, int x, int y)
 	switch (key) {
 	case '\033':
 		exit(0);
+	case 'c':
+		menu(COMPOSITE);
+		break;
 	}
 }
 
 void
 visible(int vis)
 {
-	if (vis == GLUT_VISIBLE)
-		glutIdleFunc(idle);
-	else
-		glutIdleFunc(NULL);
+	visibleWin = (vis == GLUT_VISIBLE);
+	updateIdle();
 }
 
 const int TEXDIM = 256;
@@ -393,6 +741,11 @@ int main(int argc, char *argv[])
 	glutInitWindowSize(winWidth, winHeight);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_STENCIL | GLUT_DEPTH);
 	(void)glutCreateWindow("dissolve");
+	glewInit();
+	cancomposite = (GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object) && GLEW_VERSION_2_0;
+	compositing = cancomposite;
+	if (cancomposite)
+		makeProgram();
 	glutDisplayFunc(redraw);
 	glutMouseFunc(mouse);
 	glutMotionFunc(motion);
@@ -403,6 +756,7 @@ int main(int argc, char *argv[])
 
 	glutCreateMenu(menu);
 	glutAddMenuEntry("Clear Stencil", CLEAR);
+	glutAddMenuEntry("Toggle Compositing", COMPOSITE);
 	glutAttachMenu(GLUT_RIGHT_BUTTON);
 
 	glNewList(SPHERE, GL_COMPILE);
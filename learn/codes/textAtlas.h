@@ -0,0 +1,473 @@
+
+/* textAtlas.h - glyph atlas text for the GLUT fonts */
+
+/* The GLUT bitmap and stroke fonts are drawn one character at a time, with
+a raster position update and a bitmap upload or a strip of lines per
+character.  This draws them from a texture instead: each font is rendered
+once, through a framebuffer object, into an atlas of its printable ASCII
+characters, and each string is laid out once into a vertex buffer of
+textured quads that is kept for as long as the string is drawn, so drawing
+an unchanged string is a single glDrawArrays call whatever its length.
+
+text_draw places bitmap text the way glRasterPos does, at the window
+position of (x, y) in the current coordinates, and stroke text at (x, y)
+in the current coordinates in stroke font units, the way
+glutStrokeCharacter does after a translation.  The current color is used;
+with blending enabled, glyph edges are blended, otherwise they are cut at
+half coverage.
+
+Without framebuffer objects and vertex buffers the characters are drawn
+with glutBitmapCharacter and glutStrokeCharacter as before.
+
+Include it after GLEW and GLUT, with TEXT_ATLAS_IMPLEMENTATION defined in
+the source file, and only draw text after glewInit. */
+
+#ifndef TEXT_ATLAS_H
+#define TEXT_ATLAS_H
+
+typedef struct TextFont TextFont;
+
+TextFont *text_bitmap_font(void *font);
+TextFont *text_stroke_font(void *font, int height, GLfloat line_width);
+void text_draw(TextFont * font, GLfloat x, GLfloat y, const char *string);
+
+#endif /* TEXT_ATLAS_H */
+
+#if defined(TEXT_ATLAS_IMPLEMENTATION)
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define TEXT_FIRST_CHAR 32
+#define TEXT_LAST_CHAR 126
+#define TEXT_ATLAS_WIDTH 512
+#define TEXT_MAX_FONTS 16
+#define TEXT_CACHE_SIZE 32
+
+/* the GLUT stroke fonts reach 119.05 units above the baseline and 33.33
+below it */
+#define TEXT_STROKE_ASCENT 119.05f
+#define TEXT_STROKE_DESCENT 33.33f
+
+typedef struct TextGlyph {
+	/* quad relative to the pen position, in font units */
+	GLfloat x0, y0, x1, y1;
+	GLfloat s0, t0, s1, t1;
+	GLfloat advance;
+} TextGlyph;
+
+struct TextFont {
+	void *font;
+	int stroke;
+	int height;
+	GLfloat line_width;
+	GLfloat line_height;
+	GLuint texture;		/* zero when drawn a character at a time */
+	TextGlyph glyphs[TEXT_LAST_CHAR - TEXT_FIRST_CHAR + 1];
+};
+
+/* a string laid out in a vertex buffer of texture coordinate and position
+pairs, four vertices per glyph */
+typedef struct TextString {
+	TextFont *font;
+	char *text;
+	unsigned long used;
+	GLuint buffer;
+	GLsizei count;
+} TextString;
+
+static TextFont text_fonts[TEXT_MAX_FONTS];
+static int text_font_count;
+/* fonts drawn a character at a time once text_fonts is full; these only
+depend on the GLUT font, of which there are fewer than TEXT_MAX_FONTS */
+static TextFont text_plain_fonts[TEXT_MAX_FONTS];
+static int text_plain_font_count;
+static TextString text_cache[TEXT_CACHE_SIZE];
+static unsigned long text_clock;
+static int text_supported = -1;
+
+static int
+text_check_support(void)
+{
+	if (text_supported < 0)
+		text_supported = (GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object) &&
+			GLEW_VERSION_1_5;
+	return text_supported;
+}
+
+/* pixel height of a bitmap font; GLUT has no query for it */
+static int
+text_bitmap_height(void *font)
+{
+	if (font == GLUT_BITMAP_8_BY_13)
+		return 13;
+	if (font == GLUT_BITMAP_9_BY_15)
+		return 15;
+	if (font == GLUT_BITMAP_TIMES_ROMAN_10 || font == GLUT_BITMAP_HELVETICA_10)
+		return 10;
+	if (font == GLUT_BITMAP_HELVETICA_12)
+		return 12;
+	if (font == GLUT_BITMAP_HELVETICA_18)
+		return 18;
+	return 24;
+}
+
+/* Render the characters of a font into its atlas.  Each character gets a
+cell as wide as its advance and as high as the font, with a margin around
+it for the parts of glyphs that reach past those and to keep filtering
+from picking up the neighbouring cells. */
+static void
+text_build_atlas(TextFont * font)
+{
+	GLfloat scale, below;
+	int pad, cell_height, width, height;
+	int c, x, y;
+	GLint old_framebuffer;
+	GLuint framebuffer;
+	TextGlyph *glyph;
+
+	if (font->stroke) {
+		scale = font->height / (TEXT_STROKE_ASCENT + TEXT_STROKE_DESCENT);
+		pad = (int)ceil(font->line_width) + 1;
+		below = pad + TEXT_STROKE_DESCENT * scale;
+		cell_height = font->height + 2 * pad;
+		font->line_height = TEXT_STROKE_ASCENT + TEXT_STROKE_DESCENT;
+	} else {
+		scale = 1.f;
+		pad = 2;
+		below = (GLfloat)(pad + font->height / 2);
+		cell_height = font->height * 3 / 2 + 2 * pad + 2;
+		font->line_height = (GLfloat)(font->height + 2);
+	}
+
+	/* pack the cells into rows */
+	x = y = 0;
+	for (c = TEXT_FIRST_CHAR; c <= TEXT_LAST_CHAR; c++) {
+		int advance, cell_width;
+
+		glyph = &font->glyphs[c - TEXT_FIRST_CHAR];
+		if (font->stroke) {
+			glyph->advance = (GLfloat)glutStrokeWidth(font->font, c);
+			advance = (int)ceil(glyph->advance * scale);
+		} else {
+			advance = glutBitmapWidth(font->font, c);
+			glyph->advance = (GLfloat)advance;
+		}
+		cell_width = advance + 2 * pad;
+		if (x + cell_width > TEXT_ATLAS_WIDTH) {
+			x = 0;
+			y += cell_height + 1;
+		}
+		glyph->x0 = -pad / scale;
+		glyph->y0 = -below / scale;
+		glyph->x1 = (cell_width - pad) / scale;
+		glyph->y1 = (cell_height - below) / scale;
+		/* texture coordinates in texels until the size is known */
+		glyph->s0 = (GLfloat)x;
+		glyph->t0 = (GLfloat)y;
+		glyph->s1 = (GLfloat)(x + cell_width);
+		glyph->t1 = (GLfloat)(y + cell_height);
+		x += cell_width + 1;
+	}
+	width = TEXT_ATLAS_WIDTH;
+	for (height = 1; height < y + cell_height; height *= 2)
+		;
+
+	/* everything is put back afterwards, as the atlas may be made in the
+	middle of a frame */
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+
+	glGenTextures(1, &font->texture);
+	glBindTexture(GL_TEXTURE_2D, font->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	if (font->stroke) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	} else {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &old_framebuffer);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+		GL_TEXTURE_2D, font->texture, 0);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0, width, 0, height);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glViewport(0, 0, width, height);
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_ALPHA_TEST);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	/* white glyphs, so the current color can be modulated with them, with
+	their coverage in alpha */
+	glClearColor(1.f, 1.f, 1.f, 0.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glColor4f(1.f, 1.f, 1.f, 1.f);
+
+	if (font->stroke) {
+		/* overlapping strokes keep the larger coverage */
+		glEnable(GL_LINE_SMOOTH);
+		glEnable(GL_BLEND);
+		glBlendEquation(GL_MAX);
+		glLineWidth(font->line_width);
+	}
+
+	for (c = TEXT_FIRST_CHAR; c <= TEXT_LAST_CHAR; c++) {
+		glyph = &font->glyphs[c - TEXT_FIRST_CHAR];
+		if (font->stroke) {
+			glPushMatrix();
+			glTranslatef(glyph->s0 + pad, glyph->t0 + below, 0.f);
+			glScalef(scale, scale, 1.f);
+			glutStrokeCharacter(font->font, c);
+			glPopMatrix();
+		} else {
+			glRasterPos2f(glyph->s0 + pad, glyph->t0 + below);
+			glutBitmapCharacter(font->font, c);
+		}
+		glyph->s0 /= width;
+		glyph->t0 /= height;
+		glyph->s1 /= width;
+		glyph->t1 /= height;
+	}
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)old_framebuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+
+	if (font->stroke)
+		glGenerateMipmap(GL_TEXTURE_2D);
+	glPopAttrib();
+}
+
+static TextFont *
+text_find_font(void *glut_font, int stroke, int height, GLfloat line_width)
+{
+	TextFont *font;
+	int i;
+
+	for (i = 0; i < text_font_count; i++) {
+		font = &text_fonts[i];
+		if (font->font == glut_font && font->stroke == stroke &&
+			font->height == height && font->line_width == line_width)
+			return font;
+	}
+	if (text_font_count == TEXT_MAX_FONTS) {
+		/* no room for another atlas; never draw with a mismatched one */
+		for (i = 0; i < text_plain_font_count; i++) {
+			font = &text_plain_fonts[i];
+			if (font->font == glut_font && font->stroke == stroke)
+				return font;
+		}
+		font = &text_plain_fonts[text_plain_font_count++];
+		memset(font, 0, sizeof(TextFont));
+		font->font = glut_font;
+		font->stroke = stroke;
+		return font;
+	}
+
+	font = &text_fonts[text_font_count++];
+	memset(font, 0, sizeof(TextFont));
+	font->font = glut_font;
+	font->stroke = stroke;
+	font->height = height;
+	font->line_width = line_width;
+	if (text_check_support())
+		text_build_atlas(font);
+	return font;
+}
+
+/* Returns the atlas of a GLUT bitmap font, rendering it on first use */
+TextFont *
+text_bitmap_font(void *font)
+{
+	return text_find_font(font, 0, text_bitmap_height(font), 0.f);
+}
+
+/* Returns the atlas of a GLUT stroke font rendered with the specified
+pixel height and line width, rendering it on first use.  It should be
+about as large as the text is on the screen. */
+TextFont *
+text_stroke_font(void *font, int height, GLfloat line_width)
+{
+	return text_find_font(font, 1, height, line_width);
+}
+
+/* Lay out a string into a cache entry */
+static void
+text_layout(TextString * entry, TextFont * font, const char *string)
+{
+	GLfloat *vertices, *v;
+	GLfloat pen_x = 0.f, pen_y = 0.f;
+	const TextGlyph *glyph;
+	const char *p;
+
+	v = vertices = (GLfloat *)malloc(strlen(string) * 16 * sizeof(GLfloat) + 1);
+	for (p = string; *p; p++) {
+		int c = (unsigned char)*p;
+
+		if (c == '\n') {
+			pen_x = 0.f;
+			pen_y -= font->line_height;
+			continue;
+		}
+		if (c < TEXT_FIRST_CHAR || c > TEXT_LAST_CHAR)
+			continue;
+
+		glyph = &font->glyphs[c - TEXT_FIRST_CHAR];
+		v[0] = glyph->s0; v[1] = glyph->t0;
+		v[2] = pen_x + glyph->x0; v[3] = pen_y + glyph->y0;
+		v[4] = glyph->s1; v[5] = glyph->t0;
+		v[6] = pen_x + glyph->x1; v[7] = pen_y + glyph->y0;
+		v[8] = glyph->s1; v[9] = glyph->t1;
+		v[10] = pen_x + glyph->x1; v[11] = pen_y + glyph->y1;
+		v[12] = glyph->s0; v[13] = glyph->t1;
+		v[14] = pen_x + glyph->x0; v[15] = pen_y + glyph->y1;
+		v += 16;
+		pen_x += glyph->advance;
+	}
+
+	free(entry->text);
+	entry->font = font;
+	entry->text = (char *)malloc(strlen(string) + 1);
+	strcpy(entry->text, string);
+	entry->count = (GLsizei)((v - vertices) / 4);
+
+	if (!entry->buffer)
+		glGenBuffers(1, &entry->buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, entry->buffer);
+	glBufferData(GL_ARRAY_BUFFER, (v - vertices) * sizeof(GLfloat),
+		vertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	free(vertices);
+}
+
+/* Find the laid out string, replacing the least recently drawn one when it
+is not there */
+static TextString *
+text_lookup(TextFont * font, const char *string)
+{
+	TextString *entry, *oldest = &text_cache[0];
+	int i;
+
+	text_clock++;
+	for (i = 0; i < TEXT_CACHE_SIZE; i++) {
+		entry = &text_cache[i];
+		if (entry->font == font && entry->text && !strcmp(entry->text, string)) {
+			entry->used = text_clock;
+			return entry;
+		}
+		if (entry->used < oldest->used)
+			oldest = entry;
+	}
+
+	text_layout(oldest, font, string);
+	oldest->used = text_clock;
+	return oldest;
+}
+
+/* Draw a string a character at a time, without an atlas */
+static void
+text_draw_characters(TextFont * font, GLfloat x, GLfloat y, const char *string)
+{
+	const char *p;
+
+	if (font->stroke) {
+		glPushMatrix();
+		glTranslatef(x, y, 0.f);
+		for (p = string; *p; p++)
+			glutStrokeCharacter(font->font, *p);
+		glPopMatrix();
+	} else {
+		glRasterPos2f(x, y);
+		for (p = string; *p; p++)
+			glutBitmapCharacter(font->font, *p);
+	}
+}
+
+void
+text_draw(TextFont * font, GLfloat x, GLfloat y, const char *string)
+{
+	TextString *entry;
+	GLdouble modelview[16], projection[16];
+	GLdouble wx, wy, wz;
+	GLint viewport[4];
+
+	if (!font->texture) {
+		text_draw_characters(font, x, y, string);
+		return;
+	}
+
+	entry = text_lookup(font, string);
+	if (!entry->count)
+		return;
+
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glDisable(GL_LIGHTING);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, font->texture);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glEnable(GL_ALPHA_TEST);
+	glAlphaFunc(GL_GREATER, glIsEnabled(GL_BLEND) ? 0.f : .5f);
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	if (font->stroke) {
+		glTranslatef(x, y, 0.f);
+	} else {
+		/* bitmap text is in window pixels from the raster position */
+		glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+		glGetDoublev(GL_PROJECTION_MATRIX, projection);
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		gluProject(x, y, 0., modelview, projection, viewport, &wx, &wy, &wz);
+
+		glDisable(GL_DEPTH_TEST);
+		glMatrixMode(GL_PROJECTION);
+		glPushMatrix();
+		glLoadIdentity();
+		gluOrtho2D(0, viewport[2], 0, viewport[3]);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		glTranslated(floor(wx - viewport[0] + .5), floor(wy - viewport[1] + .5), 0.);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, entry->buffer);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), (const GLvoid *)0);
+	glVertexPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), (const GLvoid *)(2 * sizeof(GLfloat)));
+	glDrawArrays(GL_QUADS, 0, entry->count);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!font->stroke) {
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+	}
+	glPopMatrix();
+	glPopClientAttrib();
+	glPopAttrib();
+}
+
+#endif /* TEXT_ATLAS_IMPLEMENTATION */
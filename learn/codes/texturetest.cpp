@@ -2,66 +2,478 @@
 #define WindowHeight 400
 #define WindowTitle  "OpenGL"
 
+#include <gl/glew.h>
 #include <gl/glut.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* ͼģ
+* ǰgrabÿζͬglReadPixelsGPUһܷ֡أ
+* Ҫdummy.bmpļͷfseek޸ĿȺ͸߶
+* ڰضػ(PBO)УglReadPixelsֻǷƾ
+* PBOһÿ֡һζȡȡ֡ǰһΣ
+* ʱGPUɸƣӳ仺ȴ
+* ȡصؽ̨дļֱ̣߳BMPPNGļͷд̣
+* ¼ʱ̲߳ᱻ
+* ֧PBOʱOpenGL 2.1ûARB_pixel_buffer_objectչ˻صͬȡ
+*/
+#define CAPTURE_PBO_COUNT  3    // PBOȡCAPTURE_PBO_COUNT-1֡Ժȡ
+#define CAPTURE_MAX_QUEUED 32   // дļ߳ѹ֡ʱȴǶ֡
+
+enum { CAPTURE_BMP, CAPTURE_PNG };
+
+/* һ֡
+* ÿBGR˳򣬰4ֽڶ룬һпʼBMPظʽ
+*/
+struct CaptureFrame
+{
+     std::vector<GLubyte> pixels;
+     GLint width;
+     GLint height;
+     GLint stride;
+     int   format;
+     char  path[64];
+};
+
+/* еһPBO
+*/
+struct CaptureSlot
+{
+     GLuint     buffer;
+     GLsizeiptr size;       // ѷ
+     int        pending;    // ǷѷδȡصĶȡ
+     GLint      width;
+     GLint      height;
+     GLint      stride;
+     int        format;
+     char       path[64];
+};
+
+static CaptureSlot captureSlots[CAPTURE_PBO_COUNT];
+static int         captureNext;      // һ֡ʹõPBO
+static int         captureUsePBO;
+
+static std::thread                captureThread;
+static std::mutex                 captureLock;
+static std::condition_variable    captureWakeup;   // µ֡Ҫ˳
+static std::condition_variable    captureDrained;  // ˿λ
+static std::deque<CaptureFrame*>  captureQueue;
+static std::vector<CaptureFrame*> captureFree;     // д֡ظʹ
+static bool                       captureQuit;
+
+/* Сд16λ32λBMPļʹã
+*/
+static void put_le16(GLubyte* p, GLuint v)
+{
+     p[0] = (GLubyte)(v);
+     p[1] = (GLubyte)(v >> 8);
+}
+static void put_le32(GLubyte* p, GLuint v)
+{
+     p[0] = (GLubyte)(v);
+     p[1] = (GLubyte)(v >> 8);
+     p[2] = (GLubyte)(v >> 16);
+     p[3] = (GLubyte)(v >> 24);
+}
+/* д32λPNGļʹã
+*/
+static void put_be32(GLubyte* p, GLuint v)
+{
+     p[0] = (GLubyte)(v >> 24);
+     p[1] = (GLubyte)(v >> 16);
+     p[2] = (GLubyte)(v >> 8);
+     p[3] = (GLubyte)(v);
+}
+
+/* write_bmp
+* ֱ54ֽڵļͷ14ֽڵBITMAPFILEHEADER40ֽڵBITMAPINFOHEADER
+* Ҫdummy.bmp
+* ߶ΪʾشһпʼţglReadPixelsĽͬ
+*/
+#define BMP_Header_Length 54
+static void write_bmp(FILE* pFile, const CaptureFrame* frame)
+{
+     GLubyte BMP_Header[BMP_Header_Length];
+     GLuint   PixelDataLength = frame->stride * frame->height;
+
+     memset(BMP_Header, 0, sizeof(BMP_Header));
+     BMP_Header[0] = 'B';
+     BMP_Header[1] = 'M';
+     put_le32(BMP_Header + 0x02, BMP_Header_Length + PixelDataLength);  // ļС
+     put_le32(BMP_Header + 0x0A, BMP_Header_Length);                    // ݵλ
+     put_le32(BMP_Header + 0x0E, 40);                                   // ϢͷС
+     put_le32(BMP_Header + 0x12, frame->width);
+     put_le32(BMP_Header + 0x16, frame->height);
+     put_le16(BMP_Header + 0x1A, 1);                                    // λ
+     put_le16(BMP_Header + 0x1C, 24);                                   // ÿλ
+     put_le32(BMP_Header + 0x22, PixelDataLength);
+     put_le32(BMP_Header + 0x26, 2835);                                 // 72 DPI
+     put_le32(BMP_Header + 0x2A, 2835);
+
+     fwrite(BMP_Header, sizeof(BMP_Header), 1, pFile);
+     fwrite(&frame->pixels[0], PixelDataLength, 1, pFile);
+}
+
+/* crc32_update
+* PNGݿCRC32Уֵ
+*/
+static GLuint crc32_update(GLuint crc, const GLubyte* data, size_t length)
+{
+     static GLuint table[256];
+     static bool   ready = false;
+     size_t i;
+
+     // ֻдļ̻߳ãһεʱɲұ
+     if( !ready )
+     {
+         for(GLuint n = 0; n < 256; ++n)
+         {
+             GLuint c = n;
+             for(int k = 0; k < 8; ++k)
+                 c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+             table[n] = c;
+         }
+         ready = true;
+     }
+
+     crc = ~crc;
+     for(i = 0; i < length; ++i)
+         crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+     return ~crc;
+}
+
+static void write_png_chunk(FILE* pFile, const char* type,
+                            const GLubyte* data, size_t length)
+{
+     GLubyte buffer[4];
+     GLuint   crc;
+
+     put_be32(buffer, (GLuint)length);
+     fwrite(buffer, 4, 1, pFile);
+     fwrite(type, 4, 1, pFile);
+     if( length > 0 )
+         fwrite(data, length, 1, pFile);
+
+     crc = crc32_update(0, (const GLubyte*)type, 4);
+     crc = crc32_update(crc, data, length);
+     put_be32(buffer, crc);
+     fwrite(buffer, 4, 1, pFile);
+}
+
+/* write_png
+* PNGشһпʼ˳ΪRGBÿǰһ˷ʽֽ
+* ѹʹzlibʽֻòѹĴ洢飬дļ̼߳ʱ䣬
+* ļBMPԴһЩҪСļʱѹ
+*/
+static void write_png(FILE* pFile, const CaptureFrame* frame)
+{
+     static const GLubyte signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+     GLubyte IHDR[13];
+     std::vector<GLubyte> raw;
+     std::vector<GLubyte> IDAT;
+     GLuint  a = 1, b = 0;
+     size_t  i, offset;
+     GLint   x, y;
+
+     put_be32(IHDR + 0, frame->width);
+     put_be32(IHDR + 4, frame->height);
+     IHDR[8] = 8;     // ÿɫ8λ
+     IHDR[9] = 2;     // RGB
+     IHDR[10] = 0;    // ѹʽ
+     IHDR[11] = 0;    // ˷ʽ
+     IHDR[12] = 0;    // ɨ
+
+     // ɴϵ¡RGB˳
+     raw.resize((size_t)(frame->width * 3 + 1) * frame->height);
+     for(y = 0; y < frame->height; ++y)
+     {
+         const GLubyte* src = &frame->pixels[(size_t)(frame->height - 1 - y) * frame->stride];
+         GLubyte* dst = &raw[(size_t)(frame->width * 3 + 1) * y];
+         *dst++ = 0;
+         for(x = 0; x < frame->width; ++x, src += 3, dst += 3)
+         {
+             dst[0] = src[2];
+             dst[1] = src[1];
+             dst[2] = src[0];
+         }
+     }
+
+     // zlibͷɸ65535ֽڵĴ洢顢Adler32Уֵ
+     IDAT.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+     IDAT.push_back(0x78);
+     IDAT.push_back(0x01);
+     offset = 0;
+     do
+     {
+         size_t length = raw.size() - offset;
+         GLubyte header[5];
+
+         if( length > 65535 )
+             length = 65535;
+         header[0] = (offset + length == raw.size()) ? 1 : 0;
+         put_le16(header + 1, (GLuint)length);
+         put_le16(header + 3, (GLuint)~length);
+         IDAT.insert(IDAT.end(), header, header + 5);
+         IDAT.insert(IDAT.end(), raw.begin() + offset, raw.begin() + offset + length);
+         offset += length;
+     } while( offset < raw.size() );
+
+     for(i = 0; i < raw.size(); ++i)
+     {
+         a = (a + raw[i]) % 65521;
+         b = (b + a) % 65521;
+     }
+     IDAT.resize(IDAT.size() + 4);
+     put_be32(&IDAT[IDAT.size() - 4], (b << 16) | a);
+
+     fwrite(signature, sizeof(signature), 1, pFile);
+     write_png_chunk(pFile, "IHDR", IHDR, sizeof(IHDR));
+     write_png_chunk(pFile, "IDAT", &IDAT[0], IDAT.size());
+     write_png_chunk(pFile, "IEND", NULL, 0);
+}
+
+/* дļ߳
+* Ӷȡ֡дļд֡ŻcaptureFreeظʹ
+*/
+static void capture_writer(void)
+{
+     std::unique_lock<std::mutex> lock(captureLock);
+
+     for(;;)
+     {
+         CaptureFrame* frame;
+         FILE* pWritingFile;
+
+         while( !captureQuit && captureQueue.empty() )
+             captureWakeup.wait(lock);
+         if( captureQueue.empty() )
+             break;
+
+         frame = captureQueue.front();
+         captureQueue.pop_front();
+         lock.unlock();
+
+         pWritingFile = fopen(frame->path, "wb");
+         if( pWritingFile != 0 )
+         {
+             if( frame->format == CAPTURE_PNG )
+                 write_png(pWritingFile, frame);
+             else
+                 write_bmp(pWritingFile, frame);
+             fclose(pWritingFile);
+         }
+
+         lock.lock();
+         captureFree.push_back(frame);
+         captureDrained.notify_one();
+     }
+}
+
+/* ȡһõ֡ظʹд֡ÿ֡ڴ
+*/
+static CaptureFrame* capture_alloc(GLint width, GLint height, GLint stride,
+                                   int format, const char* path)
+{
+     CaptureFrame* frame = 0;
+     {
+         std::lock_guard<std::mutex> lock(captureLock);
+         if( !captureFree.empty() )
+         {
+             frame = captureFree.back();
+             captureFree.pop_back();
+         }
+     }
+     if( frame == 0 )
+         frame = new CaptureFrame;
+
+     frame->pixels.resize((size_t)stride * height);
+     frame->width = width;
+     frame->height = height;
+     frame->stride = stride;
+     frame->format = format;
+     strncpy(frame->path, path, sizeof(frame->path) - 1);
+     frame->path[sizeof(frame->path) - 1] = '\0';
+     return frame;
+}
+
+/* ֡дļ߳
+* ʱȴдļ̣߳¼ʱûҲ֡
+*/
+static void capture_submit(CaptureFrame* frame)
+{
+     std::unique_lock<std::mutex> lock(captureLock);
+     while( captureQueue.size() >= CAPTURE_MAX_QUEUED )
+         captureDrained.wait(lock);
+     captureQueue.push_back(frame);
+     captureWakeup.notify_one();
+}
+
+/* capture_retrieve
+* ӳһPBOеظƳдļ߳
+*/
+static void capture_retrieve(CaptureSlot* slot)
+{
+     CaptureFrame* frame;
+     const GLubyte* pPixelData;
+
+     glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+     pPixelData = (const GLubyte*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+     if( pPixelData != 0 )
+     {
+         frame = capture_alloc(slot->width, slot->height, slot->stride,
+                               slot->format, slot->path);
+         memcpy(&frame->pixels[0], pPixelData, frame->pixels.size());
+         glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+         capture_submit(frame);
+     }
+     glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+     slot->pending = 0;
+}
+
+/* capture_stop
+* дļ߳де֡ٽ
+* ʹatexitעᣬʱڿѾرգﲻܵOpenGL
+*/
+static void capture_stop(void)
+{
+     {
+         std::lock_guard<std::mutex> lock(captureLock);
+         captureQuit = true;
+         captureWakeup.notify_one();
+     }
+     if( captureThread.joinable() )
+         captureThread.join();
+
+     while( !captureFree.empty() )
+     {
+         delete captureFree.back();
+         captureFree.pop_back();
+     }
+}
+
+/* capture_init
+* ҪڴڲglewInitԺ
+*/
+void capture_init(void)
+{
+     GLint i;
+
+     captureUsePBO = GLEW_VERSION_2_1 ||
+         (GLEW_VERSION_1_5 && GLEW_ARB_pixel_buffer_object);
+     if( captureUsePBO )
+     {
+         for(i = 0; i < CAPTURE_PBO_COUNT; ++i)
+         {
+             memset(&captureSlots[i], 0, sizeof(captureSlots[i]));
+             glGenBuffers(1, &captureSlots[i].buffer);
+         }
+     }
+
+     captureThread = std::thread(capture_writer);
+     atexit(capture_stop);
+}
+
+/* capture_frame
+* ץȡǰڵĺ̨浽ļpath
+* ӦglutSwapBuffers֮ǰãԺ̨ǲȷ
+*/
+void capture_frame(const char* path, int format)
+{
+     GLint width = glutGet(GLUT_WINDOW_WIDTH);
+     GLint height = glutGet(GLUT_WINDOW_HEIGHT);
+     GLint stride;
+     CaptureSlot* slot;
+
+     // ÿһеݳȣBMPҪ4ı
+     stride = (width * 3 + 3) & ~3;
+
+     glReadBuffer(GL_BACK);
+     glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+     if( !captureUsePBO )
+     {
+         CaptureFrame* frame = capture_alloc(width, height, stride, format, path);
+         glReadPixels(0, 0, width, height,
+             GL_BGR_EXT, GL_UNSIGNED_BYTE, &frame->pixels[0]);
+         capture_submit(frame);
+         return;
+     }
+
+     // ʱ細ڱˣ·
+     slot = &captureSlots[captureNext];
+     glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+     if( slot->size < (GLsizeiptr)stride * height )
+     {
+         slot->size = (GLsizeiptr)stride * height;
+         glBufferData(GL_PIXEL_PACK_BUFFER, slot->size, NULL, GL_STREAM_READ);
+     }
+
+     // ĿPBOʱһǻеƫȸɾͷ
+     glReadPixels(0, 0, width, height, GL_BGR_EXT, GL_UNSIGNED_BYTE, 0);
+     glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+     slot->pending = 1;
+     slot->width = width;
+     slot->height = height;
+     slot->stride = stride;
+     slot->format = format;
+     strncpy(slot->path, path, sizeof(slot->path) - 1);
+     slot->path[sizeof(slot->path) - 1] = '\0';
+
+     // ȡػһζȡCAPTURE_PBO_COUNT-1֡ǰ
+     captureNext = (captureNext + 1) % CAPTURE_PBO_COUNT;
+     slot = &captureSlots[captureNext];
+     if( slot->pending )
+         capture_retrieve(slot);
+}
+
+/* capture_flush
+* ˳ȡδȡصĶȡ
+* ټʱã֡һֱPBO
+*/
+void capture_flush(void)
+{
+     GLint i;
+
+     if( !captureUsePBO )
+         return;
+
+     for(i = 0; i < CAPTURE_PBO_COUNT; ++i)
+     {
+         CaptureSlot* slot = &captureSlots[(captureNext + i) % CAPTURE_PBO_COUNT];
+         if( slot->pending )
+             capture_retrieve(slot);
+     }
+}
+
+/* ͼ
+* Rʼֹͣ¼ƣÿһ֡Ϊһŵļ
+* PBMPPNGʽ֮л
+* ¼ʱǰһÿλƶѴݱΪgrab.bmpgrab.png
+*/
+int captureFormat = CAPTURE_BMP;
+int recording = 0;
+int recordFrame = 0;
 
 /* grab
 * ץȡе
-* 贰ڿΪWindowWidth߶ΪWindowHeight
 */
-#define BMP_Header_Length 54
 void grab(void)
 {
-     FILE*     pDummyFile;
-     FILE*     pWritingFile;
-     GLubyte* pPixelData;
-     GLubyte   BMP_Header[BMP_Header_Length];
-     GLint     i, j;
-     GLint     PixelDataLength;
-
-     // ݵʵʳ
-     i = WindowWidth * 3;    // õÿһеݳ
-    while( i%4 != 0 )       // ݣֱiǵı
-         ++i;                // и㷨
-                            // ׷ֱۣٶû̫Ҫ
-     PixelDataLength = i * WindowHeight;
-
-     // ڴʹļ
-     pPixelData = (GLubyte*)malloc(PixelDataLength);
-    if( pPixelData == 0 )
-        exit(0);
-
-     pDummyFile = fopen("dummy.bmp", "rb");
-    if( pDummyFile == 0 )
-        exit(0);
-
-     pWritingFile = fopen("grab.bmp", "wb");
-    if( pWritingFile == 0 )
-        exit(0);
-
-     // ȡ
-     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-     glReadPixels(0, 0, WindowWidth, WindowHeight,
-         GL_BGR_EXT, GL_UNSIGNED_BYTE, pPixelData);
-
-     // dummy.bmpļͷΪļļͷ
-    fread(BMP_Header, sizeof(BMP_Header), 1, pDummyFile);
-    fwrite(BMP_Header, sizeof(BMP_Header), 1, pWritingFile);
-    fseek(pWritingFile, 0x0012, SEEK_SET);
-     i = WindowWidth;
-     j = WindowHeight;
-    fwrite(&i, sizeof(i), 1, pWritingFile);
-    fwrite(&j, sizeof(j), 1, pWritingFile);
-
-     // д
-    fseek(pWritingFile, 0, SEEK_END);
-    fwrite(pPixelData, PixelDataLength, 1, pWritingFile);
-
-     // ͷڴ͹رļ
-    fclose(pDummyFile);
-    fclose(pWritingFile);
-    free(pPixelData);
+     char path[64];
+     const char* ext = (captureFormat == CAPTURE_PNG) ? "png" : "bmp";
+
+     if( recording )
+         sprintf(path, "grab_%05d.%s", recordFrame++, ext);
+     else
+         sprintf(path, "grab.%s", ext);
+     capture_frame(path, captureFormat);
 }
 /* power_of_two
 * һǷΪ2ηǣ1򷵻0
@@ -199,6 +611,8 @@ GLuint load_texture(const char* file_name)
 GLuint texGround;
 GLuint texWall;
 
+void idle(void);
+
 void display(void)
 {
      // Ļ
@@ -238,9 +652,45 @@ void display(void)
          glTexCoord2f(5.0f, 0.0f); glVertex3f(6.0f, -3.0f, 0.0f);
      glEnd();
 
-     // ݵļ
-     glutSwapBuffers();
+     // ݵļȻ󽻻
      grab();
+     glutSwapBuffers();
+
+     // ͣԺȡػPBOе֡
+     glutIdleFunc(&idle);
+}
+
+void idle(void)
+{
+     if( recording )
+         glutPostRedisplay();
+     else
+     {
+         capture_flush();
+         glutIdleFunc(NULL);
+     }
+}
+
+void keyboard(unsigned char key, int x, int y)
+{
+     switch( key )
+     {
+     case 'r':
+     case 'R':
+         recording = !recording;
+         printf(recording ? "ʼ¼\n" : "ֹͣ¼ƣ%d֡\n", recordFrame);
+         glutPostRedisplay();
+         break;
+     case 'p':
+     case 'P':
+         captureFormat = (captureFormat == CAPTURE_PNG) ? CAPTURE_BMP : CAPTURE_PNG;
+         printf("ͼʽ%s\n", (captureFormat == CAPTURE_PNG) ? "PNG" : "BMP");
+         glutPostRedisplay();
+         break;
+     case 27:
+         capture_flush();
+         exit(0);
+     }
 }
 
 int main(int argc, char* argv[])
@@ -252,8 +702,12 @@ int main(int argc, char* argv[])
      glutInitWindowSize(WindowWidth, WindowHeight);
      glutCreateWindow(WindowTitle);
      glutDisplayFunc(&display);
+     glutKeyboardFunc(&keyboard);
 
      // һЩʼ
+     glewInit();
+     capture_init();
+     printf("%s\n", captureUsePBO ? "ʹPBO첽ȡ" : "֧PBOʹͬȡ");
      glEnable(GL_DEPTH_TEST);
      glEnable(GL_TEXTURE_2D);
      texGround = load_texture("ground.bmp");
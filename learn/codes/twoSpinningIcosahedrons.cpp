@@ -10,9 +10,12 @@ The blending factors for the two icosahedrons vary sinusoidally
 and slightly out of phase.  blender also renders two lines of
 text in a stroke font: one line antialiased, the other not.  */
 
+#include <GL/glew.h>
 #include <GL/glut.h>
 #include <stdio.h>
 #include <math.h>
+#define TEXT_ATLAS_IMPLEMENTATION
+#include "textAtlas.h"
 
 GLfloat light0_ambient[] =
 { 0.2, 0.2, 0.2, 1.0 };
@@ -32,13 +35,9 @@ GLfloat angle1 = 0.0, angle2 = 0.0;
 void
 output(GLfloat x, GLfloat y, char *text)
 {
-	char *p;
-
-	glPushMatrix();
-	glTranslatef(x, y, 0);
-	for (p = text; *p; p++)
-		glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
-	glPopMatrix();
+	/* With blending the glyph edges are smoothed, without it they are cut
+	at half coverage, which leaves the jaggies of the unsmoothed lines. */
+	text_draw(text_stroke_font(GLUT_STROKE_ROMAN, 64, 4.0), x, y, text);
 }
 
 void
@@ -124,6 +123,7 @@ main(int argc, char **argv)
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
 	glutCreateWindow("blender");
+	glewInit();
 	glutDisplayFunc(display);
 	glutVisibilityFunc(visible);
 
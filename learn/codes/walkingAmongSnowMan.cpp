@@ -1,13 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <vector>
 
+#include <GL/glew.h>
 #ifdef __APPLE__
 #include <GLUT/glut.h>
 #else
 #include <GL/glut.h>
 #endif
 
+#define TEXT_ATLAS_IMPLEMENTATION
+#include "textAtlas.h"
+
 // angle of rotation for the camera direction
 float angle = 0.0f;
 
@@ -29,29 +34,105 @@ int h, w;
 // variables to compute frames per second
 int frame;
 long time, timebase;
-char s[50];
+char s[100];
 
-// variables to hold window identifiers
-int mainWindow, subWindow1, subWindow2, subWindow3;
-//border between subwindows
+// identifier of the window
+int mainWindow;
+//border between views
 int border = 6;
 
-void setProjection(int w1, int h1)
-{
-	float ratio;
-	// Prevent a divide by zero, when window is too short
-	// (you cant make a window of zero width).
-	ratio = 1.0f * w1 / h1;
-	// Reset the coordinate system before modifying
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
+// The three views used to be subwindows, each with its own context that
+// the whole scene was traversed and drawn for.  They are now viewports of
+// the one window: the snowmen are culled for all the views in a single pass
+// over the grid and uploaded together, and with OpenGL 3.3 the matrices of
+// all the views are in one uniform buffer.
+struct View {
+	// viewport, from the bottom left corner of the window
+	int x, y, width, height;
+	float projection[16];
+	float modelview[16];
+	// projection * modelview
+	float viewProjection[16];
+	// positions of the snowmen that passed culling for this view, and
+	// where they start in the instance buffer
+	std::vector<float> visible;
+	GLintptr instanceOffset;
+};
+
+View views[3];
 
-	// Set the viewport to be the entire window
-	glViewport(0, 0, w1, h1);
+// -----------------------------------
+//             MATRICES
+// -----------------------------------
 
-	// Set the clipping volume
-	gluPerspective(45, ratio, 0.1, 1000);
-	glMatrixMode(GL_MODELVIEW);
+// column major, like OpenGL
+void multiplyMatrix(float *r, const float *a, const float *b) {
+
+	for (int col = 0; col < 4; col++)
+		for (int row = 0; row < 4; row++)
+			r[col * 4 + row] =
+				a[0 * 4 + row] * b[col * 4 + 0] +
+				a[1 * 4 + row] * b[col * 4 + 1] +
+				a[2 * 4 + row] * b[col * 4 + 2] +
+				a[3 * 4 + row] * b[col * 4 + 3];
+}
+
+// same as gluPerspective
+void setPerspective(float *m, float fovy, float ratio, float zNear, float zFar) {
+
+	float f = 1.0f / tanf(fovy * 3.14159265f / 360.0f);
+
+	for (int i = 0; i < 16; i++)
+		m[i] = 0.0f;
+	m[0] = f / ratio;
+	m[5] = f;
+	m[10] = (zFar + zNear) / (zNear - zFar);
+	m[11] = -1.0f;
+	m[14] = 2.0f * zFar * zNear / (zNear - zFar);
+}
+
+// same as gluLookAt
+void setLookAt(float *m,
+	float ex, float ey, float ez,
+	float cx, float cy, float cz,
+	float ux, float uy, float uz) {
+
+	float f[3] = { cx - ex, cy - ey, cz - ez };
+	float l = sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+	f[0] /= l; f[1] /= l; f[2] /= l;
+
+	// s = f x up, u = s x f
+	float s[3] = { f[1] * uz - f[2] * uy, f[2] * ux - f[0] * uz, f[0] * uy - f[1] * ux };
+	l = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+	s[0] /= l; s[1] /= l; s[2] /= l;
+	float u[3] = { s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0] };
+
+	m[0] = s[0]; m[4] = s[1]; m[8] = s[2];
+	m[1] = u[0]; m[5] = u[1]; m[9] = u[2];
+	m[2] = -f[0]; m[6] = -f[1]; m[10] = -f[2];
+	m[3] = 0.0f; m[7] = 0.0f; m[11] = 0.0f;
+	m[12] = -(s[0] * ex + s[1] * ey + s[2] * ez);
+	m[13] = -(u[0] * ex + u[1] * ey + u[2] * ez);
+	m[14] = f[0] * ex + f[1] * ey + f[2] * ez;
+	m[15] = 1.0f;
+}
+
+// sets the viewport of a view, given from the top left corner of the window
+// like the subwindows used to be
+void setView(View *view, int x1, int y1, int w1, int h1) {
+
+	// Prevent a divide by zero, when the view is too short
+	if (w1 < 1)
+		w1 = 1;
+	if (h1 < 1)
+		h1 = 1;
+
+	view->x = x1;
+	view->y = h - y1 - h1;
+	view->width = w1;
+	view->height = h1;
+
+	setPerspective(view->projection, 45, 1.0f * w1 / h1, 0.1f, 1000);
 }
 
 void changeSize(int w1, int h1) {
@@ -63,56 +144,454 @@ void changeSize(int w1, int h1) {
 	w = w1;
 	h = h1;
 
-	// set subwindow 1 as the active window
-	glutSetWindow(subWindow1);
-	// resize and reposition the sub window
-	glutPositionWindow(border, border);
-	glutReshapeWindow(w - 2 * border, h / 2 - border * 3 / 2);
-	setProjection(w - 2 * border, h / 2 - border * 3 / 2);
-
-	// set subwindow 2 as the active window
-	glutSetWindow(subWindow2);
-	// resize and reposition the sub window
-	glutPositionWindow(border, (h + border) / 2);
-	glutReshapeWindow(w / 2 - border * 3 / 2, h / 2 - border * 3 / 2);
-	setProjection(w / 2 - border * 3 / 2, h / 2 - border * 3 / 2);
-
-	// set subwindow 3 as the active window
-	glutSetWindow(subWindow3);
-	// resize and reposition the sub window
-	glutPositionWindow((w + border) / 2, (h + border) / 2);
-	glutReshapeWindow(w / 2 - border * 3 / 2, h / 2 - border * 3 / 2);
-	setProjection(w / 2 - border * 3 / 2, h / 2 - border * 3 / 2);
+	// view 1 on top, views 2 and 3 side by side below it
+	setView(&views[0], border, border, w - 2 * border, h / 2 - border * 3 / 2);
+	setView(&views[1], border, (h + border) / 2, w / 2 - border * 3 / 2, h / 2 - border * 3 / 2);
+	setView(&views[2], (w + border) / 2, (h + border) / 2, w / 2 - border * 3 / 2, h / 2 - border * 3 / 2);
+}
+
+// the cameras of the views, following the main camera
+void updateViews() {
+
+	// view 1 looks through the main camera
+	setLookAt(views[0].modelview,
+		x, y, z,
+		x + lx, y + ly, z + lz,
+		0.0f, 1.0f, 0.0f);
+	// view 2 looks down on it
+	setLookAt(views[1].modelview,
+		x, y + 15, z,
+		x, y - 1, z,
+		lx, 0, lz);
+	// view 3 looks at it from the side
+	setLookAt(views[2].modelview,
+		x - lz * 10, y, z + lx * 10,
+		x, y, z,
+		0.0f, 1.0f, 0.0f);
+
+	for (int v = 0; v < 3; v++)
+		multiplyMatrix(views[v].viewProjection, views[v].projection, views[v].modelview);
 }
 
-void drawSnowMan() {
+// -----------------------------------
+//             SNOWMEN
+// -----------------------------------
 
-	glColor3f(1.0f, 1.0f, 1.0f);
+// The snowman is baked once into an indexed mesh with a color per vertex,
+// and every snowman is an instance of it with its own position.  With
+// OpenGL 3.3 all the visible snowmen of a view are drawn with a single
+// glDrawElementsInstanced call, with the positions in an instance buffer;
+// elsewhere the same mesh is drawn once per snowman.
+
+// number of snowmen, set with the first command line argument or + and -
+int snowManCount = 36;
+// distance between two snowmen in the grid
+float snowManSpacing = 10.0f;
+// bounding sphere of a snowman, relative to its position
+const float snowManCenterY = 1.0f;
+const float snowManRadius = 1.05f;
+// snowmen are culled by blocks of this many rows and columns first
+const int cullBlockSize = 16;
+
+int useCulling = 1;
+int useInstancing = 0;
+int benchmarking = 0;
+
+struct SnowManVertex {
+	float x, y, z;
+	float r, g, b;
+};
+
+// the baked mesh
+std::vector<SnowManVertex> snowManVertices;
+std::vector<GLushort> snowManIndices;
+
+// positions (x, 0, z) of all the snowmen, and the grid they are laid out in
+std::vector<float> snowManPositions;
+int gridSide;
+
+// the buffers of the mesh and of the instances
+struct SnowManMesh {
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+	GLuint instanceBuffer;
+	GLuint program;
+	// uniform buffer with the matrices of all the views
+	GLuint viewBuffer;
+	GLint viewLocation;
+	GLsizeiptr instanceCapacity;
+};
+
+SnowManMesh mesh;
+
+void addSphere(float cx, float cy, float cz, float radius,
+	int slices, int stacks, float r, float g, float b) {
+
+	GLushort base = (GLushort)snowManVertices.size();
+
+	for (int i = 0; i <= stacks; i++) {
+		float phi = 3.14159265f * i / stacks;
+		for (int j = 0; j <= slices; j++) {
+			float theta = 2.0f * 3.14159265f * j / slices;
+			SnowManVertex v = {
+				cx + radius * sinf(phi) * cosf(theta),
+				cy + radius * cosf(phi),
+				cz - radius * sinf(phi) * sinf(theta),
+				r, g, b };
+			snowManVertices.push_back(v);
+		}
+	}
 
-	// Draw Body
-	glTranslatef(0.0f, 0.75f, 0.0f);
-	glutSolidSphere(0.75f, 20, 20);
+	for (int i = 0; i < stacks; i++)
+		for (int j = 0; j < slices; j++) {
+			GLushort a = base + i * (slices + 1) + j;
+			GLushort c = a + slices + 1;
+			// the triangles touching the poles would have no area
+			if (i > 0) {
+				snowManIndices.push_back(a);
+				snowManIndices.push_back(c);
+				snowManIndices.push_back(a + 1);
+			}
+			if (i < stacks - 1) {
+				snowManIndices.push_back(a + 1);
+				snowManIndices.push_back(c);
+				snowManIndices.push_back(c + 1);
+			}
+		}
+}
 
-	// Draw Head
-	glTranslatef(0.0f, 1.0f, 0.0f);
-	glutSolidSphere(0.25f, 20, 20);
+// cone along +z like glutSolidCone, with its base at (cx, cy, cz)
+void addCone(float cx, float cy, float cz, float radius, float height,
+	int slices, float r, float g, float b) {
+
+	GLushort base = (GLushort)snowManVertices.size();
+	SnowManVertex apex = { cx, cy, cz + height, r, g, b };
+	SnowManVertex center = { cx, cy, cz, r, g, b };
+
+	snowManVertices.push_back(apex);
+	snowManVertices.push_back(center);
+	for (int j = 0; j < slices; j++) {
+		float theta = 2.0f * 3.14159265f * j / slices;
+		SnowManVertex v = {
+			cx + radius * cosf(theta),
+			cy + radius * sinf(theta),
+			cz, r, g, b };
+		snowManVertices.push_back(v);
+	}
 
-	// Draw Eyes
-	glPushMatrix();
-	glColor3f(0.0f, 0.0f, 0.0f);
-	glTranslatef(0.05f, 0.10f, 0.18f);
-	glutSolidSphere(0.05f, 10, 10);
-	glTranslatef(-0.1f, 0.0f, 0.0f);
-	glutSolidSphere(0.05f, 10, 10);
-	glPopMatrix();
+	for (int j = 0; j < slices; j++) {
+		GLushort a = base + 2 + j;
+		GLushort c = base + 2 + (j + 1) % slices;
+		// side
+		snowManIndices.push_back(a);
+		snowManIndices.push_back(c);
+		snowManIndices.push_back(base);
+		// bottom
+		snowManIndices.push_back(c);
+		snowManIndices.push_back(a);
+		snowManIndices.push_back(base + 1);
+	}
+}
 
-	// Draw Nose
-	glColor3f(1.0f, 0.5f, 0.5f);
-	glRotatef(0.0f, 1.0f, 0.0f, 0.0f);
-	glutSolidCone(0.08f, 0.5f, 10, 2);
+// the shapes and transforms the snowman used to be drawn with, with
+// glutSolidSphere and glutSolidCone
+void bakeSnowMan() {
+
+	snowManVertices.clear();
+	snowManIndices.clear();
+
+	// Body
+	addSphere(0.0f, 0.75f, 0.0f, 0.75f, 20, 20, 1.0f, 1.0f, 1.0f);
+	// Head
+	addSphere(0.0f, 1.75f, 0.0f, 0.25f, 20, 20, 1.0f, 1.0f, 1.0f);
+	// Eyes
+	addSphere(0.05f, 1.85f, 0.18f, 0.05f, 10, 10, 0.0f, 0.0f, 0.0f);
+	addSphere(-0.05f, 1.85f, 0.18f, 0.05f, 10, 10, 0.0f, 0.0f, 0.0f);
+	// Nose
+	addCone(0.0f, 1.75f, 0.0f, 0.08f, 0.5f, 10, 1.0f, 0.5f, 0.5f);
+}
+
+// lays out snowManCount snowmen in a square grid around the origin,
+// the default 36 at the same places as before
+void layoutSnowMen() {
+
+	gridSide = (int)ceil(sqrt((double)snowManCount));
+	snowManPositions.resize(snowManCount * 3);
+
+	for (int n = 0; n < snowManCount; n++) {
+		int i = n / gridSide - gridSide / 2;
+		int j = n % gridSide - gridSide / 2;
+		snowManPositions[n * 3 + 0] = i * snowManSpacing;
+		snowManPositions[n * 3 + 1] = 0.0f;
+		snowManPositions[n * 3 + 2] = j * snowManSpacing;
+	}
+}
+
+const char *snowManVertexShader =
+	"#version 330\n"
+	"layout(location = 0) in vec3 position;\n"
+	"layout(location = 1) in vec3 color;\n"
+	"layout(location = 2) in vec3 offset;\n"
+	"layout(std140) uniform Views\n"
+	"{\n"
+	"	mat4 viewProjection[3];\n"
+	"};\n"
+	"uniform int view;\n"
+	"out vec3 vertexColor;\n"
+	"void main()\n"
+	"{\n"
+	"	vertexColor = color;\n"
+	"	gl_Position = viewProjection[view] * vec4(position + offset, 1.0);\n"
+	"}\n";
+
+const char *snowManFragmentShader =
+	"#version 330\n"
+	"in vec3 vertexColor;\n"
+	"out vec4 fragColor;\n"
+	"void main()\n"
+	"{\n"
+	"	fragColor = vec4(vertexColor, 1.0);\n"
+	"}\n";
+
+GLuint compileShader(GLenum type, const char *source) {
+
+	GLint status;
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status) {
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		fprintf(stderr, "Shader error: %s\n", log);
+	}
+	return shader;
+}
+
+// creates the buffers of the mesh, and the shader and the other buffers
+// when instancing
+void initSnowManMesh() {
+
+	glGenBuffers(1, &mesh.vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, snowManVertices.size() * sizeof(SnowManVertex),
+		&snowManVertices[0], GL_STATIC_DRAW);
+
+	glGenBuffers(1, &mesh.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, snowManIndices.size() * sizeof(GLushort),
+		&snowManIndices[0], GL_STATIC_DRAW);
+
+	if (useInstancing) {
+		GLint status;
+		GLuint vs = compileShader(GL_VERTEX_SHADER, snowManVertexShader);
+		GLuint fs = compileShader(GL_FRAGMENT_SHADER, snowManFragmentShader);
+
+		mesh.program = glCreateProgram();
+		glAttachShader(mesh.program, vs);
+		glAttachShader(mesh.program, fs);
+		glLinkProgram(mesh.program);
+		glDeleteShader(vs);
+		glDeleteShader(fs);
+
+		glGetProgramiv(mesh.program, GL_LINK_STATUS, &status);
+		if (!status) {
+			fprintf(stderr, "Failed to link the snowman shader, not using instancing\n");
+			useInstancing = 0;
+		}
+		else {
+			glUniformBlockBinding(mesh.program,
+				glGetUniformBlockIndex(mesh.program, "Views"), 0);
+			mesh.viewLocation = glGetUniformLocation(mesh.program, "view");
+
+			glGenBuffers(1, &mesh.viewBuffer);
+			glBindBuffer(GL_UNIFORM_BUFFER, mesh.viewBuffer);
+			glBufferData(GL_UNIFORM_BUFFER, 3 * 16 * sizeof(float), NULL, GL_STREAM_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			glGenBuffers(1, &mesh.instanceBuffer);
+		}
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+// plane equations (a, b, c, d) of the view frustum of a projection *
+// modelview matrix, pointing inwards
+void getFrustumPlanes(const float *m, float planes[6][4]) {
+
+	for (int k = 0; k < 3; k++)
+		for (int col = 0; col < 4; col++) {
+			planes[k * 2 + 0][col] = m[col * 4 + 3] + m[col * 4 + k];
+			planes[k * 2 + 1][col] = m[col * 4 + 3] - m[col * 4 + k];
+		}
+
+	for (int k = 0; k < 6; k++) {
+		float length = sqrtf(planes[k][0] * planes[k][0] +
+			planes[k][1] * planes[k][1] + planes[k][2] * planes[k][2]);
+		for (int col = 0; col < 4; col++)
+			planes[k][col] /= length;
+	}
+}
+
+// 0 when the sphere is outside, 1 when it intersects and 2 when it is inside
+int sphereInFrustum(float planes[6][4], float x, float y, float z, float radius) {
+
+	int inside = 2;
+	for (int k = 0; k < 6; k++) {
+		float d = planes[k][0] * x + planes[k][1] * y + planes[k][2] * z + planes[k][3];
+		if (d < -radius)
+			return 0;
+		if (d < radius)
+			inside = 1;
+	}
+	return inside;
+}
+
+// collects the positions of the snowmen inside the view frustum of each
+// view, in one pass over the grid that tests a block of it at a time
+// before the snowmen in it
+void cullSnowMen() {
+
+	float planes[3][6][4];
+	for (int v = 0; v < 3; v++) {
+		getFrustumPlanes(views[v].viewProjection, planes[v]);
+		views[v].visible.clear();
+	}
+
+	for (int bi = 0; bi < gridSide; bi += cullBlockSize)
+		for (int bj = 0; bj < gridSide; bj += cullBlockSize) {
+			int rows = gridSide - bi < cullBlockSize ? gridSide - bi : cullBlockSize;
+			int cols = gridSide - bj < cullBlockSize ? gridSide - bj : cullBlockSize;
+			// bounding sphere of the whole block
+			float x0 = (bi - gridSide / 2) * snowManSpacing;
+			float z0 = (bj - gridSide / 2) * snowManSpacing;
+			float hx = (rows - 1) * snowManSpacing * 0.5f;
+			float hz = (cols - 1) * snowManSpacing * 0.5f;
+			int inside[3] = { 2, 2, 2 };
+			int any = 0;
+
+			for (int v = 0; v < 3; v++) {
+				if (useCulling)
+					inside[v] = sphereInFrustum(planes[v], x0 + hx, snowManCenterY,
+						z0 + hz, sqrtf(hx * hx + hz * hz) + snowManRadius);
+				any |= inside[v];
+			}
+			if (!any)
+				continue;
+
+			for (int i = bi; i < bi + rows; i++)
+				for (int j = bj; j < bj + cols; j++) {
+					int n = i * gridSide + j;
+					const float *position;
+					if (n >= snowManCount)
+						break;
+					position = &snowManPositions[n * 3];
+					for (int v = 0; v < 3; v++) {
+						if (inside[v] == 0)
+							continue;
+						if (inside[v] == 1 && !sphereInFrustum(planes[v], position[0],
+							snowManCenterY, position[2], snowManRadius))
+							continue;
+						views[v].visible.insert(views[v].visible.end(), position, position + 3);
+					}
+				}
+		}
+}
+
+// uploads the matrices of all the views and the snowmen each of them sees,
+// once for the whole frame
+void uploadViews() {
+
+	GLsizeiptr size = 0;
+
+	if (!useInstancing)
+		return;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, mesh.viewBuffer);
+	for (int v = 0; v < 3; v++)
+		glBufferSubData(GL_UNIFORM_BUFFER, v * 16 * sizeof(float),
+			16 * sizeof(float), views[v].viewProjection);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	for (int v = 0; v < 3; v++) {
+		views[v].instanceOffset = size;
+		size += views[v].visible.size() * sizeof(float);
+	}
+	if (size == 0)
+		return;
+
+	// orphan the buffer so that the previous frame can still use it
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.instanceBuffer);
+	if (size > mesh.instanceCapacity)
+		mesh.instanceCapacity = size;
+	glBufferData(GL_ARRAY_BUFFER, mesh.instanceCapacity, NULL, GL_STREAM_DRAW);
+	for (int v = 0; v < 3; v++)
+		if (!views[v].visible.empty())
+			glBufferSubData(GL_ARRAY_BUFFER, views[v].instanceOffset,
+				views[v].visible.size() * sizeof(float), &views[v].visible[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// draws the snowmen seen by a view, with its matrices already loaded
+void drawSnowMen(int v) {
+
+	View *view = &views[v];
+	GLsizei count = (GLsizei)(view->visible.size() / 3);
+
+	if (count == 0)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+
+	if (useInstancing) {
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SnowManVertex), (void *)0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SnowManVertex),
+			(void *)(3 * sizeof(float)));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+
+		// the instances of this view start at its offset in the buffer
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.instanceBuffer);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void *)view->instanceOffset);
+		glEnableVertexAttribArray(2);
+		glVertexAttribDivisor(2, 1);
+
+		glUseProgram(mesh.program);
+		glUniform1i(mesh.viewLocation, v);
+		glBindBufferBase(GL_UNIFORM_BUFFER, 0, mesh.viewBuffer);
+		glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)snowManIndices.size(),
+			GL_UNSIGNED_SHORT, (void *)0, count);
+		glUseProgram(0);
+
+		glVertexAttribDivisor(2, 0);
+		glDisableVertexAttribArray(0);
+		glDisableVertexAttribArray(1);
+		glDisableVertexAttribArray(2);
+	}
+	else {
+		glVertexPointer(3, GL_FLOAT, sizeof(SnowManVertex), (void *)0);
+		glColorPointer(3, GL_FLOAT, sizeof(SnowManVertex), (void *)(3 * sizeof(float)));
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+
+		for (int n = 0; n < count; n++) {
+			const float *position = &view->visible[n * 3];
+			glPushMatrix();
+			glTranslatef(position[0], position[1], position[2]);
+			glDrawElements(GL_TRIANGLES, (GLsizei)snowManIndices.size(),
+				GL_UNSIGNED_SHORT, (void *)0);
+			glPopMatrix();
+		}
 
-	glColor3f(1.0f, 1.0f, 1.0f);
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glDisableClientState(GL_COLOR_ARRAY);
+	}
 
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void renderBitmapString(
@@ -122,11 +601,12 @@ void renderBitmapString(
 	void *font,
 	char *string) {
 
-	char *c;
-	glRasterPos3f(x, y, z);
-	for (c = string; *c != '\0'; c++) {
-		glutBitmapCharacter(font, *c);
-	}
+	// the string is drawn from the glyph atlas of the font in one
+	// draw call, and only laid out again when it changes
+	glPushMatrix();
+	glTranslatef(0.0f, 0.0f, z);
+	text_draw(text_bitmap_font(font), x, y, string);
+	glPopMatrix();
 }
 
 void restorePerspectiveProjection() {
@@ -139,7 +619,7 @@ void restorePerspectiveProjection() {
 	glMatrixMode(GL_MODELVIEW);
 }
 
-void setOrthographicProjection() {
+void setOrthographicProjection(int w1, int h1) {
 
 	// switch to projection mode
 	glMatrixMode(GL_PROJECTION);
@@ -152,7 +632,7 @@ void setOrthographicProjection() {
 	glLoadIdentity();
 
 	// set a 2D orthographic projection
-	gluOrtho2D(0, w, h, 0);
+	gluOrtho2D(0, w1, h1, 0);
 
 	// switch back to modelview mode
 	glMatrixMode(GL_MODELVIEW);
@@ -164,63 +644,81 @@ void computePos(float deltaMove) {
 	z += deltaMove * lz * 0.1f;
 }
 
-// Common Render Items for all subwindows
-void renderScene2() {
+// Common Render Items for all views
+void renderScene2(int v) {
 
-	// Draw ground
+	// Draw ground, large enough for all the snowmen
+	float size = gridSide * snowManSpacing * 0.5f + snowManSpacing;
+	if (size < 100.0f)
+		size = 100.0f;
 
 	glColor3f(0.9f, 0.9f, 0.9f);
 	glBegin(GL_QUADS);
-	glVertex3f(-100.0f, 0.0f, -100.0f);
-	glVertex3f(-100.0f, 0.0f, 100.0f);
-	glVertex3f(100.0f, 0.0f, 100.0f);
-	glVertex3f(100.0f, 0.0f, -100.0f);
+	glVertex3f(-size, 0.0f, -size);
+	glVertex3f(-size, 0.0f, size);
+	glVertex3f(size, 0.0f, size);
+	glVertex3f(size, 0.0f, -size);
 	glEnd();
 
-	// Draw 36 SnowMen
-	for (int i = -3; i < 3; i++)
-		for (int j = -3; j < 3; j++)
-		{
-			glPushMatrix();
-			glTranslatef(i*10.0f, 0.0f, j * 10.0f);
-			drawSnowMan();
-			glPopMatrix();
-		}
+	// Draw the SnowMen
+	drawSnowMen(v);
 }
 
-// Display func for main window
-void renderScene() {
-	glutSetWindow(mainWindow);
-	glClear(GL_COLOR_BUFFER_BIT);
-	glutSwapBuffers();
+// Draw red cone at the location of the main camera
+void renderCamera() {
+
+	glPushMatrix();
+	glColor3f(1.0, 0.0, 0.0);
+	glTranslatef(x, y, z);
+	glRotatef(180 - (angle + deltaAngle)*180.0 / 3.14, 0.0, 1.0, 0.0);
+	glutSolidCone(0.2, 0.8f, 4, 4);
+	glPopMatrix();
 }
 
-// Display func for sub window 1
-void renderScenesw1() {
+// Draws one view into its part of the window
+void renderView(int v) {
 
-	glutSetWindow(subWindow1);
+	View *view = &views[v];
 
+	// the scissor keeps the clear inside the view
+	glViewport(view->x, view->y, view->width, view->height);
+	glScissor(view->x, view->y, view->width, view->height);
+	glClearColor(0.0, 0.0, 0.0, 0.0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glLoadIdentity();
-	gluLookAt(x, y, z,
-		x + lx, y + ly, z + lz,
-		0.0f, 1.0f, 0.0f);
+	glMatrixMode(GL_PROJECTION);
+	glLoadMatrixf(view->projection);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixf(view->modelview);
+
+	// the main camera is seen from the other views
+	if (v != 0)
+		renderCamera();
+
+	renderScene2(v);
 
-	renderScene2();
+	if (v != 0)
+		return;
 
-	// display fps in the top window
+	// display fps in the top view
 	frame++;
 
 	time = glutGet(GLUT_ELAPSED_TIME);
 	if (time - timebase > 1000) {
-		sprintf(s, "Lighthouse3D - FPS:%4.2f",
-			frame*1000.0 / (time - timebase));
+		int drawn = 0;
+		for (int k = 0; k < 3; k++)
+			drawn += (int)(views[k].visible.size() / 3);
+
+		sprintf(s, "Lighthouse3D - FPS:%4.2f  SnowMen:%d  Drawn:%d",
+			frame*1000.0 / (time - timebase), snowManCount, drawn);
+		if (benchmarking)
+			printf("%8d snowmen %8d drawn %8.2f ms per frame\n",
+				snowManCount, drawn, (time - timebase) / (double)frame);
 		timebase = time;
 		frame = 0;
 	}
 
-	setOrthographicProjection();
+	setOrthographicProjection(view->width, view->height);
 
 	glPushMatrix();
 	glLoadIdentity();
@@ -228,58 +726,6 @@ void renderScenesw1() {
 	glPopMatrix();
 
 	restorePerspectiveProjection();
-
-	glutSwapBuffers();
-}
-
-// Display func for sub window 2
-void renderScenesw2() {
-
-	glutSetWindow(subWindow2);
-
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glLoadIdentity();
-	gluLookAt(x, y + 15, z,
-		x, y - 1, z,
-		lx, 0, lz);
-
-	// Draw red cone at the location of the main camera
-	glPushMatrix();
-	glColor3f(1.0, 0.0, 0.0);
-	glTranslatef(x, y, z);
-	glRotatef(180 - (angle + deltaAngle)*180.0 / 3.14, 0.0, 1.0, 0.0);
-	glutSolidCone(0.2, 0.8f, 4, 4);
-	glPopMatrix();
-
-	renderScene2();
-
-	glutSwapBuffers();
-}
-
-// Display func for sub window 3
-void renderScenesw3() {
-
-	glutSetWindow(subWindow3);
-
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glLoadIdentity();
-	gluLookAt(x - lz * 10, y, z + lx * 10,
-		x, y, z,
-		0.0f, 1.0f, 0.0f);
-
-	// Draw red cone at the location of the main camera
-	glPushMatrix();
-	glColor3f(1.0, 0.0, 0.0);
-	glTranslatef(x, y, z);
-	glRotatef(180 - (angle + deltaAngle)*180.0 / 3.14, 0.0, 1.0, 0.0);
-	glutSolidCone(0.2, 0.8f, 4, 4);
-	glPopMatrix();
-
-	renderScene2();
-
-	glutSwapBuffers();
 }
 
 // Global render func
@@ -288,14 +734,25 @@ void renderSceneAll() {
 	// check for keyboard movement
 	if (deltaMove) {
 		computePos(deltaMove);
-		glutSetWindow(mainWindow);
 		glutPostRedisplay();
 	}
 
-	renderScene();
-	renderScenesw1();
-	renderScenesw2();
-	renderScenesw3();
+	// the border between the views
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(0.2, 0.2, 0.2, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// cull and upload once for all the views
+	updateViews();
+	cullSnowMen();
+	uploadViews();
+
+	glEnable(GL_SCISSOR_TEST);
+	for (int v = 0; v < 3; v++)
+		renderView(v);
+	glDisable(GL_SCISSOR_TEST);
+
+	glutSwapBuffers();
 }
 
 // -----------------------------------
@@ -304,10 +761,35 @@ void renderSceneAll() {
 
 void processNormalKeys(unsigned char key, int xx, int yy) {
 
-	if (key == 27) {
+	switch (key) {
+	case 27:
 		glutDestroyWindow(mainWindow);
 		exit(0);
+	// change the number of snowmen
+	case '+':
+		if (snowManCount < 1000000)
+			snowManCount *= 2;
+		layoutSnowMen();
+		printf("%d snowmen\n", snowManCount);
+		break;
+	case '-':
+		if (snowManCount > 1)
+			snowManCount /= 2;
+		layoutSnowMen();
+		printf("%d snowmen\n", snowManCount);
+		break;
+	// toggle view frustum culling
+	case 'c':
+		useCulling = !useCulling;
+		printf("culling %s\n", useCulling ? "on" : "off");
+		break;
+	// redraw all the time and print the frame time every second
+	case 'b':
+		benchmarking = !benchmarking;
+		glutIdleFunc(benchmarking ? renderSceneAll : NULL);
+		break;
 	}
+	glutPostRedisplay();
 }
 
 void pressKey(int key, int xx, int yy) {
@@ -316,7 +798,6 @@ void pressKey(int key, int xx, int yy) {
 	case GLUT_KEY_UP: deltaMove = 0.5f; break;
 	case GLUT_KEY_DOWN: deltaMove = -0.5f; break;
 	}
-	glutSetWindow(mainWindow);
 	glutPostRedisplay();
 
 }
@@ -345,7 +826,6 @@ void mouseMove(int x, int y) {
 		lx = sin(angle + deltaAngle);
 		lz = -cos(angle + deltaAngle);
 
-		glutSetWindow(mainWindow);
 		glutPostRedisplay();
 	}
 }
@@ -391,11 +871,21 @@ int main(int argc, char **argv) {
 
 	// init GLUT and create main window
 	glutInit(&argc, argv);
+
+	// the number of snowmen may be given on the command line
+	if (argc > 1 && atoi(argv[1]) > 0)
+		snowManCount = atoi(argv[1]);
+
 	glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGBA);
 	glutInitWindowPosition(100, 100);
 	glutInitWindowSize(800, 800);
 	mainWindow = glutCreateWindow("Lighthouse3D - GLUT Tutorial");
 
+	glewInit();
+	useInstancing = GLEW_VERSION_3_3;
+	bakeSnowMan();
+	layoutSnowMen();
+
 	// callbacks for main window
 	glutDisplayFunc(renderSceneAll);
 	glutReshapeFunc(changeSize);
@@ -403,19 +893,7 @@ int main(int argc, char **argv) {
 	// Removing the idle function to save CPU and GPU
 	//glutIdleFunc(renderSceneAll);
 	init();
-
-	// sub windows
-	subWindow1 = glutCreateSubWindow(mainWindow, border, border, w - 2 * border, h / 2 - border * 3 / 2);
-	glutDisplayFunc(renderScenesw1);
-	init();
-
-	subWindow2 = glutCreateSubWindow(mainWindow, border, (h + border) / 2, w / 2 - border * 3 / 2, h / 2 - border * 3 / 2);
-	glutDisplayFunc(renderScenesw2);
-	init();
-
-	subWindow3 = glutCreateSubWindow(mainWindow, (w + border) / 2, (h + border) / 2, w / 2 - border * 3 / 2, h / 2 - border * 3 / 2);
-	glutDisplayFunc(renderScenesw3);
-	init();
+	initSnowManMesh();
 
 	// enter GLUT event processing cycle
 	glutMainLoop();
@@ -1,38 +1,467 @@
+#include<gl/glew.h>
 #include<gl/glut.h>
 #include<stdio.h>
-const GLint pickSize = 32;
+#include<stdlib.h>
+#include<stddef.h>
+#include<vector>
+#include<algorithm>
+#include<chrono>
+// ѡĴСǰgluPickMatrix10*10ͬ
+const GLint pickSize = 10;
 int winWidth = 400, winHeight = 300;
+
+// ʰȡķ
+// ǰglRenderMode(GL_SELECT)»һʰȡģѡģʽ
+// ͼԪһͷǳڰÿͼԪıŻƵһɫID
+// ʱֻ첽ΧһС飻֧OpenGL 3.2ʱCPUðΧв(BVH)
+enum { PICK_ID_BUFFER, PICK_BVH, PICK_SELECT, PICK_METHOD_COUNT };
+const char* pickMethodNames[PICK_METHOD_COUNT] = { "ID", "BVH", "GL_SELECT" };
+int pickMethod = PICK_BVH;
+bool hasIdBuffer = false;
+
+// еľͼԪ󻭵棬Ŵ1ʼ0ʾ
+struct PickObject {
+	GLfloat x0, y0, x1, y1;
+	GLubyte color[3];
+};
+std::vector<PickObject> objects;
+// õĶ飬ÿ4
+struct PickVertex {
+	GLfloat x, y;
+	GLubyte color[4];
+	GLuint id;
+};
+std::vector<PickVertex> vertices;
+
 void Initial() {
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 }
+
+// objectsɶ
+void BuildVertices() {
+	vertices.resize(objects.size() * 4);
+	for (size_t i = 0;i < objects.size();i++) {
+		const PickObject& o = objects[i];
+		const GLfloat xs[4] = { o.x0, o.x1, o.x1, o.x0 };
+		const GLfloat ys[4] = { o.y0, o.y0, o.y1, o.y1 };
+		for (int k = 0;k < 4;k++) {
+			PickVertex& v = vertices[i * 4 + k];
+			v.x = xs[k];
+			v.y = ys[k];
+			v.color[0] = o.color[0];
+			v.color[1] = o.color[1];
+			v.color[2] = o.color[2];
+			v.color[3] = 255;
+			v.id = (GLuint)i + 1;
+		}
+	}
+}
+
+void AddRect(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, GLubyte r, GLubyte g, GLubyte b) {
+	PickObject o = { x0, y0, x1, y1, { r, g, b } };
+	objects.push_back(o);
+}
+
+// ԭ
+void DefaultScene() {
+	objects.clear();
+	AddRect(60.0f, 50.0f, 150.0f, 150.0f, 255, 0, 0);
+	AddRect(230.0f, 50.0f, 330.0f, 150.0f, 0, 255, 0);
+	AddRect(140.0f, 140.0f, 240.0f, 240.0f, 0, 0, 255);
+}
+
+// 򵥵֤ͬÿɵĳͬ
+unsigned int randomState = 1;
+int Random(int n) {
+	randomState = randomState * 1103515245 + 12345;
+	return (int)((randomState >> 16) & 0x7fff) % n;
+}
+
+// ڴڷΧcountΣȡ߽粻
+void RandomScene(int count) {
+	objects.clear();
+	randomState = 1;
+	for (int i = 0;i < count;i++) {
+		GLfloat w = (GLfloat)(4 + Random(24));
+		GLfloat h = (GLfloat)(4 + Random(24));
+		GLfloat x = (GLfloat)Random(winWidth);
+		GLfloat y = (GLfloat)Random(winHeight);
+		AddRect(x, y, x + w, y + h,
+			(GLubyte)Random(256), (GLubyte)Random(256), (GLubyte)Random(256));
+	}
+}
+
+// öƳ
+void DrawScene() {
+	if (vertices.empty())return;
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(PickVertex), &vertices[0].x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(PickVertex), vertices[0].color);
+	glDrawArrays(GL_QUADS, 0, (GLsizei)vertices.size());
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+}
+
 // ָģʽƾζ
+// ѡģʽÿԼıΪ
 void DrawRect(GLenum mode) {
-	if (mode == GL_SELECT)glPushName(1);
-	glColor3f(1.0f, 0.0f, 0.0f);
-	glRectf(60.0f, 50.0f, 150.0f, 150.0f);
-	if (mode == GL_SELECT)glPushName(2);
-	glColor3f(0.0f, 1.0f, 0.0f);
-	glRectf(230.0f, 50.0f, 330.0f, 150.0f);
-	if(mode == GL_SELECT)glPushName(3);
-	glColor3f(0.0f, 0.0f, 1.0f);
-	glRectf(140.0f, 140.0f, 240.0f, 240.0f);
-}
-void ProcessPicks(GLint nPicks, GLuint pickBuffer[]) {
-	GLint i;
-	GLuint name, *ptr;
-	printf("ѡеĿΪ%d\n", nPicks);
-	ptr = pickBuffer;
-	for (i = 0;i < nPicks;i++) {
-		name = *ptr;
-		ptr += 3;
-		ptr += name - 1;
-		if (*ptr == 1)printf("ѡ˺ɫͼԪ\n");
-		if (*ptr == 2)printf("ѡɫͼԪ\n");
-		if (*ptr == 3)printf("ѡɫͼԪ\n");
-		ptr++;
+	if (mode != GL_SELECT) {
+		DrawScene();
+		return;
 	}
+	glPushName(0);
+	for (size_t i = 0;i < objects.size();i++) {
+		const PickObject& o = objects[i];
+		glLoadName((GLuint)i + 1);
+		glRectf(o.x0, o.y0, o.x1, o.y1);
+	}
+	glPopName();
+}
+
+// ʰȡidΪѡͼԪı
+void ProcessPick(GLuint id, double ms) {
+	printf("%sʰȡʱ%.3f\n", pickMethodNames[pickMethod], ms);
+	if (id == 0)printf("ûѡͼԪ\n");
+	else if (objects.size() == 3 && id == 1)printf("ѡ˺ɫͼԪ\n");
+	else if (objects.size() == 3 && id == 2)printf("ѡɫͼԪ\n");
+	else if (objects.size() == 3 && id == 3)printf("ѡɫͼԪ\n");
+	else printf("ѡ˵%uͼԪ\n", id);
 	printf("\n\n");
 }
+
+// ѡΪĵpickSize*pickSizeأԭ½
+struct PickRegion {
+	GLint x, y, width, height;
+};
+
+PickRegion GetPickRegion(GLint xMouse, GLint yMouse) {
+	PickRegion r;
+	GLint x0 = xMouse - pickSize / 2;
+	GLint y0 = (winHeight - 1 - yMouse) - pickSize / 2;
+	GLint x1 = x0 + pickSize, y1 = y0 + pickSize;
+	if (x0 < 0)x0 = 0;
+	if (y0 < 0)y0 = 0;
+	if (x1 > winWidth)x1 = winWidth;
+	if (y1 > winHeight)y1 = winHeight;
+	r.x = x0;
+	r.y = y0;
+	r.width = x1 > x0 ? x1 - x0 : 0;
+	r.height = y1 > y0 ? y1 - y0 : 0;
+	return r;
+}
+
+double Milliseconds(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+}
+
+//--------------------------------------------------------------------
+// GL_SELECTʰȡڱȽ
+//--------------------------------------------------------------------
+GLuint PickSelect(PickRegion r) {
+	GLint nPicks, vp[4], i;
+	GLuint id = 0, *ptr;
+	// ÿм¼СȡȺһ
+	std::vector<GLuint> pickBuffer(objects.size() * 4 + 4);
+	glSelectBuffer((GLsizei)pickBuffer.size(), &pickBuffer[0]);
+	glRenderMode(GL_SELECT);
+	glInitNames();
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glGetIntegerv(GL_VIEWPORT, vp);
+	// ѡ
+	gluPickMatrix(r.x + r.width / 2.0, r.y + r.height / 2.0, r.width, r.height, vp);
+	gluOrtho2D(0.0, winWidth, 0.0, winHeight);
+	DrawRect(GL_SELECT);
+	// ָͶӰ任
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glFlush();
+	// ѡ񼯣ȡģҲ
+	nPicks = glRenderMode(GL_RENDER);
+	ptr = &pickBuffer[0];
+	for (i = 0;i < nPicks;i++) {
+		GLuint names = ptr[0];
+		if (names > 0 && ptr[3] > id)id = ptr[3];
+		ptr += 3 + names;
+	}
+	return id;
+}
+
+//--------------------------------------------------------------------
+// IDʰȡ
+// 仯򴰿ڴС仯ʱÿεıŻGL_R32UIɫ
+// ʱѡػвһfence
+// ڿлصвѯfenceGPUԺӳ䣬̲߳õȴ
+//--------------------------------------------------------------------
+const char* idVertexShader =
+	"#version 130\n"
+	"in vec2 position;\n"
+	"in uint objectId;\n"
+	"uniform vec2 viewSize;\n"
+	"flat out uint id;\n"
+	"void main()\n"
+	"{\n"
+	"	id = objectId;\n"
+	"	gl_Position = vec4(position * 2.0 / viewSize - 1.0, 0.0, 1.0);\n"
+	"}\n";
+const char* idFragmentShader =
+	"#version 130\n"
+	"flat in uint id;\n"
+	"out uvec4 fragId;\n"
+	"void main()\n"
+	"{\n"
+	"	fragId = uvec4(id, 0u, 0u, 0u);\n"
+	"}\n";
+
+GLuint idFramebuffer, idColorbuffer, idProgram, idVertexBuffer, idPixelBuffer;
+GLint idViewSizeLocation;
+GLint idWidth, idHeight;
+bool idDirty = true;
+// ڵȴĶȡ
+GLsync idFence = 0;
+PickRegion idRegion;
+std::chrono::high_resolution_clock::time_point idStart;
+
+GLuint CompileShader(GLenum type, const char* source) {
+	GLint status;
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status) {
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		printf("ɫ%s\n", log);
+	}
+	return shader;
+}
+
+bool InitIdBuffer() {
+	GLint status;
+	GLuint vs = CompileShader(GL_VERTEX_SHADER, idVertexShader);
+	GLuint fs = CompileShader(GL_FRAGMENT_SHADER, idFragmentShader);
+	idProgram = glCreateProgram();
+	glAttachShader(idProgram, vs);
+	glAttachShader(idProgram, fs);
+	glBindAttribLocation(idProgram, 0, "position");
+	glBindAttribLocation(idProgram, 1, "objectId");
+	glBindFragDataLocation(idProgram, 0, "fragId");
+	glLinkProgram(idProgram);
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+	glGetProgramiv(idProgram, GL_LINK_STATUS, &status);
+	if (!status)return false;
+	idViewSizeLocation = glGetUniformLocation(idProgram, "viewSize");
+
+	glGenFramebuffers(1, &idFramebuffer);
+	glGenRenderbuffers(1, &idColorbuffer);
+	glGenBuffers(1, &idVertexBuffer);
+	glGenBuffers(1, &idPixelBuffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, idPixelBuffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, pickSize * pickSize * sizeof(GLuint), NULL, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return true;
+}
+
+// 򴰿ڴСıԺ»ID
+void RenderIdBuffer() {
+	const GLuint zero[4] = { 0, 0, 0, 0 };
+	if (idWidth != winWidth || idHeight != winHeight) {
+		idWidth = winWidth;
+		idHeight = winHeight;
+		glBindRenderbuffer(GL_RENDERBUFFER, idColorbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_R32UI, idWidth, idHeight);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, idFramebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, idColorbuffer);
+	}
+	else glBindFramebuffer(GL_FRAMEBUFFER, idFramebuffer);
+
+	glViewport(0, 0, idWidth, idHeight);
+	glClearBufferuiv(GL_COLOR, 0, zero);
+	if (!vertices.empty()) {
+		glBindBuffer(GL_ARRAY_BUFFER, idVertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(PickVertex), &vertices[0], GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(PickVertex), (void*)offsetof(PickVertex, x));
+		glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(PickVertex), (void*)offsetof(PickVertex, id));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glUseProgram(idProgram);
+		glUniform2f(idViewSizeLocation, (GLfloat)idWidth, (GLfloat)idHeight);
+		glDrawArrays(GL_QUADS, 0, (GLsizei)vertices.size());
+		glUseProgram(0);
+		glDisableVertexAttribArray(0);
+		glDisableVertexAttribArray(1);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, winWidth, winHeight);
+	idDirty = false;
+}
+
+// ȡѡ
+void RequestIdPick(PickRegion r) {
+	idStart = std::chrono::high_resolution_clock::now();
+	if (idDirty)RenderIdBuffer();
+	if (idFence)glDeleteSync(idFence);
+	idRegion = r;
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, idFramebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, idPixelBuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(r.x, r.y, r.width, r.height, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	// glFlush֤fence͵GPUѯԶȲ
+	idFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+}
+
+// ȡɺȡýδʱfalse
+// waitΪfalseʱֻѯȴ
+bool ResolveIdPick(bool wait, GLuint* id) {
+	GLenum result;
+	const GLuint* ids;
+	if (!idFence)return false;
+	result = glClientWaitSync(idFence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000 : 0);
+	if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)return false;
+	glDeleteSync(idFence);
+	idFence = 0;
+
+	*id = 0;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, idPixelBuffer);
+	ids = (const GLuint*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (ids) {
+		// ľѡͼԪ
+		for (GLint i = 0;i < idRegion.width * idRegion.height;i++)
+			if (ids[i] > *id)*id = ids[i];
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return true;
+}
+
+// ʱȡǷ
+void PollIdPick() {
+	GLuint id;
+	if (ResolveIdPick(false, &id)) {
+		glutIdleFunc(NULL);
+		ProcessPick(id, Milliseconds(idStart));
+	}
+}
+
+//--------------------------------------------------------------------
+// BVHʰȡ
+// ͶӰ£صߺ;ཻھ
+// 󽻱ƽϲҺѡཻľ
+// ÿ¼ıţѾҵıС
+//--------------------------------------------------------------------
+struct BVHNode {
+	GLfloat x0, y0, x1, y1;
+	GLuint maxId;
+	// Ҷ㣺firstcountʾbvhIndicesеһΣڲ㣺countΪ0first
+	GLuint first, count;
+};
+std::vector<BVHNode> bvhNodes;
+std::vector<GLuint> bvhIndices;
+bool bvhDirty = true;
+const GLuint bvhLeafSize = 4;
+
+void BoundNode(BVHNode& node, GLuint begin, GLuint end) {
+	node.x0 = node.y0 = 1e30f;
+	node.x1 = node.y1 = -1e30f;
+	node.maxId = 0;
+	for (GLuint i = begin;i < end;i++) {
+		const PickObject& o = objects[bvhIndices[i]];
+		node.x0 = std::min(node.x0, o.x0);
+		node.y0 = std::min(node.y0, o.y0);
+		node.x1 = std::max(node.x1, o.x1);
+		node.y1 = std::max(node.y1, o.y1);
+		node.maxId = std::max(node.maxId, bvhIndices[i] + 1);
+	}
+}
+
+// Χнϳһе㴦ֳ
+void BuildNode(GLuint nodeIndex, GLuint begin, GLuint end) {
+	BVHNode node;
+	BoundNode(node, begin, end);
+	if (end - begin <= bvhLeafSize) {
+		node.first = begin;
+		node.count = end - begin;
+		bvhNodes[nodeIndex] = node;
+		return;
+	}
+	bool alongX = node.x1 - node.x0 > node.y1 - node.y0;
+	GLuint middle = (begin + end) / 2;
+	std::nth_element(bvhIndices.begin() + begin, bvhIndices.begin() + middle, bvhIndices.begin() + end,
+		[alongX](GLuint a, GLuint b) {
+		return alongX ? objects[a].x0 + objects[a].x1 < objects[b].x0 + objects[b].x1
+			: objects[a].y0 + objects[a].y1 < objects[b].y0 + objects[b].y1;
+	});
+	node.first = (GLuint)bvhNodes.size();
+	node.count = 0;
+	bvhNodes[nodeIndex] = node;
+	bvhNodes.resize(bvhNodes.size() + 2);
+	BuildNode(node.first, begin, middle);
+	BuildNode(node.first + 1, middle, end);
+}
+
+void BuildBVH() {
+	bvhNodes.clear();
+	bvhIndices.resize(objects.size());
+	for (size_t i = 0;i < objects.size();i++)bvhIndices[i] = (GLuint)i;
+	bvhNodes.resize(1);
+	if (!objects.empty())BuildNode(0, 0, (GLuint)objects.size());
+	else bvhNodes[0].count = bvhNodes[0].first = bvhNodes[0].maxId = 0;
+	bvhDirty = false;
+}
+
+// θѡеĳ
+bool Overlaps(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, PickRegion r) {
+	return x0 <= r.x + r.width - 0.5f && x1 > r.x + 0.5f &&
+		y0 <= r.y + r.height - 0.5f && y1 > r.y + 0.5f;
+}
+
+GLuint PickBVH(PickRegion r) {
+	GLuint id = 0;
+	GLuint stack[64];
+	int top = 0;
+	if (bvhDirty)BuildBVH();
+	if (r.width == 0 || r.height == 0 || objects.empty())return 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const BVHNode& node = bvhNodes[stack[--top]];
+		if (node.maxId <= id || !Overlaps(node.x0, node.y0, node.x1, node.y1, r))continue;
+		if (node.count > 0) {
+			for (GLuint i = node.first;i < node.first + node.count;i++) {
+				const PickObject& o = objects[bvhIndices[i]];
+				if (bvhIndices[i] + 1 > id && Overlaps(o.x0, o.y0, o.x1, o.y1, r))id = bvhIndices[i] + 1;
+			}
+		}
+		else {
+			// ȷʱſܸĺӣԱ㾡
+			GLuint a = node.first, b = node.first + 1;
+			if (bvhNodes[a].maxId > bvhNodes[b].maxId)std::swap(a, b);
+			stack[top++] = a;
+			stack[top++] = b;
+		}
+	}
+	return id;
+}
+
+//--------------------------------------------------------------------
+
+// ı
+void SceneChanged() {
+	BuildVertices();
+	idDirty = true;
+	bvhDirty = true;
+	glutPostRedisplay();
+}
+
 void ChangeSize(int w, int h) {
 	winWidth = w;
 	winHeight = h;
@@ -40,6 +469,7 @@ void ChangeSize(int w, int h) {
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	gluOrtho2D(0.0, winWidth, 0.0, winHeight);
+	idDirty = true;
 }
 void Display() {
 	glClear(GL_COLOR_BUFFER_BIT);
@@ -47,28 +477,102 @@ void Display() {
 	glFlush();
 }
 void MousePlot(GLint button, GLint action, GLint xMouse, GLint yMouse) {
-	GLuint pickBuffer[pickSize];
-	GLint nPicks, vp[4];
 	if (button == GLUT_LEFT_BUTTON&&action == GLUT_DOWN) {
-		glSelectBuffer(pickSize, pickBuffer);
-		glRenderMode(GL_SELECT);
-		glInitNames();
-		glMatrixMode(GL_PROJECTION);
-		glPushMatrix();
-		glLoadIdentity();
-		glGetIntegerv(GL_VIEWPORT, vp);
-		// һ10*10ѡ
-		gluPickMatrix(GLdouble(xMouse), GLdouble(vp[3] - yMouse), 10.0, 10.0, vp);
-		gluOrtho2D(0.0, winWidth, 0.0, winHeight);
-		DrawRect(GL_SELECT);
-		// ָͶӰ任
-		glMatrixMode(GL_PROJECTION);
-		glPopMatrix();
-		glFlush();
-		// ѡ񼯲
-		nPicks = glRenderMode(GL_RENDER);
-		ProcessPicks(nPicks, pickBuffer);
-		glutPostRedisplay();
+		PickRegion r = GetPickRegion(xMouse, yMouse);
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		GLuint id;
+		switch (pickMethod) {
+		case PICK_ID_BUFFER:
+			// ڿлصȡ
+			RequestIdPick(r);
+			glutIdleFunc(PollIdPick);
+			return;
+		case PICK_BVH:
+			id = PickBVH(r);
+			break;
+		default:
+			id = PickSelect(r);
+			glutPostRedisplay();
+			break;
+		}
+		ProcessPick(id, Milliseconds(start));
+	}
+}
+
+// 10000ϵͼԪбȽַʰȡӳ٣Ƿһ
+void Benchmark() {
+	const int counts[] = { 10000, 30000, 100000 };
+	const int picks = 200;
+	std::vector<PickObject> saved = objects;
+	printf("%8s %10s %14s %14s %14s %8s\n", "ͼԪ", "BVH", "GL_SELECT", "ID", "BVH", "һ");
+	for (int c = 0;c < 3;c++) {
+		std::vector<PickRegion> regions;
+		std::vector<GLuint> expected;
+		double buildMs, selectMs = 0.0, idMs = 0.0, bvhMs;
+		int mismatches = 0, selectPicks;
+		std::chrono::high_resolution_clock::time_point start;
+
+		RandomScene(counts[c]);
+		BuildVertices();
+		idDirty = true;
+		for (int i = 0;i < picks;i++)
+			regions.push_back(GetPickRegion(Random(winWidth), Random(winHeight)));
+
+		start = std::chrono::high_resolution_clock::now();
+		BuildBVH();
+		buildMs = Milliseconds(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0;i < picks;i++)expected.push_back(PickBVH(regions[i]));
+		bvhMs = Milliseconds(start) / picks;
+
+		// ѡģʽֻ⼸
+		selectPicks = 10;
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0;i < selectPicks;i++)
+			if (PickSelect(regions[i]) != expected[i])mismatches++;
+		selectMs = Milliseconds(start) / selectPicks;
+
+		if (hasIdBuffer) {
+			// һʰȡID
+			for (int i = 0;i < picks;i++) {
+				GLuint id = 0;
+				start = std::chrono::high_resolution_clock::now();
+				RequestIdPick(regions[i]);
+				ResolveIdPick(true, &id);
+				idMs += Milliseconds(start);
+				if (id != expected[i])mismatches++;
+			}
+			idMs /= picks;
+			printf("%8d %8.2fms %12.3fms %12.3fms %12.4fms %8d\n", counts[c], buildMs, selectMs, idMs, bvhMs, mismatches);
+		}
+		else printf("%8d %8.2fms %12.3fms %14s %12.4fms %8d\n", counts[c], buildMs, selectMs, "֧", bvhMs, mismatches);
+	}
+	objects = saved;
+	SceneChanged();
+}
+
+void Keyboard(unsigned char key, int x, int y) {
+	switch (key) {
+	case 'm':
+		// лʰȡ
+		do {
+			pickMethod = (pickMethod + 1) % PICK_METHOD_COUNT;
+		} while (pickMethod == PICK_ID_BUFFER && !hasIdBuffer);
+		printf("ʰȡ%s\n", pickMethodNames[pickMethod]);
+		break;
+	case 'n':
+		// ԭκ10000֮л
+		if (objects.size() == 3)RandomScene(10000);
+		else DefaultScene();
+		printf("ͼԪ%d\n", (int)objects.size());
+		SceneChanged();
+		break;
+	case 'b':
+		Benchmark();
+		break;
+	case 27:
+		exit(0);
 	}
 }
 int main(int argc, char** argv) {
@@ -80,7 +584,15 @@ int main(int argc, char** argv) {
 	glutDisplayFunc(Display);
 	glutReshapeFunc(ChangeSize);
 	glutMouseFunc(MousePlot);
+	glutKeyboardFunc(Keyboard);
 	Initial();
+	glewInit();
+	// ɫҪOpenGL 3.0fenceҪ3.2
+	hasIdBuffer = GLEW_VERSION_3_2 && InitIdBuffer();
+	if (hasIdBuffer)pickMethod = PICK_ID_BUFFER;
+	printf("ʰȡ%smлnлbȽʰȡӳ\n", pickMethodNames[pickMethod]);
+	DefaultScene();
+	SceneChanged();
 	glutMainLoop();
 	return 0;
-}
\ No newline at end of file
+}
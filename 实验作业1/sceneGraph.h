@@ -0,0 +1,568 @@
+/*****************************************************************************
+FILE : sceneGraph.h
+NOTE : ģʽͼ, ҵ
+*****************************************************************************/
+// ֻ̬ڽͼʱһ, 任ڽڵϵ, ɫ()
+// һ㻺; ÿֻ֡¶ڵ(ֱ, , Ļ)ľɫ.
+// ͼдģʽһ: sgPushMatrix, sgTranslatef, sgColor3f, sgCube...
+// , ʮ GLUT ʾб.
+// ϸֻĽڵ sgBeginRebuild/sgEndRebuild ؽ, ֻڶ
+// еһ.
+//  GLEW  GLUT ֮,  glewInit ֮ͼ.
+
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <windows.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#define SG_STRIDE 6				// ÿ: λ xyz,  xyz
+
+struct SgMatrix {
+	GLfloat m[16];				// ,  OpenGL ͬ
+};
+
+struct SgBatch {
+	GLfloat color[3];
+	GLint first;
+	GLsizei count;
+	std::vector<GLfloat> data;	// ͼʱݴ, Ž㻺
+};
+
+struct SgListItem {
+	GLuint list;
+	SgMatrix matrix;
+	GLfloat color[3];
+};
+
+struct SgNode {
+	int parent;					// ڵΪ -1
+	SgMatrix base;				// ͼʱڵеĵǰ
+	SgMatrix anim;				// ÿ֡ sgAnimate 
+	SgMatrix world;				// Ըڵ
+	std::vector<SgBatch> batches;
+	std::vector<SgListItem> lists;
+	GLint first;				// ڶ㻺еķΧ
+	GLsizei capacity;
+	GLsizei reserve;			//  sgReserve 
+};
+
+struct SceneGraph {
+	std::vector<SgNode> nodes;
+	std::vector<GLfloat> vertices;
+	GLuint buffer;
+	bool useBuffer;
+
+	// ͼ״̬
+	std::vector<SgMatrix> stack;
+	std::vector<int> current;		// ڵջ
+	std::vector<size_t> depth;		// ڵʱջ
+	GLfloat color[3];
+};
+
+static void sgIdentity(SgMatrix *a)
+{
+	memset(a->m, 0, sizeof(a->m));
+	a->m[0] = a->m[5] = a->m[10] = a->m[15] = 1.0f;
+}
+
+// r = a * b
+static void sgMultiply(SgMatrix *r, const SgMatrix *a, const SgMatrix *b)
+{
+	SgMatrix t;
+	for (int c = 0; c < 4; c++)
+		for (int i = 0; i < 4; i++)
+			t.m[c * 4 + i] = a->m[i] * b->m[c * 4] + a->m[4 + i] * b->m[c * 4 + 1] +
+				a->m[8 + i] * b->m[c * 4 + 2] + a->m[12 + i] * b->m[c * 4 + 3];
+	*r = t;
+}
+
+//  glTranslatef, glRotatef, glScalef ͬ, ҳ˵ a 
+static void sgTranslate(SgMatrix *a, GLfloat x, GLfloat y, GLfloat z)
+{
+	SgMatrix t;
+	sgIdentity(&t);
+	t.m[12] = x; t.m[13] = y; t.m[14] = z;
+	sgMultiply(a, a, &t);
+}
+
+static void sgRotate(SgMatrix *a, GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
+{
+	GLfloat l = sqrtf(x * x + y * y + z * z);
+	GLfloat r = angle * 3.14159265f / 180.0f, c = cosf(r), s = sinf(r);
+	SgMatrix t;
+	if (l == 0.0f)
+		return;
+	x /= l; y /= l; z /= l;
+	sgIdentity(&t);
+	t.m[0] = x * x * (1 - c) + c;     t.m[4] = x * y * (1 - c) - z * s; t.m[8] = x * z * (1 - c) + y * s;
+	t.m[1] = y * x * (1 - c) + z * s; t.m[5] = y * y * (1 - c) + c;     t.m[9] = y * z * (1 - c) - x * s;
+	t.m[2] = x * z * (1 - c) - y * s; t.m[6] = y * z * (1 - c) + x * s; t.m[10] = z * z * (1 - c) + c;
+	sgMultiply(a, a, &t);
+}
+
+static void sgScale(SgMatrix *a, GLfloat x, GLfloat y, GLfloat z)
+{
+	for (int i = 0; i < 4; i++) {
+		a->m[i] *= x;
+		a->m[4 + i] *= y;
+		a->m[8 + i] *= z;
+	}
+}
+
+// ͼ
+
+static void sgBegin(SceneGraph *s)
+{
+	SgNode root;
+	SgMatrix identity;
+
+	sgIdentity(&identity);
+	root.parent = -1;
+	root.base = root.anim = root.world = identity;
+	root.first = root.capacity = root.reserve = 0;
+	s->nodes.clear();
+	s->nodes.push_back(root);
+	s->stack.assign(1, identity);
+	s->current.assign(1, 0);
+	s->depth.clear();
+	s->color[0] = s->color[1] = s->color[2] = 1.0f;
+}
+
+static void sgPushMatrix(SceneGraph *s) { s->stack.push_back(s->stack.back()); }
+static void sgPopMatrix(SceneGraph *s) { s->stack.pop_back(); }
+static void sgTranslatef(SceneGraph *s, GLfloat x, GLfloat y, GLfloat z) { sgTranslate(&s->stack.back(), x, y, z); }
+static void sgRotatef(SceneGraph *s, GLfloat a, GLfloat x, GLfloat y, GLfloat z) { sgRotate(&s->stack.back(), a, x, y, z); }
+static void sgScalef(SceneGraph *s, GLfloat x, GLfloat y, GLfloat z) { sgScale(&s->stack.back(), x, y, z); }
+
+static void sgColor3f(SceneGraph *s, GLfloat r, GLfloat g, GLfloat b)
+{
+	s->color[0] = r; s->color[1] = g; s->color[2] = b;
+}
+
+// ڵǰλÿʼһڵ, ֮嶼, ֱ sgEndNode
+static int sgBeginNode(SceneGraph *s)
+{
+	SgNode node;
+	SgMatrix identity;
+
+	sgIdentity(&identity);
+	node.parent = s->current.back();
+	node.base = s->stack.back();
+	node.anim = node.world = identity;
+	node.first = node.capacity = node.reserve = 0;
+	s->nodes.push_back(node);
+	s->current.push_back((int)s->nodes.size() - 1);
+	s->depth.push_back(s->stack.size());
+	s->stack.push_back(identity);
+	return (int)s->nodes.size() - 1;
+}
+
+// Ϊǰڵڶ㻺Ԥ count , ؽʱͲ
+static void sgReserve(SceneGraph *s, int count)
+{
+	s->nodes[s->current.back()].reserve = count;
+}
+
+static void sgEndNode(SceneGraph *s)
+{
+	s->stack.resize(s->depth.back());
+	s->depth.pop_back();
+	s->current.pop_back();
+}
+
+// һڵϵеĶӵǰɫ
+static void sgVertex(SceneGraph *s, GLfloat x, GLfloat y, GLfloat z,
+	GLfloat nx, GLfloat ny, GLfloat nz)
+{
+	std::vector<SgBatch> &batches = s->nodes[s->current.back()].batches;
+	const GLfloat *m = s->stack.back().m;
+	size_t i;
+
+	for (i = 0; i < batches.size(); i++)
+		if (!memcmp(batches[i].color, s->color, sizeof(s->color)))
+			break;
+	if (i == batches.size()) {
+		batches.push_back(SgBatch());
+		memcpy(batches[i].color, s->color, sizeof(s->color));
+	}
+
+	//  3x3 ֵתñ任, ʽ, ʡȥʽ
+	GLfloat c[9] = {
+		m[5] * m[10] - m[6] * m[9], m[6] * m[8] - m[4] * m[10], m[4] * m[9] - m[5] * m[8],
+		m[2] * m[9] - m[1] * m[10], m[0] * m[10] - m[2] * m[8], m[1] * m[8] - m[0] * m[9],
+		m[1] * m[6] - m[2] * m[5], m[2] * m[4] - m[0] * m[6], m[0] * m[5] - m[1] * m[4]
+	};
+	GLfloat n[3] = {
+		c[0] * nx + c[3] * ny + c[6] * nz,
+		c[1] * nx + c[4] * ny + c[7] * nz,
+		c[2] * nx + c[5] * ny + c[8] * nz
+	};
+	GLfloat l = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	if (m[0] * c[0] + m[1] * c[1] + m[2] * c[2] < 0)
+		l = -l;					// 任
+	if (l == 0.0f)
+		l = 1.0f;
+
+	GLfloat v[SG_STRIDE] = {
+		m[0] * x + m[4] * y + m[8] * z + m[12],
+		m[1] * x + m[5] * y + m[9] * z + m[13],
+		m[2] * x + m[6] * y + m[10] * z + m[14],
+		n[0] / l, n[1] / l, n[2] / l
+	};
+	batches[i].data.insert(batches[i].data.end(), v, v + SG_STRIDE);
+}
+
+// ı, normal Ϊ NULL ʱʱ붥˳
+static void sgQuad(SceneGraph *s, const GLfloat *normal, const GLfloat *v)
+{
+	static const int order[6] = { 0, 1, 2, 0, 2, 3 };
+	GLfloat n[3];
+
+	if (normal) {
+		memcpy(n, normal, sizeof(n));
+	}
+	else {
+		GLfloat a[3] = { v[3] - v[0], v[4] - v[1], v[5] - v[2] };
+		GLfloat b[3] = { v[6] - v[0], v[7] - v[1], v[8] - v[2] };
+		n[0] = a[1] * b[2] - a[2] * b[1];
+		n[1] = a[2] * b[0] - a[0] * b[2];
+		n[2] = a[0] * b[1] - a[1] * b[0];
+	}
+	for (int i = 0; i < 6; i++)
+		sgVertex(s, v[order[i] * 3], v[order[i] * 3 + 1], v[order[i] * 3 + 2], n[0], n[1], n[2]);
+}
+
+//  glutSolidCube ͬ
+static void sgCube(SceneGraph *s, GLfloat size)
+{
+	static const GLfloat normals[6][3] = {
+		{ -1, 0, 0 }, { 0, 1, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+	};
+	static const int faces[6][4] = {
+		{ 0, 1, 2, 3 }, { 3, 2, 6, 7 }, { 7, 6, 5, 4 },
+		{ 4, 5, 1, 0 }, { 5, 6, 2, 1 }, { 7, 4, 0, 3 }
+	};
+	GLfloat corners[8][3], v[12];
+	int i, j;
+
+	for (i = 0; i < 8; i++) {
+		corners[i][0] = (i == 0 || i == 1 || i == 2 || i == 3) ? -size / 2 : size / 2;
+		corners[i][1] = (i == 0 || i == 1 || i == 4 || i == 5) ? -size / 2 : size / 2;
+		corners[i][2] = (i == 0 || i == 3 || i == 4 || i == 7) ? -size / 2 : size / 2;
+	}
+	for (i = 0; i < 6; i++) {
+		for (j = 0; j < 4; j++)
+			memcpy(&v[j * 3], corners[faces[i][j]], sizeof(corners[0]));
+		sgQuad(s, normals[i], v);
+	}
+}
+
+//  glutSolidSphere ͬ,  z 
+static void sgSphere(SceneGraph *s, GLfloat radius, int slices, int stacks)
+{
+	for (int j = 0; j < stacks; j++) {
+		GLfloat p0 = 3.14159265f * j / stacks, p1 = 3.14159265f * (j + 1) / stacks;
+		for (int i = 0; i < slices; i++) {
+			GLfloat t0 = 2 * 3.14159265f * i / slices, t1 = 2 * 3.14159265f * (i + 1) / slices;
+			GLfloat n[4][3] = {
+				{ sinf(p0) * cosf(t0), sinf(p0) * sinf(t0), cosf(p0) },
+				{ sinf(p1) * cosf(t0), sinf(p1) * sinf(t0), cosf(p1) },
+				{ sinf(p1) * cosf(t1), sinf(p1) * sinf(t1), cosf(p1) },
+				{ sinf(p0) * cosf(t1), sinf(p0) * sinf(t1), cosf(p0) }
+			};
+			static const int first[3] = { 0, 1, 2 }, second[3] = { 0, 2, 3 };
+			for (int k = 0; k < 3; k++) {
+				// ˻, 
+				if (j < stacks - 1)
+					sgVertex(s, n[first[k]][0] * radius, n[first[k]][1] * radius, n[first[k]][2] * radius,
+						n[first[k]][0], n[first[k]][1], n[first[k]][2]);
+			}
+			for (int k = 0; k < 3; k++) {
+				if (j > 0)
+					sgVertex(s, n[second[k]][0] * radius, n[second[k]][1] * radius, n[second[k]][2] * radius,
+						n[second[k]][0], n[second[k]][1], n[second[k]][2]);
+			}
+		}
+	}
+}
+
+//  gluCylinder ͬ:  +z Ĳ, 
+static void sgCylinder(SceneGraph *s, GLfloat base, GLfloat top, GLfloat height,
+	int slices, int stacks)
+{
+	GLfloat l = sqrtf(height * height + (base - top) * (base - top));
+	GLfloat nz = (base - top) / l, nr = height / l;
+
+	for (int j = 0; j < stacks; j++) {
+		GLfloat z0 = height * j / stacks, z1 = height * (j + 1) / stacks;
+		GLfloat r0 = base + (top - base) * j / stacks, r1 = base + (top - base) * (j + 1) / stacks;
+		for (int i = 0; i < slices; i++) {
+			GLfloat t0 = 2 * 3.14159265f * i / slices, t1 = 2 * 3.14159265f * (i + 1) / slices;
+			GLfloat c0 = cosf(t0), s0 = sinf(t0), c1 = cosf(t1), s1 = sinf(t1);
+			GLfloat v[4][3] = {
+				{ r0 * c0, r0 * s0, z0 }, { r0 * c1, r0 * s1, z0 },
+				{ r1 * c1, r1 * s1, z1 }, { r1 * c0, r1 * s0, z1 }
+			};
+			GLfloat n[4][2] = { { c0, s0 }, { c1, s1 }, { c1, s1 }, { c0, s0 } };
+			static const int order[6] = { 0, 1, 2, 0, 2, 3 };
+			for (int k = 0; k < 6; k++) {
+				const int q = order[k];
+				// ׶˻, 
+				if (r1 == 0.0f && k >= 3)
+					break;
+				sgVertex(s, v[q][0], v[q][1], v[q][2], n[q][0] * nr, n[q][1] * nr, nz);
+			}
+		}
+	}
+}
+
+//  glutSolidCone ͬ:  z = 0,  +z
+static void sgCone(SceneGraph *s, GLfloat base, GLfloat height, int slices, int stacks)
+{
+	sgCylinder(s, base, 0.0f, height, slices, stacks);
+	for (int i = 0; i < slices; i++) {
+		GLfloat t0 = 2 * 3.14159265f * i / slices, t1 = 2 * 3.14159265f * (i + 1) / slices;
+		sgVertex(s, 0, 0, 0, 0, 0, -1);
+		sgVertex(s, base * cosf(t1), base * sinf(t1), 0, 0, 0, -1);
+		sgVertex(s, base * cosf(t0), base * sinf(t0), 0, 0, 0, -1);
+	}
+}
+
+//  glutSolidTorus ͬ,  xy ƽ
+static void sgTorus(SceneGraph *s, GLfloat inner, GLfloat outer, int sides, int rings)
+{
+	for (int i = 0; i < rings; i++) {
+		for (int j = 0; j < sides; j++) {
+			GLfloat n[4][3], v[4][3];
+			for (int k = 0; k < 4; k++) {
+				int a = i + (k == 1 || k == 2), b = j + (k >= 2);
+				GLfloat theta = 2 * 3.14159265f * a / rings, phi = 2 * 3.14159265f * b / sides;
+				n[k][0] = cosf(theta) * cosf(phi);
+				n[k][1] = sinf(theta) * cosf(phi);
+				n[k][2] = sinf(phi);
+				v[k][0] = cosf(theta) * (outer + inner * cosf(phi));
+				v[k][1] = sinf(theta) * (outer + inner * cosf(phi));
+				v[k][2] = inner * sinf(phi);
+			}
+			static const int order[6] = { 0, 1, 2, 0, 2, 3 };
+			for (int k = 0; k < 6; k++)
+				sgVertex(s, v[order[k]][0], v[order[k]][1], v[order[k]][2],
+					n[order[k]][0], n[order[k]][1], n[order[k]][2]);
+		}
+	}
+}
+
+// ʾбе, ÿ֡ǰ
+static void sgList(SceneGraph *s, GLuint list)
+{
+	SgListItem item;
+	item.list = list;
+	item.matrix = s->stack.back();
+	memcpy(item.color, s->color, sizeof(s->color));
+	s->nodes[s->current.back()].lists.push_back(item);
+}
+
+static bool sgBatchLess(const SgBatch &a, const SgBatch &b)
+{
+	return memcmp(a.color, b.color, sizeof(a.color)) < 0;
+}
+
+// ѸڵΰɫηŽһ㻺岢ϴ. ½ȡݴ
+// Ķ, ĴԭĻа
+static void sgLayout(SceneGraph *s)
+{
+	std::vector<GLfloat> vertices;
+
+	for (size_t i = 0; i < s->nodes.size(); i++) {
+		SgNode &n = s->nodes[i];
+		std::sort(n.batches.begin(), n.batches.end(), sgBatchLess);
+		n.first = (GLint)(vertices.size() / SG_STRIDE);
+		for (size_t j = 0; j < n.batches.size(); j++) {
+			SgBatch &b = n.batches[j];
+			if (!b.data.empty()) {
+				b.count = (GLsizei)(b.data.size() / SG_STRIDE);
+				vertices.insert(vertices.end(), b.data.begin(), b.data.end());
+				std::vector<GLfloat>().swap(b.data);
+			}
+			else {
+				vertices.insert(vertices.end(), s->vertices.begin() + b.first * SG_STRIDE,
+					s->vertices.begin() + (b.first + b.count) * SG_STRIDE);
+			}
+			b.first = (GLint)(vertices.size() / SG_STRIDE) - b.count;
+		}
+		n.capacity = (GLsizei)(vertices.size() / SG_STRIDE) - n.first;
+		if (n.capacity < n.reserve) {
+			n.capacity = n.reserve;
+			vertices.resize((n.first + n.capacity) * SG_STRIDE, 0.0f);
+		}
+	}
+	s->vertices.swap(vertices);
+
+	if (s->useBuffer && !s->vertices.empty()) {
+		if (!s->buffer)
+			glGenBuffers(1, &s->buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, s->buffer);
+		glBufferData(GL_ARRAY_BUFFER, s->vertices.size() * sizeof(GLfloat),
+			&s->vertices[0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+// ͼ
+static void sgEnd(SceneGraph *s)
+{
+	s->useBuffer = GLEW_VERSION_1_5 ? true : false;
+	sgLayout(s);
+}
+
+// һڵ, ڵ㲻. ýڵ㲻ӽڵ; ֮д
+// 뽨ͼͬ, ӽڵϵʼ, ɫӰɫʼ
+static void sgBeginRebuild(SceneGraph *s, int node)
+{
+	SgMatrix identity;
+
+	sgIdentity(&identity);
+	s->nodes[node].batches.clear();
+	s->nodes[node].lists.clear();
+	s->stack.assign(1, identity);
+	s->current.assign(1, node);
+	s->depth.clear();
+	s->color[0] = s->color[1] = s->color[2] = 1.0f;
+}
+
+// ŵ¾ֻдϴڵķΧ, 
+static void sgEndRebuild(SceneGraph *s, int node)
+{
+	SgNode &n = s->nodes[node];
+	GLsizei used = 0;
+	GLint next = n.first;
+
+	for (size_t j = 0; j < n.batches.size(); j++)
+		used += (GLsizei)(n.batches[j].data.size() / SG_STRIDE);
+	if (used > n.capacity) {
+		sgLayout(s);
+		return;
+	}
+
+	std::sort(n.batches.begin(), n.batches.end(), sgBatchLess);
+	for (size_t j = 0; j < n.batches.size(); j++) {
+		SgBatch &b = n.batches[j];
+		b.first = next;
+		b.count = (GLsizei)(b.data.size() / SG_STRIDE);
+		std::copy(b.data.begin(), b.data.end(), s->vertices.begin() + next * SG_STRIDE);
+		std::vector<GLfloat>().swap(b.data);
+		next += b.count;
+	}
+
+	if (s->useBuffer && used > 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, s->buffer);
+		glBufferSubData(GL_ARRAY_BUFFER, n.first * SG_STRIDE * sizeof(GLfloat),
+			used * SG_STRIDE * sizeof(GLfloat), &s->vertices[n.first * SG_STRIDE]);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+// ÿ֡
+
+static void sgAnimate(SceneGraph *s, int node, const SgMatrix *m)
+{
+	s->nodes[node].anim = *m;
+}
+
+static void sgNodeColor(SceneGraph *s, int node, GLfloat r, GLfloat g, GLfloat b)
+{
+	SgNode &n = s->nodes[node];
+	for (size_t i = 0; i < n.batches.size(); i++) {
+		n.batches[i].color[0] = r; n.batches[i].color[1] = g; n.batches[i].color[2] = b;
+	}
+	for (size_t i = 0; i < n.lists.size(); i++) {
+		n.lists[i].color[0] = r; n.lists[i].color[1] = g; n.lists[i].color[2] = b;
+	}
+}
+
+// ڵǰģͼ»
+static void sgDraw(SceneGraph *s)
+{
+	// ö㻺ʱָǻڵƫ
+	const GLfloat *base = (s->useBuffer || s->vertices.empty()) ? NULL : &s->vertices[0];
+
+	if (s->useBuffer)
+		glBindBuffer(GL_ARRAY_BUFFER, s->buffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, SG_STRIDE * sizeof(GLfloat), base);
+	glNormalPointer(GL_FLOAT, SG_STRIDE * sizeof(GLfloat), base + 3);
+
+	for (size_t i = 0; i < s->nodes.size(); i++) {
+		SgNode &n = s->nodes[i];
+		if (n.parent >= 0) {
+			sgMultiply(&n.world, &s->nodes[n.parent].world, &n.base);
+			sgMultiply(&n.world, &n.world, &n.anim);
+		}
+
+		glPushMatrix();
+		glMultMatrixf(n.world.m);
+		for (size_t j = 0; j < n.batches.size(); j++) {
+			glColor3fv(n.batches[j].color);
+			glDrawArrays(GL_TRIANGLES, n.batches[j].first, n.batches[j].count);
+		}
+		for (size_t j = 0; j < n.lists.size(); j++) {
+			glPushMatrix();
+			glMultMatrixf(n.lists[j].matrix.m);
+			glColor3fv(n.lists[j].color);
+			glCallList(n.lists[j].list);
+			glPopMatrix();
+		}
+		glPopMatrix();
+	}
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	if (s->useBuffer)
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// ֡ʱԱ: Աģʽÿ 100 ֡ڱģʽģʽ֮л,  100 ֡
+// ӡƽÿ֡ʱ
+
+struct SgStats {
+	bool compare;
+	bool retained;
+	int frames;
+	double time[2];
+	LARGE_INTEGER start;
+};
+
+// ر֡Ƿñģʽ
+static bool sgFrameBegin(SgStats *st)
+{
+	QueryPerformanceCounter(&st->start);
+	if (st->compare)
+		return (st->frames / 100) % 2 == 1;
+	return st->retained;
+}
+
+static void sgFrameEnd(SgStats *st)
+{
+	LARGE_INTEGER end, frequency;
+
+	if (!st->compare)
+		return;
+	glFinish();
+	QueryPerformanceCounter(&end);
+	QueryPerformanceFrequency(&frequency);
+	st->time[(st->frames / 100) % 2] += (double)(end.QuadPart - st->start.QuadPart) / frequency.QuadPart;
+	if (++st->frames == 200) {
+		printf("immediate %.3f ms, retained %.3f ms per frame\n",
+			st->time[0] * 10.0, st->time[1] * 10.0);
+		st->frames = 0;
+		st->time[0] = st->time[1] = 0.0;
+	}
+}
+
+#endif
@@ -11,7 +11,9 @@ Student Name: 
 #include <stdlib.h>
 #include <stdio.h>
 #include <windows.h>
+#include <GL/glew.h>
 #include <GL/glut.h>
+#include "../sceneGraph.h"
 const GLdouble FRUSTDIM = 100.0f;
 GLfloat spherex = -50.0;
 GLfloat conex = -90.0;
@@ -20,6 +22,16 @@ GLfloat cylinderx = -350.0;
 GLfloat torusx = 10;
 GLfloat dodecahedronx = 0.1;
 
+SceneGraph scene;							// ģʽ: ǽʮֻһ
+int sphereNode, coneNode, teapotNode, cylinderNode;	// ÿ֡µĽڵ
+int torusNode;								// ϸıʱؽ
+GLuint teapotList, dodecahedronList;
+GLfloat sceneTorus;							// ͼʱԲϸ
+SgStats stats = { false, true };			// 'r' л/ģʽ, 'c' Ա֡ʱ
+
+void buildScene(void);
+void buildTorus(void);
+
 void init(void) // All Setup For OpenGL Goes Here
 {
 	glEnable(GL_NORMALIZE);		// ӴַŴ䰵
@@ -28,12 +40,11 @@ void init(void) // All Setup For OpenGL Goes Here
 	glEnable(GL_LIGHT0);
 	glFrontFace(GL_CCW);
 	glEnable(GL_COLOR_MATERIAL);
-	
+	buildScene();
 }
 
-void display(void) // Here's Where We Do All The Drawing
+void lighting(void)	// պͲ
 {
-	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);	//displayзbug
 	// TODO:
 	// Place light source here
 	GLfloat lightpos[] = { 50.f, 50.f, -320.f, 1.f };
@@ -54,7 +65,10 @@ void display(void) // Here's Where We Do All The Drawing
 	//glMaterialfv(GL_FRONT, GL_SPECULAR, mat_specular);
 	//glMaterialfv(GL_FRONT, GL_SHININESS, high_shininess);
 	glMaterialfv(GL_FRONT, GL_EMISSION, high_mat);
-	
+}
+
+void drawImmediate(void)	// ģʽ, ÿ֡»
+{
 	// TODO:
 	// Draw walls and objects here
 	static GLfloat wall_mat[] = { 1.f, 1.f, 1.f, 1.f };
@@ -149,9 +163,142 @@ void display(void) // Here's Where We Do All The Drawing
 	glRotated(20, 3, 5, 0);
 	glutSolidDodecahedron();
 	glPopMatrix();
+}
+
+void buildScene(void)	//  drawImmediate ͬĳ, ɳͼ
+{
+	static const GLfloat walls[5][12] = {
+		{ -100.f, -100.f, -320.f, 100.f, -100.f, -320.f, 100.f, -100.f, -520.f, -100.f, -100.f, -520.f },	// floor
+		{ -100.f, -100.f, -320.f, -100.f, -100.f, -520.f, -100.f, 100.f, -520.f, -100.f, 100.f, -320.f },	// left wall
+		{ 100.f, -100.f, -320.f, 100.f, 100.f, -320.f, 100.f, 100.f, -520.f, 100.f, -100.f, -520.f },		// right wall
+		{ -100.f, 100.f, -320.f, -100.f, 100.f, -520.f, 100.f, 100.f, -520.f, 100.f, 100.f, -320.f },		// ceiling
+		{ -100.f, -100.f, -520.f, 100.f, -100.f, -520.f, 100.f, 100.f, -520.f, -100.f, 100.f, -520.f }		// back wall
+	};
+	static const GLfloat normals[5][3] = {
+		{ 0.f, 1.f, 0.f }, { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }
+	};
+	SceneGraph *s = &scene;
+
+	if (!teapotList) {					// GLUT Ĳʮò, ʾб
+		teapotList = glGenLists(2);
+		dodecahedronList = teapotList + 1;
+		glNewList(teapotList, GL_COMPILE);
+		glutSolidTeapot(1.0);
+		glEndList();
+		glNewList(dodecahedronList, GL_COMPILE);
+		glutSolidDodecahedron();
+		glEndList();
+	}
+
+	sgBegin(s);
+	sgColor3f(s, 1.f, 1.f, 1.f);
+	for (int i = 0; i < 5; i++)
+		sgQuad(s, normals[i], walls[i]);
+
+	// sphere, ƽ updateScene 
+	sgColor3f(s, 1.0, 0.0, 0.0);
+	sphereNode = sgBeginNode(s);
+		sgSphere(s, 20.0, 50, 50);
+	sgEndNode(s);
+
+	// cone, ת updateScene 
+	sgColor3f(s, 0.0, 1.0, 0.0);
+	sgPushMatrix(s);
+	sgTranslatef(s, 0.0, -50.0, -370.0);
+	coneNode = sgBeginNode(s);
+		sgCone(s, 15.0, 40.0, 40, 50);
+	sgEndNode(s);
+	sgPopMatrix(s);
+
+	// teapot,  updateScene 
+	sgColor3f(s, 0.0, 0.0, 1.0);
+	sgPushMatrix(s);
+	sgTranslatef(s, 50.0, -30.0, -350.0);
+	teapotNode = sgBeginNode(s);
+		sgList(s, teapotList);
+	sgEndNode(s);
+	sgPopMatrix(s);
+
+	// cylinder, ƽ updateScene 
+	sgColor3f(s, 1.0, 1.0, 0.0);
+	cylinderNode = sgBeginNode(s);
+		sgRotatef(s, 50.0, 2.0, 3.0, 0.0);
+		sgCube(s, 30);
+	sgEndNode(s);
+
+	// torus, ϸıʱֻؽڵ
+	sgPushMatrix(s);
+	sgTranslatef(s, 0.0, 40.0, -350.0);
+	sgRotatef(s, 40, 2.0, 3.0, 0.0);
+	torusNode = sgBeginNode(s);
+		sgReserve(s, 6 * 50 * 50);		// idle ϸΪ 50
+		buildTorus();
+	sgEndNode(s);
+	sgPopMatrix(s);
+
+	// dodecahedron
+	sgColor3f(s, 1.0, 1.0, 1.0);
+	sgPushMatrix(s);
+	sgTranslatef(s, 50.0, 40.0, -350.0);
+	sgScalef(s, 13.0, 13.0, 13.0);
+	sgRotatef(s, 20, 3, 5, 0);
+	sgList(s, dodecahedronList);
+	sgPopMatrix(s);
+	sgEnd(s);
+}
+
+void buildTorus(void)	// Բڵ, ͼؽʱ
+{
+	sgColor3f(&scene, 1.0, 0.0, 1.0);
+	sgTorus(&scene, 8.0, 15.0, (int)torusx, (int)torusx);
+	sceneTorus = torusx;
+}
+
+void updateScene(void)	// ֻ¶ڵ
+{
+	SgMatrix m;
+
+	if (torusx != sceneTorus) {
+		sgBeginRebuild(&scene, torusNode);
+		buildTorus();
+		sgEndRebuild(&scene, torusNode);
+	}
+
+	sgIdentity(&m);
+	sgTranslate(&m, spherex, -30.0, -350.0);
+	sgAnimate(&scene, sphereNode, &m);
+	sgIdentity(&m);
+	sgRotate(&m, conex, 1.0, 0.0, 0.0);
+	sgAnimate(&scene, coneNode, &m);
+	sgIdentity(&m);
+	sgScale(&m, teapotx, teapotx, teapotx);
+	sgAnimate(&scene, teapotNode, &m);
+	sgIdentity(&m);
+	sgTranslate(&m, -50.0, 40.0, cylinderx);
+	sgAnimate(&scene, cylinderNode, &m);
+}
+
+void display(void) // Here's Where We Do All The Drawing
+{
+	static GLfloat lightx = -1.0;	// ģʽ¹ֻڷ仯ʱ
+	bool retained = sgFrameBegin(&stats);
+
+	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);	//displayзbug
+	if (!retained || dodecahedronx != lightx) {
+		lighting();
+		lightx = dodecahedronx;
+	}
+
+	if (retained) {
+		updateScene();
+		sgDraw(&scene);
+	}
+	else {
+		drawImmediate();
+	}
 
-	
 	glFlush();
+	sgFrameEnd(&stats);
 	glutSwapBuffers();
 	glutPostRedisplay();
 }
@@ -175,6 +322,8 @@ void help() {
 	printf("[4]\tcylinder translating\n");
 	printf("[5]\ttorus transforming\n");
 	printf("[6]\tlight shining\n");
+	printf("[r]\tretained/immediate mode\n");
+	printf("[c]\tcompare frame time\n");
 }
 
 int option = 0;
@@ -223,6 +372,16 @@ void keyboard(unsigned char key, int x, int y) // Handle the keyboard events her
 		printf("light shining\n");
 		option = 7;
 		break;
+	case'r':
+		stats.retained = !stats.retained;
+		printf(stats.retained ? "retained mode\n" : "immediate mode\n");
+		break;
+	case'c':
+		stats.compare = !stats.compare;
+		stats.frames = 0;
+		stats.time[0] = stats.time[1] = 0.0;
+		printf(stats.compare ? "compare frame time\n" : "compare off\n");
+		break;
 	default:
 		printf("error\ttry 'h' for help\n");
 		break;
@@ -304,6 +463,7 @@ void main(int argc, char** argv)
 	glutInitWindowSize(512, 512);
 	glutInitWindowPosition(100, 100);
 	glutCreateWindow("Assignment 1");
+	glewInit();
 	help();
 
 	init();	/*not GLUT call, initialize several parameters */
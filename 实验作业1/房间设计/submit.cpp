@@ -11,7 +11,9 @@ Student Name: 
 #include <stdlib.h>
 #include<stdio.h>
 #include<windows.h>
+#include <GL/glew.h>
 #include <GL/glut.h>
+#include "../sceneGraph.h"
 const GLdouble FRUSTDIM = 100.0f;
 GLfloat door = 0.0;
 GLfloat sticker = 45.0;
@@ -23,6 +25,13 @@ int doorOpen = 0;
 float l1 = 0.25;
 float ll = 1.0;
 
+SceneGraph scene;							// ģʽ: ֻ̬һ
+int xiaomNode, armNode[2], doorNode, screenNode;	// ÿ֡µĽڵ
+GLuint teapotList;
+SgStats stats = { false, true };			// 'r' л/ģʽ, 'c' Ա֡ʱ
+
+void buildScene(void);
+
 void init(void) // All Setup For OpenGL Goes Here
 {
 	glEnable(GL_NORMALIZE);		// ӴַŴ䰵
@@ -32,13 +41,11 @@ void init(void) // All Setup For OpenGL Goes Here
 	glEnable(GL_LIGHT1);
 	glFrontFace(GL_CCW);
 	glEnable(GL_COLOR_MATERIAL);
+	buildScene();
 }
 
-void display(void) // Here's Where We Do All The Drawing
+void lighting(void)	// պͲ
 {
-	glPushMatrix();
-	//glClearColor(1.0, 1.0, 1.0, 0.0);
-	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);	//displayз򶯻bug
 	// TODO:
 	// Place light source here
 	GLfloat lightpos[] = { 0.f, 100.f, -450.f, ll };			// 趯
@@ -66,8 +73,10 @@ void display(void) // Here's Where We Do All The Drawing
 	glMaterialfv(GL_FRONT, GL_SPECULAR, mat_specular);
 	glMaterialfv(GL_FRONT, GL_SHININESS, high_shininess);
 	glMaterialfv(GL_FRONT, GL_EMISSION, high_mat);
+}
 
-	glTranslatef(0.0, 0.0, -300.0);
+void drawImmediate(void)	// ģʽ, ÿ֡»
+{
 	// TODO:
 	// Draw walls and objects here
 	glPushMatrix();
@@ -323,18 +332,261 @@ void display(void) // Here's Where We Do All The Drawing
 			GLUquadricObj *g_text;
 			g_text = gluNewQuadric();
 			gluCylinder(g_text, 10.0, 10.0, 30.0, 50, 4);
+			gluDeleteQuadric(g_text);
 			glRotatef(90.0, 1.0, 0.0, 0.0);
 			glTranslatef(0.0, 30.0, 0.0);
 			glScalef(35.0, 5.0, 35.0);
 			glutSolidCube(1.0);
 		glPopMatrix();
 	glPopMatrix();
+}
+
+void buildScene(void)	//  drawImmediate ͬĳ, ɳͼ
+{
+	static const GLfloat back[] = { 100.0, 100.0, -300.0, -100.0, 100.0, -300.0, -100.0, -100.0, -300.0, 100.0, -100.0, -300.0 };
+	static const GLfloat bottom[] = { 100.0, -100.0, 0.0, 100.0, -100.0, -300.0, -100.0, -100.0, -300.0, -100.0, -100.0, 0.0 };
+	static const GLfloat top[] = { 100.0, 100.0, 0.0, -100.0, 100.0, 0.0, -100.0, 100.0, -300.0, 100.0, 100.0, -300.0 };
+	static const GLfloat left[] = { -100.0, -100.0, 0.0, -100.0, -100.0, -300.0, -100.0, 100.0, -300.0, -100.0, 100.0, 0.0 };
+	static const GLfloat right[] = { 100.0, -100.0, 0.0, 100.0, 100.0, 0.0, 100.0, 100.0, -300.0, 100.0, -100.0, -300.0 };
+	static const GLfloat backn[] = { 0.0, 0.0, 1.0 }, bottomn[] = { 0.0, 1.0, 0.0 }, topn[] = { 0.0, -1.0, 0.0 };
+	static const GLfloat leftn[] = { 1.0, 0.0, 0.0 }, rightn[] = { -1.0, 0.0, 0.0 };
+	static const GLfloat blanket[] = { 25.0, 0.0, 35.0, 25.0, 0.0, -35.0, -25.0, 0.0, -35.0, -25.0, 0.0, 35.0 };
+	static const GLfloat outdoor[] = { 0.0, -50.0, 35.0, 0.0, 50.0, 35.0, 0.0, 50.0, -35.0, 0.0, -50.0, -35.0 };
+	static const GLfloat stickerq[] = { 0.0, 15.0, 15.0, 0.0, 15.0, -15.0, 0.0, -15.0, -15.0, 0.0, -15.0, 15.0 };
+	SceneGraph *s = &scene;
+	int i;
+
+	if (!teapotList) {					// GLUT Ĳò, ʾб
+		teapotList = glGenLists(1);
+		glNewList(teapotList, GL_COMPILE);
+		glutSolidTeapot(5.0);
+		glEndList();
+	}
+
+	sgBegin(s);
+	// walls
+	sgColor3f(s, 0.5, 0.6, 0.6);
+	sgQuad(s, backn, back);
+	sgColor3f(s, 0.5, 0.5, 0.5);
+	sgQuad(s, bottomn, bottom);
+	sgColor3f(s, 0.7, 0.7, 0.9);
+	sgQuad(s, topn, top);
+	sgColor3f(s, 0.5, 0.6, 0.6);
+	sgQuad(s, leftn, left);
+	sgQuad(s, rightn, right);
+
+	// bed
+	sgPushMatrix(s);
+		sgColor3f(s, 0.7, 0.7, 0.5);
+		sgTranslatef(s, -65.0, 20.0, -175.0);
+		sgScalef(s, 3.5, 1.0, 12.5);
+		sgCube(s, 20.0);
+	sgPopMatrix(s);
+
+	// wardrobe
+	sgPushMatrix(s);
+		sgColor3f(s, 0.6, 0.4, 0.2);
+		sgTranslatef(s, -65.0, -45.0, -175.0);
+		sgScalef(s, 14.0, 22.0, 50.0);
+		sgCube(s, 5.0);
+	sgPopMatrix(s);
+
+	// mirror
+	sgPushMatrix(s);
+		sgTranslatef(s, -65.0, -45.0, -49.0);
+		sgColor3f(s, 0.79, 0.82, 0.98);
+		sgScalef(s, 60.0, 100.0, 2.0);
+		sgCube(s, 1.0);
+	sgPopMatrix(s);
+
+	// xiaoming, ƽ updateScene 
+	xiaomNode = sgBeginNode(s);
+		// arms, ת updateScene 
+		sgColor3f(s, 0.9, 0.7, 0.6);
+		for (i = 0; i < 2; i++) {
+			sgPushMatrix(s);
+				sgTranslatef(s, i ? 12.5 : -12.5, -25.0, 0.0);
+				armNode[i] = sgBeginNode(s);
+					sgTranslatef(s, 0.0, -15.0, 0.0);
+					sgScalef(s, 5.0, 30.0, 5.0);
+					sgCube(s, 1.0);
+				sgEndNode(s);
+			sgPopMatrix(s);
+		}
+		// head
+		sgTranslatef(s, 0.0, -10.0, 0.0);
+		sgSphere(s, 8.0, 50, 50);
+		// neck
+		sgTranslatef(s, 0.0, -10.0, 0.0);
+		sgScalef(s, 8.0, 10.0, 10.0);
+		sgCube(s, 1.0);
+		// body
+		sgColor3f(s, 0.2, 0.2, 0.2);
+		sgScalef(s, 0.125, 0.1, 0.1);
+		sgTranslatef(s, 0.0, -18.0, 0.0);
+		sgScalef(s, 25.0, 35.0, 15.0);
+		sgCube(s, 1.0);
+		// legs
+		sgColor3f(s, 0.3, 0.3, 0.3);
+		sgScalef(s, 1.0 / 25.0, 1.0 / 35.0, 1.0 / 15.0);
+		sgTranslatef(s, -9.0, -35.0, 0.0);
+		sgScalef(s, 7.0, 35.0, 15.0);
+		sgCube(s, 1.0);
+		sgScalef(s, 1.0 / 7.0, 1.0 / 35.0, 1.0 / 15.0);
+		sgTranslatef(s, 18.0, 0.0, 0.0);
+		sgScalef(s, 7.0, 35.0, 15.0);
+		sgCube(s, 1.0);
+	sgEndNode(s);
+
+	// stairs
+	sgPushMatrix(s);
+		sgTranslatef(s, -30.0, -100.0, -275.0);
+		sgColor3f(s, 0.3, 0.3, 0.3);
+		for (i = 0; i < 5; i++) {
+			sgPushMatrix(s);
+				sgTranslatef(s, 65.0 - 11.0 * i, 13.0 + 26.0 * i, -13.0);
+				sgScalef(s, 65.0 - 11.0 * i, 13.0, 13.0);
+				sgCube(s, 2.0);
+			sgPopMatrix(s);
+		}
+	sgPopMatrix(s);
+
+	// top light
+	sgPushMatrix(s);
+		sgColor3f(s, 1.0, 1.0, 0.5);
+		sgTranslatef(s, 0.0, 94.0, -150.0);
+		sgScalef(s, 80.0, 4.0, 80.0);
+		sgCube(s, 1.0);
+	sgPopMatrix(s);
+	sgPushMatrix(s);
+		sgColor3f(s, 0.6, 0.5, 0.5);
+		sgTranslatef(s, 0.0, 99.0, -150.0);
+		sgScalef(s, 100.0, 2.0, 100.0);
+		sgCube(s, 1.0);
+	sgPopMatrix(s);
+
+	// door, ̺, ֽķ߰˳
+	sgPushMatrix(s);
+		// door blanket
+		sgPushMatrix(s);
+			sgColor3f(s, 0.4, 0.12, 0.5);
+			sgTranslatef(s, 75.0, -99.9, -40.0);
+			sgQuad(s, NULL, blanket);
+		sgPopMatrix(s);
+		// outdoor
+		sgTranslatef(s, 99.9, -50.0, -40.0);
+		sgColor3f(s, 0.0, 0.0, 0.0);
+		sgQuad(s, NULL, outdoor);
+		// the door, ת updateScene 
+		sgColor3f(s, 0.8, 0.6, 0.4);
+		sgTranslatef(s, 0.0, 0.0, -35.0);
+		doorNode = sgBeginNode(s);
+			sgTranslatef(s, 0.0, 0.0, 35.0);
+			sgScalef(s, 6.0, 100.0, 70.0);
+			sgCube(s, 1.0);
+			// cat eye
+			sgScalef(s, 1.0 / 6.0, 0.01, 1.0 / 70.0);
+			sgTranslatef(s, 4.0, 30.0, 0.0);
+			sgColor3f(s, 0.1, 0.1, 0.1);
+			sgSphere(s, 1.0, 10, 10);
+
+			sgTranslatef(s, -8.0, 0.0, 0.0);
+			sgSphere(s, 1.0, 10, 10);
+			sgTranslatef(s, 12.0, 0.0, 0.0);
+
+			// door sticker
+			sgTranslatef(s, -4.5, -35.0, 0.0);
+			sgColor3f(s, 1.0, 0.0, 0.0);
+			sgRotatef(s, sticker, 1.0, 0.0, 0.0);
+			sgQuad(s, NULL, stickerq);
+		sgEndNode(s);
+	sgPopMatrix(s);
+
+	// desk & computer & seat & teapot
+	sgPushMatrix(s);
+		// desk
+		sgColor3f(s, 0.22, 0.52, 1.0);
+		sgTranslatef(s, 20.0, -50.0, -225.0);
+		sgScalef(s, 80.0, 4.0, 50.0);
+		sgCube(s, 1.0);
+		sgScalef(s, 1.0 / 60.0, 0.25, 0.02);
+		// computer
+		sgTranslatef(s, -5.0, 2.0, 0.0);
+		sgColor3f(s, 0.0, 0.0, 0.0);
+		sgScalef(s, 40.0, 2.0, 30.0);
+		sgCube(s, 1.0);
+		sgScalef(s, 1.0 / 40.0, 0.5, 1.0 / 30.0);
+		sgTranslatef(s, 0.0, 15.0, -20.0);
+		sgScalef(s, 40.0, 30.0, 2.0);
+		screenNode = sgBeginNode(s);		// ɫ updateScene 
+			sgCube(s, 1.0);
+		sgEndNode(s);
+		sgScalef(s, 1.0 / 40.0, 1.0 / 30.0, 0.5);
+		// teapot
+		sgTranslatef(s, 27.0, -10.0, 20.0);
+		sgColor3f(s, 0.5, 0.3, 0.1);
+		sgList(s, teapotList);
+		// seat
+		sgTranslatef(s, -27.0, -50.0, 60.0);
+		sgColor3f(s, 1.0, 0.5, 0.13);
+		sgRotatef(s, -90.0, 1.0, 0.0, 0.0);
+		sgCylinder(s, 10.0, 10.0, 30.0, 50, 4);
+		sgRotatef(s, 90.0, 1.0, 0.0, 0.0);
+		sgTranslatef(s, 0.0, 30.0, 0.0);
+		sgScalef(s, 35.0, 5.0, 35.0);
+		sgCube(s, 1.0);
+	sgPopMatrix(s);
+	sgEnd(s);
+}
+
+void updateScene(void)	// ֻ¶ڵ
+{
+	SgMatrix m;
+
+	sgIdentity(&m);
+	sgTranslate(&m, xiaom, -10.0, -30.0);
+	sgAnimate(&scene, xiaomNode, &m);
+	sgIdentity(&m);
+	sgRotate(&m, arm, 0.0, 0.0, -1.0);
+	sgAnimate(&scene, armNode[0], &m);
+	sgIdentity(&m);
+	sgRotate(&m, arm, 0.0, 0.0, 1.0);
+	sgAnimate(&scene, armNode[1], &m);
+	sgIdentity(&m);
+	sgRotate(&m, door, 0.0, -1.0, 0.0);
+	sgAnimate(&scene, doorNode, &m);
+	sgNodeColor(&scene, screenNode, 0.0, 0.0, screen);
+}
+
+void display(void) // Here's Where We Do All The Drawing
+{
+	static float lightl1 = -1.0, lightll = -1.0;	// ģʽ¹ֻڿصʱ
+	bool retained = sgFrameBegin(&stats);
+
+	glPushMatrix();
+	//glClearColor(1.0, 1.0, 1.0, 0.0);
+	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);	//displayз򶯻bug
+	if (!retained || l1 != lightl1 || ll != lightll) {
+		lighting();
+		lightl1 = l1;
+		lightll = ll;
+	}
+
+	glTranslatef(0.0, 0.0, -300.0);
+	if (retained) {
+		updateScene();
+		sgDraw(&scene);
+	}
+	else {
+		drawImmediate();
+	}
 
 	// TODO:
 	// Add animation here
 	//glLoadIdentity();
 	glPopMatrix();
 	glFlush();
+	sgFrameEnd(&stats);
 	glutSwapBuffers();
 }
 
@@ -399,6 +651,16 @@ void keyboard(unsigned char key, int x, int y) // Handle the keyboard events her
 		printf("turn off the light\n");
 		option = 10;
 		break;
+	case'r':
+		stats.retained = !stats.retained;
+		printf(stats.retained ? "retained mode\n" : "immediate mode\n");
+		break;
+	case'c':
+		stats.compare = !stats.compare;
+		stats.frames = 0;
+		stats.time[0] = stats.time[1] = 0.0;
+		printf(stats.compare ? "compare frame time\n" : "compare off\n");
+		break;
 	default:
 		printf("error\n");
 	}
@@ -487,6 +749,7 @@ void main(int argc, char** argv)
 	glutInitWindowSize(600, 600);
 	glutInitWindowPosition(100, 100);
 	glutCreateWindow("Assignment 1");			// ޸bugcreateWindowǰӦúôڴСλ
+	glewInit();
 
 	init();	/*not GLUT call, initialize several parameters */
 